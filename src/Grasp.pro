@@ -19,6 +19,12 @@ QMAKE_CXXFLAGS += -DUSE_QGV
 message("Building without QGV support")
 }
 
+equals(USE_ZLIB,"yes") {
+message("Building with zlib support (compressed VCD traces)")
+LIBS += -lz
+QMAKE_CXXFLAGS += -DUSE_ZLIB
+}
+
 
 !include(./GraphViz.pri) { error("Cannot open GraphViz.pri file") }
 
@@ -33,7 +39,33 @@ HEADERS += include/nlohmann_json.h \
            model.h  \
            commandExec.h \
            compiler.h \
+           compilerSession.h \
+           compilerPool.h \
            fragmentChecker.h \
+           fragmentCache.h \
+           fragmentValidator.h \
+           simulator.h \
+           vcdWriter.h \
+           vcdIndex.h \
+           vcdCheckpoints.h \
+           sweepRunner.h \
+           simSnapshot.h \
+           simProfile.h \
+           simHistory.h \
+           slicedSimulator.h \
+           clusterScheduler.h \
+           explorer.h \
+           traceLog.h \
+           traceReplay.h \
+           replayAnimation.h \
+           batch.h \
+           waveformViewer.h \
+           bytecode.h \
+           fsmTable.h \
+           compiledModel.h \
+           expr.h \
+           fragmentParser.h \
+           nativeChecker.h \
            dynamicPanel.h \
            stateValuations.h \
            stateProperties.h \
@@ -43,6 +75,7 @@ HEADERS += include/nlohmann_json.h \
            iovPanel.h \
            modelPanel.h \
            stimulus.h \
+           stimulusReader.h \
            stimuli.h \
            command.h \
            imageviewer.h \
@@ -63,7 +96,33 @@ SOURCES += transition.cpp \
            model.cpp \
            commandExec.cpp \
            compiler.cpp \
+           compilerSession.cpp \
+           compilerPool.cpp \
            fragmentChecker.cpp \
+           fragmentCache.cpp \
+           fragmentValidator.cpp \
+           simulator.cpp \
+           vcdWriter.cpp \
+           vcdIndex.cpp \
+           vcdCheckpoints.cpp \
+           sweepRunner.cpp \
+           simSnapshot.cpp \
+           simProfile.cpp \
+           simHistory.cpp \
+           slicedSimulator.cpp \
+           clusterScheduler.cpp \
+           explorer.cpp \
+           traceLog.cpp \
+           traceReplay.cpp \
+           replayAnimation.cpp \
+           batch.cpp \
+           waveformViewer.cpp \
+           bytecode.cpp \
+           fsmTable.cpp \
+           compiledModel.cpp \
+           expr.cpp \
+           fragmentParser.cpp \
+           nativeChecker.cpp \
            dynamicPanel.cpp \
            stateValuations.cpp \
            stateProperties.cpp \
@@ -73,6 +132,7 @@ SOURCES += transition.cpp \
            iovPanel.cpp \
            modelPanel.cpp \
            stimulus.cpp \
+           stimulusReader.cpp \
            stimuli.cpp \
            command.cpp \
            syntaxHighlighters.cpp \
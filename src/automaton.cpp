@@ -16,7 +16,9 @@
 #include "transition.h"
 #include "stateProperties.h"
 #include "fragmentChecker.h"
+#include "fragmentParser.h"
 #include "transitionProperties.h"
+#include "simProfile.h"
 #include "include/nlohmann_json.h"
 #include <QMessageBox>
 #include <QInputDialog>
@@ -25,6 +27,7 @@
 #include <QGraphicsSceneMouseEvent>
 #include <QFile>
 #include <QTextStream>
+#include <QSet>
 #include <QDebug>
 #include <QGuiApplication>
 #ifdef USE_QGV
@@ -69,10 +72,11 @@ Automaton::Automaton(
       addTransition(transition);
       transition->updatePosition();
       }
-    Q_ASSERT(Globals::mainWindow);
-    connect(this, SIGNAL(modelModified()), Globals::mainWindow, SLOT(modelModified()));
-    connect(this, SIGNAL(mouseEnter()), Globals::mainWindow, SLOT(updateCursor()));
-    connect(this, SIGNAL(mouseLeave()), Globals::mainWindow, SLOT(resetCursor()));
+    if ( Globals::mainWindow ) { // NULL in batch mode
+      connect(this, SIGNAL(modelModified()), Globals::mainWindow, SLOT(modelModified()));
+      connect(this, SIGNAL(mouseEnter()), Globals::mainWindow, SLOT(updateCursor()));
+      connect(this, SIGNAL(mouseLeave()), Globals::mainWindow, SLOT(resetCursor()));
+      }
 }
 
 Automaton::Automaton(Model *model, QWidget *parent)
@@ -263,6 +267,39 @@ QStringList Automaton::getVarNames()
   return r;
 }
 
+// Heatmap of a simulation profile: the color of each state is given by the share of the time spent in
+// it, the color and width of each transition by the number of times it was taken (relative to the most
+// taken one in the model). Transitions whose label has changed since the simulation are left unshaded
+
+void Automaton::showProfile(const SimProfile& profile)
+{
+  hideProfile();
+  const SimProfile::Fsm *f = profile.fsm(name);
+  if ( ! f ) return;
+  foreach ( const SimProfile::StateStats& s, f->states ) {
+    State *state = getState(s.name);
+    if ( ! state || profile.duration <= 0 ) continue;
+    double share = double(s.time) / profile.duration;
+    state->setHeat(share, QString("%1% of the time, entered %2 time(s)").arg(100*share, 0, 'f', 1).arg(s.entered));
+    }
+  qint64 max = profile.maxFired();
+  int k = 0;
+  foreach ( Transition *t, transitions() ) {
+    if ( t->isInitial() ) continue;
+    if ( k >= f->transitions.length() ) break;
+    const SimProfile::TransitionStats& s = f->transitions.at(k++);
+    if ( s.label != t->toString() ) continue;
+    t->setHeat(max > 0 ? double(s.fired) / max : 0,
+               QString("taken %1 time(s), guard evaluated %2 time(s), false %3 time(s)").arg(s.fired).arg(s.tried).arg(s.failed));
+    }
+}
+
+void Automaton::hideProfile()
+{
+  foreach ( State *s, states() ) s->setHeat(-1);
+  foreach ( Transition *t, transitions() ) t->setHeat(-1);
+}
+
 bool Automaton::hasPseudoState()
 {
   foreach ( State* s, states() )
@@ -507,7 +544,7 @@ bool Automaton::isItemChange(int type)
 
 void Automaton::report_error(QString msg)
 {
-  QMessageBox::warning(Globals::mainWindow, "", msg);
+  Globals::warning("", msg);
 }
 
 void Automaton::check_state(State *s)
@@ -527,28 +564,70 @@ bool Automaton::check_transition(Transition *t, QList<Iov*>& global_ios)
       return false;
       }
     }
-  // TODO: following checks should be shared with those performed by the [transitionProperties] class
-  FragmentChecker checker(Globals::compiler,this,Globals::mainWindow);
-  if ( ! t->isInitial() ) {
-    foreach ( QString guard, t->getGuards()) {
-      if ( ! checker.check_guard(guard) ) {
-        QStringList errors = checker.getErrors();
-        report_error("Illegal guard: \"" + guard + "\"\n" + errors.join("\n"));
-        return false;
-        }
-      }
-    foreach ( QString action, t->getActions()) {
-      if ( ! checker.check_action(action) ) {
-        QStringList errors = checker.getErrors();
-        report_error("Illegal action: \"" + action + "\"\n" + errors.join("\n"));
-        return false;
-        }
+  // Guards and actions are checked separately, in a single batch (see [fragments] below)
+  return true;
+}
+
+QList<quint64> Automaton::contextRevisions()
+{
+  QList<quint64> r;
+  for ( Iov *io : enclosingModel()->getIos() ) r.append(io->getRevision());
+  for ( Iov *io : vars ) r.append(io->getRevision());
+  return r;
+}
+
+// When [changedOnly] is true, the fragments of the states and transitions which have not been modified
+// since they last passed a check (see [setChecked]) are skipped, unless the IO context has changed
+
+QList<FragmentChecker::Fragment> Automaton::fragments(bool changedOnly)
+{
+  QList<FragmentChecker::Fragment> r;
+  if ( changedOnly && contextRevisions() != checkedContext ) changedOnly = false;
+  for ( State *s : states() ) {
+    if ( s->isPseudo() ) continue;
+    if ( changedOnly && checkedRevisions.value(s, 0) == s->getRevision() ) continue;
+    foreach ( QString valuation, s->getAttrs() )
+      r.append(FragmentChecker::Fragment(this, "sval", valuation, name + ", state " + s->getId(), s, s->getRevision()));
+    }
+  for ( Transition *t : transitions() ) {
+    if ( changedOnly && checkedRevisions.value(t, 0) == t->getRevision() ) continue;
+    QString origin = name + ", transition " + t->toString();
+    if ( ! t->isInitial() ) {
+      foreach ( QString guard, t->getGuards() )
+        r.append(FragmentChecker::Fragment(this, "guard", guard, origin, t, t->getRevision()));
       }
+    foreach ( QString action, t->getActions() )
+      r.append(FragmentChecker::Fragment(this, "action", action, origin, t, t->getRevision()));
     }
-  return true;
+  return r;
+}
+
+// Records the states and transitions whose fragments have all been accepted
+
+void Automaton::setChecked(const QList<FragmentChecker::Fragment>& fragments)
+{
+  QList<quint64> context = contextRevisions();
+  if ( context != checkedContext ) {
+    checkedRevisions.clear();
+    checkedContext = context;
+    }
+  QHash<QGraphicsItem*,quint64> passed;
+  QSet<QGraphicsItem*> failed;
+  for ( const FragmentChecker::Fragment& f : fragments ) {
+    if ( f.automaton != this || ! f.item ) continue;
+    if ( f.errors.isEmpty() ) passed.insert(f.item, f.revision);
+    else failed.insert(f.item);
+    }
+  QHash<QGraphicsItem*,quint64> r;
+  for ( QGraphicsItem *item : items() ) { // Forget deleted items
+    if ( failed.contains(item) ) continue;
+    if ( passed.contains(item) ) r.insert(item, passed.value(item));
+    else if ( checkedRevisions.contains(item) ) r.insert(item, checkedRevisions.value(item));
+    }
+  checkedRevisions = r;
 }
 
-bool Automaton::check(QList<Iov*>& global_ios)
+bool Automaton::check(QList<Iov*>& global_ios, bool withFragments)
 {
   if ( name.isEmpty() ) {
     report_error("No name specified for automaton");
@@ -556,6 +635,13 @@ bool Automaton::check(QList<Iov*>& global_ios)
     }
   for ( Transition *t : transitions() ) 
     if ( ! check_transition(t, global_ios) ) return false;
+  if ( withFragments ) {
+    QList<FragmentChecker::Fragment> frags = fragments();
+    if ( ! FragmentChecker::check_batch(Globals::compiler, frags) ) {
+      report_error(FragmentChecker::errorReport(frags));
+      return false;
+      }
+    }
   return true;
 }
 
@@ -635,7 +721,7 @@ void Automaton::toJson(nlohmann::json& json_top)
     for ( const Iov* io: this->vars ) {
       nlohmann::json json;
       if ( io->name == "" ) {
-        QMessageBox::warning(Globals::mainWindow, "Warning", tr("Var #%1").arg(cnt) + " has no name. Ignoring it");
+        Globals::warning("Warning", tr("Var #%1").arg(cnt) + " has no name. Ignoring it");
         continue;
         }
       json["name"] = io->name.toStdString(); 
@@ -802,22 +888,42 @@ QString stringOfIoKind(Iov::IoKind k)
 }
 
 
-// QList<Iov*> getActualIos(QList<Iov*> global_ios)
-// // Extract, from the list [global_ios] those used in the guards and actions
-// {
-//   QList<Iov*> result;
-//   for ( Transition* transition : transitions() ) {
-//   }
-// }
+void Automaton::rwSets(QSet<QString>& rd, QSet<QString>& wr)
+{
+  for ( State *s : states() ) {
+    if ( s->isPseudo() ) continue;
+    foreach ( QString valuation, s->getAttrs() )
+      FragmentParser::rwSets("sval", valuation, rd, wr);
+    }
+  for ( Transition *t : transitions() ) {
+    if ( ! t->isInitial() ) {
+      rd.insert(t->getEvent());
+      foreach ( QString guard, t->getGuards() )
+        FragmentParser::rwSets("guard", guard, rd, wr);
+      }
+    foreach ( QString action, t->getActions() )
+      FragmentParser::rwSets("action", action, rd, wr);
+    }
+}
+
+QList<Iov*> Automaton::actualIos(QList<Iov*>& global_ios)
+{
+  // Extract, from the list [global_ios] those used by the transitions and states, keeping their order
+  QSet<QString> rd, wr;
+  rwSets(rd, wr);
+  QList<Iov*> result;
+  for ( Iov* io : global_ios ) 
+    if ( rd.contains(io->name) || wr.contains(io->name) ) result.append(io);
+  return result;
+}
 
 void Automaton::exportRfsmInstance(QTextStream& os, QList<Iov*>& global_ios)
 {
-    // TO FIX : not all global IOs should be used as instance parameters
-    // Each instance model should be able to use a subset of the global IOs
-    // This subset could be be computed from the rd/wr variable set derived from the transition rules
+    // Each instance only takes the IOs actually used by the corresponding model (see [actualIos])
+    QList<Iov*> actual_ios = actualIos(global_ios);
     os << "fsm " << name << " = " << name << "(";
     bool first = true;
-    for(const auto io : global_ios) {
+    for(const auto io : actual_ios) {
       if ( !first ) os << ", ";
       os << io->name;
       first = false;
@@ -830,14 +936,12 @@ void Automaton::exportRfsmModel(QTextStream& os, QList<Iov*>& global_ios)
     QString indent = QString(2, ' ');
     bool first;
 
-    // TODO : compute actual_ios using an extension of the fragment checker mechanism
-    // For now, let's assume local_ios = global_ios (i.e. all automatons take all IOs
-    //QList<Iov*> actual_ios;
+    QList<Iov*> actual_ios = actualIos(global_ios);
     os << "fsm model " << name << "(";
-    if ( global_ios.length() > 0 ) {
+    if ( actual_ios.length() > 0 ) {
       os << "\n";
       first = true;
-      for(const auto io : global_ios) {
+      for(const auto io : actual_ios) {
             if(!first) os << "," << "\n";
             os << indent;
             os << stringOfIoKind(io->kind) << " " << io->name << ": " << Iov::stringOfType(io->type);
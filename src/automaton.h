@@ -15,9 +15,12 @@
 #include <QStringListModel>
 #include <QTextStream>
 #include <QGraphicsScene>
+#include <QHash>
+#include <QSet>
 
 #include "state.h"
 #include "iov.h"
+#include "fragmentChecker.h"
 #include "include/nlohmann_json.h"
 
 QT_BEGIN_NAMESPACE
@@ -30,6 +33,7 @@ class QColor;
 class QGVScene;
 #endif
 class Model;
+class SimProfile;
 QT_END_NAMESPACE
 
 class Automaton : public QGraphicsScene
@@ -68,7 +72,12 @@ public:
 
     void save(nlohmann::json json_res);
 
-    bool check(QList<Iov*>& global_ios);
+    bool check(QList<Iov*>& global_ios, bool withFragments=true);
+    QList<FragmentChecker::Fragment> fragments(bool changedOnly=false);
+    void setChecked(const QList<FragmentChecker::Fragment>& fragments);
+
+    void showProfile(const SimProfile& profile); // Heatmap of the firing profile of a simulation
+    void hideProfile();
 
     void dump(); // for debug only
 
@@ -78,6 +87,8 @@ public:
     void exportDot(QTextStream &os);
     void exportRfsmModel(QTextStream& os, QList<Iov*>& global_ios);
     void exportRfsmInstance(QTextStream& os, QList<Iov*>& global_ios);
+    void rwSets(QSet<QString>& rd, QSet<QString>& wr); // Identifiers read and written by the transitions and states
+    QList<Iov*> actualIos(QList<Iov*>& global_ios); // The subset of [global_ios] actually used 
 
     static Automaton* fromJson(nlohmann::json& json, Model *model, QWidget *parent);
     void toJson(nlohmann::json& json);
@@ -123,6 +134,12 @@ private:
     Model *model; 
     QGraphicsView *view; 
     QList<Iov*> vars; // Local variables (IOs and global vars are part of the enclosing model)
+
+    // Incremental checking. Revision stamps of the states and transitions whose fragments passed the
+    // last check, and of the IOs and variables forming their context at this time
+    QHash<QGraphicsItem*,quint64> checkedRevisions;
+    QList<quint64> checkedContext;
+    QList<quint64> contextRevisions();
     
     QGraphicsLineItem *line;  // Line being drawn
     State *startState;
@@ -0,0 +1,361 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "batch.h"
+#include "globals.h"
+#include "model.h"
+#include "compiler.h"
+#include "compilerOptions.h"
+#include "simulator.h"
+#include "sweepRunner.h"
+#include "explorer.h"
+#include "traceReplay.h"
+#include "debug.h"
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <stdio.h>
+#include <string.h>
+#include <exception>
+
+static bool verboseMode = false;
+
+// Debug messages are only shown with [--verbose]
+
+static void batchMessageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg)
+{
+  if ( ! verboseMode && (type == QtDebugMsg || type == QtInfoMsg) ) return;
+  debugMessageHandler(type, context, msg);
+}
+
+bool Batch::requested(int argc, char *argv[])
+{
+  for ( int i=1; i<argc; i++ )
+    if ( strcmp(argv[i], "--batch") == 0 ) return true;
+  return false;
+}
+
+void Batch::usage()
+{
+  fprintf(stderr,
+    "usage: grasp --batch [options] file.fsd\n"
+    "  --check          check the model (default when no other action is given)\n"
+    "  --stimuli        also check the stimuli\n"
+    "  --dot            write the DOT representation of the automata\n"
+    "  --fsm            write the RFSM code of the model\n"
+    "  --testbench      include the testbench in the RFSM and generated code\n"
+    "  --target <t>     generate code for target <t> (ctask, systemc, vhdl, sim) with the compiler; can be repeated\n"
+    "  --simulate       simulate the model with the built-in simulator\n"
+    "  --resume <file>  resume the simulation from snapshot <file> (implies --simulate)\n"
+    "  --replay <file>  rebuild the VCD trace of the simulation log <file> (.glog)\n"
+    "  --sweep <file>   run the stimulus sweep described in <file>; can be repeated\n"
+    "  --explore        explore the state space of the model, looking for unreachable states, deadlocks and errors\n"
+    "  --options <file> read compiler options from <file> (as saved by the options dialog)\n"
+    "  --verbose        show debug messages\n");
+}
+
+void Batch::message(QString msg)
+{
+  fprintf(stdout, "%s\n", msg.toLocal8Bit().constData());
+}
+
+void Batch::error(QString msg)
+{
+  Globals::warning("", msg);
+}
+
+bool Batch::parseArgs(QStringList args, bool& verbose)
+{
+  static const QStringList targetNames = { "ctask", "systemc", "vhdl", "sim" };
+  for ( int i=1; i<args.length(); i++ ) {
+    QString a = args.at(i);
+    bool hasArg = a == "--target" || a == "--sweep" || a == "--options" || a == "--resume" || a == "--replay";
+    if ( hasArg && i+1 >= args.length() ) {
+      error("missing argument for option " + a);
+      return false;
+      }
+    if ( a == "--batch" ) continue;
+    else if ( a == "--check" ) continue; // Always done
+    else if ( a == "--stimuli" ) withStimuli = true;
+    else if ( a == "--dot" ) dot = true;
+    else if ( a == "--fsm" ) fsm = true;
+    else if ( a == "--testbench" ) withTestbench = true;
+    else if ( a == "--simulate" ) simulate = true;
+    else if ( a == "--explore" ) explore = true;
+    else if ( a == "--verbose" ) verbose = true;
+    else if ( a == "--target" ) {
+      QString t = args.at(++i);
+      if ( ! targetNames.contains(t) ) {
+        error("unknown target " + t);
+        return false;
+        }
+      targets << t;
+      }
+    else if ( a == "--sweep" ) sweeps << args.at(++i);
+    else if ( a == "--options" ) optionFiles << args.at(++i);
+    else if ( a == "--replay" ) logFiles << args.at(++i);
+    else if ( a == "--resume" ) {
+      snapshotFile = args.at(++i);
+      simulate = true;
+      }
+    else if ( a.startsWith("-") ) {
+      error("unknown option " + a);
+      return false;
+      }
+    else if ( fsdFile.isEmpty() ) fsdFile = a;
+    else {
+      error("only one model can be processed");
+      return false;
+      }
+    }
+  if ( fsdFile.isEmpty() ) {
+    error("no model file given");
+    return false;
+    }
+  // Generating code from a testbench, simulating and sweeping all require stimuli
+  if ( withTestbench || targets.contains("sim") || simulate || ! sweeps.isEmpty() ) withStimuli = true;
+  return true;
+}
+
+// Actions
+
+bool Batch::check()
+{
+  int nbWarnings = Globals::nbWarnings;
+  bool ok = model->check(withStimuli); // Errors are reported by [Globals::warning]
+  if ( ok ) message("Checked model " + model->getName());
+  return ok && Globals::nbWarnings == nbWarnings;
+}
+
+static QString removeSuffix(QString fname)
+{
+  QFileInfo f(fname);
+  return f.path() + "/" + f.completeBaseName();
+}
+
+bool Batch::exportDots()
+{
+  int nbWarnings = Globals::nbWarnings;
+  QStringList opts = Globals::compilerOptions->getOptions("dot");
+  QStringList fnames = model->exportDots(removeSuffix(fsdFile), opts);
+#ifndef USE_QGV
+  QString fname = removeSuffix(fsdFile) + ".dot";
+  model->exportDot(fname, opts);
+  fnames << fname;
+#endif
+  foreach ( QString f, fnames ) message("Wrote file " + f);
+  return Globals::nbWarnings == nbWarnings;
+}
+
+bool Batch::exportRfsm()
+{
+  int nbWarnings = Globals::nbWarnings;
+  QString fname = removeSuffix(fsdFile) + ".fsm";
+  model->exportRfsm(fname, withTestbench);
+  message("Wrote file " + fname);
+  return Globals::nbWarnings == nbWarnings;
+}
+
+bool Batch::generate(QString target)
+{
+  int nbWarnings = Globals::nbWarnings;
+  QString fname = removeSuffix(fsdFile) + ".fsm";
+  model->exportRfsm(fname, withTestbench || target == "sim");
+  if ( Globals::nbWarnings != nbWarnings ) return false;
+  QString wDir = QFileInfo(fname).absolutePath();
+  QString mainName = model->getName().isEmpty() ? "main" : model->getName();
+  QStringList args = Globals::compiler->targetArgs(target, mainName, wDir);
+  if ( ! Globals::compiler->run(QFileInfo(fname).fileName(), args, wDir) ) {
+    error("error when compiling model for target " + target + "\n" + Globals::compiler->getErrors().join("\n"));
+    return false;
+    }
+  QStringList resFiles = Globals::compiler->getOutputFiles(target, wDir, mainName);
+  if ( ! resFiles.isEmpty() ) message("Generated file(s) : " + resFiles.join(", "));
+  return Globals::nbWarnings == nbWarnings;
+}
+
+bool Batch::runSimulation()
+{
+  QStringList simOpts = Globals::compilerOptions->getOptions("sim");
+  int vcdIntSize;
+  bool compressed;
+  QString cxx;
+  QString warning = Simulator::settings(simOpts, vcdIntSize, compressed, cxx);
+  if ( ! warning.isEmpty() ) message(warning);
+  QString mainName = model->getName().isEmpty() ? "main" : model->getName();
+  QString vcdFile = QFileInfo(fsdFile).absolutePath() + "/" + mainName + (compressed ? ".vcd.gz" : ".vcd");
+  SimSnapshot snapshot;
+  if ( ! snapshotFile.isEmpty() ) {
+    QString err;
+    if ( ! snapshot.load(snapshotFile, err) ) {
+      error(err);
+      return false;
+      }
+    QFileInfo f(snapshotFile);
+    vcdFile = f.absolutePath() + "/" + f.completeBaseName() + "_resumed" + (compressed ? ".vcd.gz" : ".vcd");
+    }
+  Simulator simulator(model, simOpts.contains("-synchronous_actions"));
+  if ( ! cxx.isEmpty() ) simulator.setCompiled(Globals::simCacheDir, cxx);
+  simulator.setSnapshots(Simulator::intOption(simOpts, "-sim_snapshot_interval", 0), Simulator::intOption(simOpts, "-sim_stop_time", -1));
+  simulator.setThreads(Simulator::intOption(simOpts, "-sim_threads", 1));
+  simulator.setLog(simOpts.contains("-sim_log"));
+  simulator.setProfiling(simOpts.contains("-sim_profile"));
+  bool ok = snapshotFile.isEmpty() ? simulator.run(vcdFile, vcdIntSize, compressed) : simulator.resume(snapshot, vcdFile, vcdIntSize, compressed);
+  if ( ! ok ) {
+    error("error when simulating model\n" + simulator.getErrors().join("\n"));
+    return false;
+    }
+  QStringList files = QStringList(vcdFile) + simulator.getSnapshots();
+  if ( ! simulator.getLogFile().isEmpty() ) files << simulator.getLogFile();
+  if ( ! simulator.getProfileFile().isEmpty() ) files << simulator.getProfileFile();
+  message("Generated file(s) : " + files.join(", ") + " (" + QString::number(simulator.getNbTransitions()) + " transitions)");
+  return true;
+}
+
+bool Batch::replayLog(QString fname)
+{
+  QStringList simOpts = Globals::compilerOptions->getOptions("sim");
+  int vcdIntSize;
+  bool compressed;
+  QString cxx;
+  Simulator::settings(simOpts, vcdIntSize, compressed, cxx);
+  QString vcdFile = removeSuffix(fname) + "_replay" + (compressed ? ".vcd.gz" : ".vcd");
+  TraceReplay replay;
+  if ( ! replay.open(fname) || ! replay.toVcd(vcdFile, vcdIntSize, compressed) ) {
+    error(replay.getError());
+    return false;
+    }
+  message("Generated file(s) : " + vcdFile);
+  return true;
+}
+
+bool Batch::runSweeps()
+{
+  QStringList simOpts = Globals::compilerOptions->getOptions("sim");
+  int vcdIntSize;
+  bool compressed;
+  QString cxx;
+  QString warning = Simulator::settings(simOpts, vcdIntSize, compressed, cxx);
+  if ( ! warning.isEmpty() ) message(warning);
+  SweepRunner runner(model, simOpts.contains("-synchronous_actions"));
+  runner.setTrace(vcdIntSize, compressed);
+  runner.setSliced(simOpts.contains("-sliced_sim"));
+  if ( ! cxx.isEmpty() ) runner.setCompiled(Globals::simCacheDir, cxx);
+  QList<SweepRunner::Run> runs;
+  foreach ( QString f, sweeps ) runner.parse(f, runs);
+  if ( ! runner.getErrors().isEmpty() ) {
+    error(runner.getErrors().join("\n"));
+    return false;
+    }
+  QString dir = QFileInfo(fsdFile).absolutePath();
+  bool ok = runner.run(runs, dir);
+  if ( ! runner.getWarning().isEmpty() ) message(runner.getWarning());
+  if ( ! ok ) {
+    error("error when simulating model\n" + runner.getErrors().join("\n"));
+    return false;
+    }
+  int nbFailed = 0;
+  foreach ( const SweepRunner::Run& r, runs ) {
+    if ( r.ok ) continue;
+    error("run " + r.name + ": " + r.errors.join("; "));
+    nbFailed++;
+    }
+  QString mainName = model->getName().isEmpty() ? "main" : model->getName();
+  QString summary = dir + "/" + mainName + "_sweep.csv";
+  if ( ! runner.writeSummary(summary, runs) ) {
+    error(runner.getErrors().join("\n"));
+    return false;
+    }
+  message("Sweep: " + QString::number(runs.length()) + " runs, " + QString::number(nbFailed) + " failed. Summary in " + summary);
+  return nbFailed == 0;
+}
+
+// Fails if the exploration finds deadlocks or errors (unreachable states are only reported)
+
+bool Batch::exploreModel()
+{
+  QStringList simOpts = Globals::compilerOptions->getOptions("sim");
+  Explorer explorer(model, simOpts.contains("-synchronous_actions"));
+  explorer.setIntRange(Simulator::intOption(simOpts, "-explore_int_max", 3));
+  explorer.setMaxStates(Simulator::intOption(simOpts, "-explore_max_states", 1000000));
+  if ( ! explorer.run() ) {
+    error("error when exploring model\n" + explorer.getErrors().join("\n"));
+    return false;
+    }
+  foreach ( QString s, explorer.getUnreachable() ) message("unreachable state " + s);
+  foreach ( const Explorer::Counterexample& c, explorer.getDeadlocks() ) error(c.description);
+  foreach ( const Explorer::Counterexample& c, explorer.getFailures() ) error(c.description);
+  QString dir = QFileInfo(fsdFile).absolutePath();
+  QString mainName = model->getName().isEmpty() ? "main" : model->getName();
+  QString report = dir + "/" + mainName + "_explore.txt";
+  QStringList files;
+  if ( ! explorer.writeReport(report, files) ) {
+    error(explorer.getErrors().join("\n"));
+    return false;
+    }
+  message("Exploration: " + QString::number(explorer.getNbStates()) + " configurations"
+          + (explorer.isComplete() ? "" : " (incomplete)") + ", "
+          + QString::number(explorer.getDeadlocks().length()) + " deadlock(s), "
+          + QString::number(explorer.getFailures().length()) + " error(s). Report in " + report);
+  return explorer.getDeadlocks().isEmpty() && explorer.getFailures().isEmpty();
+}
+
+// Entry point. Actions are performed in a fixed order; the first failing one stops the processing
+
+int Batch::run(QStringList args)
+{
+  QElapsedTimer timer;
+  timer.start();
+  Batch b;
+  bool verbose = false;
+  Globals::batch = true;
+  if ( args.contains("--help") ) {
+    usage();
+    return 0;
+    }
+  if ( ! b.parseArgs(args, verbose) ) {
+    usage();
+    return 2;
+    }
+  verboseMode = verbose;
+  qInstallMessageHandler(batchMessageHandler);
+  Globals::init(QCoreApplication::applicationDirPath(), NULL);
+  int nbWarnings = Globals::nbWarnings;
+  foreach ( QString f, b.optionFiles ) Globals::compilerOptions->readFromFile(f);
+  if ( Globals::nbWarnings > nbWarnings ) return 1;
+  if ( ! QFileInfo::exists(b.fsdFile) ) {
+    error("cannot open file " + b.fsdFile);
+    return 1;
+    }
+  Model model(QString(), NULL);
+  try {
+    model.readFromFile(b.fsdFile);
+    }
+  catch ( const std::exception& e ) {
+    error("unable to read " + b.fsdFile + ": " + QString(e.what()));
+    return 1;
+    }
+  b.model = &model;
+  bool ok = b.check();
+  if ( ok && b.dot ) ok = b.exportDots();
+  if ( ok && b.fsm ) ok = b.exportRfsm();
+  foreach ( QString t, b.targets )
+    if ( ok ) ok = b.generate(t);
+  if ( ok && b.simulate ) ok = b.runSimulation();
+  if ( ok && ! b.sweeps.isEmpty() ) ok = b.runSweeps();
+  if ( ok && b.explore ) ok = b.exploreModel();
+  foreach ( QString f, b.logFiles )
+    if ( ok ) ok = b.replayLog(f);
+  qDebug() << "Batch::run:" << timer.elapsed() << "ms";
+  return ok ? 0 : 1;
+}
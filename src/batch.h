@@ -0,0 +1,60 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+class Model;
+
+// Headless mode, invoked as [grasp --batch [options] file.fsd].
+// The model is read, checked and processed as with the GUI commands, but no widget is created
+// (the automata still need a [QApplication], which then uses the "offscreen" platform).
+// Messages go to stdout and errors to stderr. The exit status is 0 iff all actions succeeded.
+
+class Batch
+{
+public:
+  static bool requested(int argc, char *argv[]);
+  static int run(QStringList args);
+
+private:
+  Batch() : model(NULL), withStimuli(false), withTestbench(false), dot(false), fsm(false), simulate(false), explore(false) { };
+
+  Model *model;
+  QString fsdFile;
+  bool withStimuli;
+  bool withTestbench;
+  bool dot;
+  bool fsm;
+  bool simulate;
+  bool explore;
+  QStringList targets;
+  QStringList sweeps;
+  QStringList optionFiles;
+  QString snapshotFile;
+  QStringList logFiles;     // To replay
+
+  bool parseArgs(QStringList args, bool& verbose);
+  bool check();
+  bool exportDots();
+  bool exportRfsm();
+  bool generate(QString target);
+  bool runSimulation();
+  bool runSweeps();
+  bool exploreModel();
+  bool replayLog(QString fname);
+  static void usage();
+  static void message(QString msg);
+  static void error(QString msg);
+};
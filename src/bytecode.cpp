@@ -0,0 +1,312 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "bytecode.h"
+#include <stdexcept>
+#include <climits>
+
+const int Bytecode::maxStack;
+
+// Symbol table
+
+int SymbolTable::addGlobal(QString name)
+{
+  if ( ! globals.contains(name) ) globals.insert(name, nbSlots++);
+  return globals.value(name);
+}
+
+int SymbolTable::addLocal(int fsm, QString name)
+{
+  while ( locals.length() <= fsm ) locals.append(QHash<QString,int>());
+  if ( ! locals[fsm].contains(name) ) locals[fsm].insert(name, nbSlots++);
+  return locals[fsm].value(name);
+}
+
+int SymbolTable::scratch(int slot)
+{
+  if ( ! scratches.contains(slot) ) scratches.insert(slot, nbSlots++);
+  return scratches.value(slot);
+}
+
+int SymbolTable::addEvent(QString name)
+{
+  if ( ! events.contains(name) ) {
+    events.insert(name, eventNames.length());
+    eventNames.append(name);
+    }
+  return events.value(name);
+}
+
+int SymbolTable::lookup(int fsm, QString name) const
+{
+  if ( fsm >= 0 && fsm < locals.length() && locals.at(fsm).contains(name) ) return locals.at(fsm).value(name);
+  return globals.value(name, -1);
+}
+
+// Compilation
+
+void Bytecode::push(int n)
+{
+  depth += n;
+  if ( depth > maxDepth ) maxDepth = depth;
+  if ( maxDepth > maxStack ) throw std::runtime_error("expression too complex");
+}
+
+void Bytecode::compileExpr(const Expr *e, const SymbolTable& syms, int fsm)
+{
+  static const QHash<QString,int> binops = {
+    { "+", ADD }, { "-", SUB }, { "*", MUL }, { "/", DIV }, { "%", MOD },
+    { "=", EQ }, { "!=", NE }, { "<", LT }, { ">", GT }, { "<=", LE }, { ">=", GE },
+    { "&", BAND }, { "|", BOR }, { "^", BXOR }, { "<<", SHL }, { ">>", SHR }
+  };
+  switch ( e->kind ) {
+  case Expr::EInt:
+  case Expr::EBool:
+    emit(PUSH, e->value);
+    push();
+    break;
+  case Expr::EVar: {
+    int slot = syms.lookup(fsm, e->name);
+    if ( slot < 0 ) throw std::runtime_error("unbound identifier " + e->name.toStdString());
+    emit(LOAD, shadows.value(slot, slot));
+    push();
+    break;
+    }
+  case Expr::EUnop:
+    compileExpr(e->args.at(0), syms, fsm);
+    emit(e->name == "-" ? NEG : e->name == "~" ? BNOT : LNOT);
+    break;
+  case Expr::EBinop:
+    if ( e->name == "&&" || e->name == "||" ) {
+      // Short-circuit evaluation
+      compileExpr(e->args.at(0), syms, fsm);
+      emit(JZ, 0);
+      pop();
+      int jz = code.length()-1;
+      if ( e->name == "&&" ) {
+        compileExpr(e->args.at(1), syms, fsm);
+        emit(TOBOOL);
+        emit(JMP, 0);
+        int jmp = code.length()-1;
+        code[jz] = code.length();
+        emit(PUSH, 0);
+        code[jmp] = code.length();
+        }
+      else {
+        emit(PUSH, 1);
+        emit(JMP, 0);
+        int jmp = code.length()-1;
+        code[jz] = code.length();
+        compileExpr(e->args.at(1), syms, fsm);
+        emit(TOBOOL);
+        code[jmp] = code.length();
+        }
+      }
+    else {
+      compileExpr(e->args.at(0), syms, fsm);
+      compileExpr(e->args.at(1), syms, fsm);
+      emit(binops.value(e->name));
+      pop();
+      }
+    break;
+  case Expr::EBit:
+    compileExpr(e->args.at(0), syms, fsm);
+    compileExpr(e->args.at(1), syms, fsm);
+    emit(BIT);
+    pop();
+    break;
+  case Expr::ERange:
+    compileExpr(e->args.at(0), syms, fsm);
+    compileExpr(e->args.at(1), syms, fsm);
+    compileExpr(e->args.at(2), syms, fsm);
+    emit(RANGE);
+    pop(2);
+    break;
+  case Expr::ECast:
+    compileExpr(e->args.at(0), syms, fsm);
+    if ( e->name == "bool" ) emit(TOBOOL);
+    break;
+  case Expr::ECond: {
+    compileExpr(e->args.at(0), syms, fsm);
+    emit(JZ, 0);
+    pop();
+    int jz = code.length()-1;
+    compileExpr(e->args.at(1), syms, fsm);
+    pop();
+    emit(JMP, 0);
+    int jmp = code.length()-1;
+    code[jz] = code.length();
+    compileExpr(e->args.at(2), syms, fsm);
+    code[jmp] = code.length();
+    break;
+    }
+  }
+}
+
+void Bytecode::compileStore(QString lhs, SymbolTable& syms, int fsm)
+{
+  int slot = syms.lookup(fsm, lhs);
+  if ( slot < 0 ) throw std::runtime_error("unbound identifier " + lhs.toStdString());
+  if ( syms.isLocal(fsm, lhs) )
+    emit(STORE, slot);
+  else {
+    int scratch = syms.scratch(slot);
+    emit(STOREG, slot);
+    code.append(scratch);
+    shadows.insert(slot, scratch);
+    }
+  pop();
+}
+
+int Bytecode::compileGuards(const QList<Expr*>& guards, const SymbolTable& syms, int fsm)
+{
+  int start = code.length();
+  depth = maxDepth = 0;
+  shadows.clear();
+  QList<int> exits;
+  foreach ( const Expr *g, guards ) {
+    compileExpr(g, syms, fsm);
+    emit(JZ, 0);
+    pop();
+    exits.append(code.length()-1);
+    }
+  emit(PUSH, 1);
+  emit(RET);
+  int fail = code.length();
+  emit(PUSH, 0);
+  emit(RET);
+  foreach ( int i, exits ) code[i] = fail;
+  return start;
+}
+
+int Bytecode::compileActions(const QList<Action*>& actions, SymbolTable& syms, int fsm, bool synchronous)
+{
+  int start = code.length();
+  depth = maxDepth = 0;
+  shadows.clear();
+  if ( synchronous ) {
+    // All right-hand sides are evaluated before any update. Only the last assignment to a given
+    // variable is kept
+    QList<Action*> assigns;
+    for ( int i=0; i<actions.length(); i++ ) {
+      Action *a = actions.at(i);
+      if ( a->kind == Action::Emit ) continue;
+      bool overriden = false;
+      for ( int j=i+1; j<actions.length(); j++ )
+        if ( actions.at(j)->kind == Action::Assign && actions.at(j)->lhs == a->lhs ) overriden = true;
+      if ( overriden ) continue;
+      compileExpr(a->rhs, syms, fsm);
+      assigns.prepend(a);
+      }
+    foreach ( Action *a, assigns ) compileStore(a->lhs, syms, fsm);
+    shadows.clear();
+    }
+  foreach ( Action *a, actions ) {
+    if ( a->kind == Action::Emit ) {
+      int e = syms.event(a->lhs);
+      if ( e < 0 ) throw std::runtime_error("unknown event " + a->lhs.toStdString());
+      emit(EMIT, e);
+      }
+    else if ( ! synchronous ) {
+      compileExpr(a->rhs, syms, fsm);
+      compileStore(a->lhs, syms, fsm);
+      }
+    }
+  emit(RET);
+  return start;
+}
+
+int Bytecode::compileValuations(const QList<Valuation*>& valuations, SymbolTable& syms, int fsm)
+{
+  int start = code.length();
+  depth = maxDepth = 0;
+  shadows.clear();
+  foreach ( Valuation *v, valuations ) {
+    compileExpr(v->value, syms, fsm);
+    compileStore(v->output, syms, fsm);
+    }
+  emit(RET);
+  return start;
+}
+
+// Execution
+
+int Bytecode::run(int pc, Context& ctx) const
+{
+  int stack[maxStack];
+  int sp = 0; // Next free
+  const qint32 *c = code.constData();
+  while ( true ) {
+    switch ( c[pc++] ) {
+    case PUSH: stack[sp++] = c[pc++]; break;
+    case LOAD: stack[sp++] = ctx.store[c[pc++]]; break;
+    case STORE: ctx.store[c[pc++]] = stack[--sp]; break;
+    case STOREG: {
+      int v = stack[--sp];
+      ctx.updates->append(QPair<int,int>(c[pc], v));
+      ctx.store[c[pc+1]] = v;
+      pc += 2;
+      break;
+      }
+    case EMIT: ctx.emitted->append(c[pc++]); break;
+    case JZ: if ( stack[--sp] == 0 ) pc = c[pc]; else pc++; break;
+    case JMP: pc = c[pc]; break;
+    case NEG: stack[sp-1] = -stack[sp-1]; break;
+    case BNOT: stack[sp-1] = ~stack[sp-1]; break;
+    case LNOT: stack[sp-1] = ! stack[sp-1]; break;
+    case TOBOOL: stack[sp-1] = stack[sp-1] != 0; break;
+    case ADD: sp--; stack[sp-1] += stack[sp]; break;
+    case SUB: sp--; stack[sp-1] -= stack[sp]; break;
+    case MUL: sp--; stack[sp-1] *= stack[sp]; break;
+    case DIV:
+    case MOD:
+      sp--;
+      if ( stack[sp] == 0 ) throw std::runtime_error("division by zero");
+      if ( stack[sp] == -1 && stack[sp-1] == INT_MIN ) throw std::runtime_error("arithmetic overflow");
+      stack[sp-1] = c[pc-1] == DIV ? stack[sp-1] / stack[sp] : stack[sp-1] % stack[sp];
+      break;
+    case EQ: sp--; stack[sp-1] = stack[sp-1] == stack[sp]; break;
+    case NE: sp--; stack[sp-1] = stack[sp-1] != stack[sp]; break;
+    case LT: sp--; stack[sp-1] = stack[sp-1] < stack[sp]; break;
+    case GT: sp--; stack[sp-1] = stack[sp-1] > stack[sp]; break;
+    case LE: sp--; stack[sp-1] = stack[sp-1] <= stack[sp]; break;
+    case GE: sp--; stack[sp-1] = stack[sp-1] >= stack[sp]; break;
+    case BAND: sp--; stack[sp-1] &= stack[sp]; break;
+    case BOR: sp--; stack[sp-1] |= stack[sp]; break;
+    case BXOR: sp--; stack[sp-1] ^= stack[sp]; break;
+    case SHL:
+    case SHR:
+    case BIT: {
+      sp--;
+      int v = stack[sp-1], n = stack[sp];
+      if ( n < 0 || n >= 32 ) throw std::runtime_error("invalid shift count");
+      switch ( c[pc-1] ) {
+      case SHL: stack[sp-1] = int(unsigned(v) << n); break;
+      case SHR: stack[sp-1] = v >> n; break;
+      default: stack[sp-1] = (v >> n) & 1; break;
+      }
+      break;
+      }
+    case RANGE: {
+      sp -= 2;
+      int v = stack[sp-1], hi = stack[sp], lo = stack[sp+1];
+      if ( lo < 0 || hi < lo || hi >= 32 ) throw std::runtime_error("invalid bit range");
+      int w = hi - lo + 1;
+      stack[sp-1] = w >= 32 ? v : int(unsigned(v >> lo) & ((1u << w) - 1));
+      break;
+      }
+    case RET: return sp > 0 ? stack[sp-1] : 1;
+    default:
+      throw std::runtime_error("invalid bytecode");
+    }
+  }
+}
@@ -0,0 +1,105 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QVector>
+#include <QPair>
+#include <QHash>
+#include <QString>
+#include "expr.h"
+
+// Stack-based bytecode for guards, actions and state valuations.
+//
+// All variables live in a flat integer store, indexed by slots allocated by the [SymbolTable].
+// Writes to local variables take effect immediately. Writes to global IOs and shared variables
+// are recorded as (slot,value) updates, to be committed by the caller, and copied to a scratch
+// slot so that subsequent sequential actions of the same transition see them.
+// Emitted events are recorded by their index.
+
+class SymbolTable
+{
+public:
+  SymbolTable() : nbSlots(0) { }
+
+  int addGlobal(QString name);
+  int addLocal(int fsm, QString name);
+  int scratch(int slot); // Scratch slot associated to a global slot
+  QList<int> scratchSlots() const { return scratches.values(); }
+  int addEvent(QString name);
+
+  int lookup(int fsm, QString name) const; // Locals of [fsm] first, then globals. -1 if not found
+  int global(QString name) const { return globals.value(name, -1); }
+  bool isLocal(int fsm, QString name) const { return fsm < locals.length() && locals.at(fsm).contains(name); }
+  int event(QString name) const { return events.value(name, -1); }
+  QString eventName(int e) const { return eventNames.at(e); }
+  int getNbSlots() const { return nbSlots; }
+  int getNbEvents() const { return eventNames.length(); }
+
+private:
+  int nbSlots;
+  QHash<QString,int> globals;
+  QHash<int,int> scratches;
+  QList<QHash<QString,int>> locals;
+  QHash<QString,int> events;
+  QList<QString> eventNames;
+};
+
+class Bytecode
+{
+public:
+  enum Op {
+    PUSH,      // PUSH c
+    LOAD,      // LOAD slot
+    STORE,     // STORE slot (local)
+    STOREG,    // STOREG slot scratch (global)
+    EMIT,      // EMIT event
+    JZ,        // JZ offset (pops)
+    JMP,       // JMP offset
+    NEG, BNOT, LNOT, TOBOOL,
+    ADD, SUB, MUL, DIV, MOD,
+    EQ, NE, LT, GT, LE, GE,
+    BAND, BOR, BXOR, SHL, SHR,
+    BIT, RANGE,
+    RET        // Returns the top of the stack (or 1 if empty)
+  };
+
+  struct Context {
+    int *store;
+    QVector<QPair<int,int>> *updates;
+    QVector<int> *emitted;
+  };
+
+  QVector<qint32> code;
+
+  // Compilation. Each function appends a code block terminated by [RET] and returns its start offset.
+  // Errors (unbound identifiers, ...) are reported by raising std::runtime_error
+  int compileGuards(const QList<Expr*>& guards, const SymbolTable& syms, int fsm);
+  int compileActions(const QList<Action*>& actions, SymbolTable& syms, int fsm, bool synchronous);
+  int compileValuations(const QList<Valuation*>& valuations, SymbolTable& syms, int fsm);
+
+  // Execution
+  int run(int start, Context& ctx) const;
+
+  static const int maxStack = 64;
+
+private:
+  int depth, maxDepth;
+  QHash<int,int> shadows; // Global slot -> scratch slot, for sequential actions
+
+  void emit(qint32 op) { code.append(op); }
+  void emit(qint32 op, qint32 arg) { code.append(op); code.append(arg); }
+  void push(int n = 1);
+  void pop(int n = 1) { depth -= n; }
+  void compileExpr(const Expr *e, const SymbolTable& syms, int fsm);
+  void compileStore(QString lhs, SymbolTable& syms, int fsm);
+};
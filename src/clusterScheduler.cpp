@@ -0,0 +1,93 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "clusterScheduler.h"
+#include <QThread>
+#include <algorithm>
+
+namespace {
+  class ClusterWorker : public QThread {
+  public:
+    ClusterWorker(std::function<void()> body) : body(body) { }
+  protected:
+    void run() override { body(); }
+  private:
+    std::function<void()> body;
+  };
+}
+
+ClusterScheduler::ClusterScheduler(const QList<QVector<int>>& clusters, int nbThreads)
+{
+  this->clusters = clusters;
+  std::stable_sort(this->clusters.begin(), this->clusters.end(),
+                   [](const QVector<int>& c1, const QVector<int>& c2) { return c1.size() > c2.size(); });
+  this->generation = 0;
+  this->busy = 0;
+  this->stopping = false;
+  for ( int i=1; i<qMin(nbThreads, clusters.length()); i++ ) { // The calling thread is one of them
+    workers.append(new ClusterWorker([this]() { work(); }));
+    workers.last()->start();
+    }
+}
+
+ClusterScheduler::~ClusterScheduler()
+{
+  mutex.lock();
+  stopping = true;
+  started.wakeAll();
+  mutex.unlock();
+  foreach ( QThread *w, workers ) w->wait();
+  qDeleteAll(workers);
+}
+
+void ClusterScheduler::drain()
+{
+  int i;
+  while ( (i = next.fetchAndAddOrdered(1)) < clusters.length() ) job(clusters.at(i));
+}
+
+// Body of the worker threads. A worker joining a call is counted in [busy] until it has left [drain],
+// so that [run] does not return (and the next call does not reset [next] or [job]) while it is still there
+
+void ClusterScheduler::work()
+{
+  int seen = 0;
+  while ( true ) {
+    mutex.lock();
+    while ( generation == seen && ! stopping ) started.wait(&mutex);
+    if ( stopping ) {
+      mutex.unlock();
+      return;
+      }
+    seen = generation;
+    busy++;
+    mutex.unlock();
+    drain();
+    mutex.lock();
+    if ( --busy == 0 ) finished.wakeAll();
+    mutex.unlock();
+    }
+}
+
+void ClusterScheduler::run(std::function<void(const QVector<int>&)> job)
+{
+  mutex.lock();
+  this->job = job;
+  next.storeRelease(0);
+  generation++;
+  started.wakeAll();
+  mutex.unlock();
+  drain();
+  mutex.lock();
+  while ( busy > 0 ) finished.wait(&mutex);
+  mutex.unlock();
+}
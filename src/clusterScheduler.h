@@ -0,0 +1,59 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QList>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <functional>
+
+class QThread;
+
+// Runs a job on each of a fixed set of clusters of automata (see [ModelTables::clusters]) in parallel,
+// once per micro-step of the built-in simulator.
+//
+// The worker threads are started once and wait between two calls to [run]. Clusters are handed out
+// largest first from a shared cursor, each thread (the calling one included) taking the next one as
+// soon as it is done with the previous, so that a thread stuck on a big cluster leaves the others to
+// its peers.
+//
+// [Explorer] also uses it with one single-element cluster per thread, each call expanding a level of its
+// search.
+
+class ClusterScheduler
+{
+public:
+  ClusterScheduler(const QList<QVector<int>>& clusters, int nbThreads);
+  ~ClusterScheduler();
+
+  const QList<QVector<int>>& getClusters() const { return clusters; }
+  // Calls [job] on each cluster and returns when all calls have returned. [job] must not throw
+  void run(std::function<void(const QVector<int>&)> job);
+
+private:
+  QList<QVector<int>> clusters;  // Largest first
+  QList<QThread*> workers;
+  QMutex mutex;
+  QWaitCondition started;
+  QWaitCondition finished;
+  std::function<void(const QVector<int>&)> job;
+  int generation;  // Number of calls to [run]
+  int busy;        // Workers taking part in the current call
+  bool stopping;
+  QAtomicInt next;
+
+  void work();
+  void drain();
+};
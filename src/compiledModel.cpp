@@ -0,0 +1,349 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "compiledModel.h"
+#include "fsmTable.h"
+#include "fragmentParser.h"
+#include "transition.h"
+#include "state.h"
+#include "globals.h"
+#include "model.h"
+#include "iov.h"
+#include "qt_compat.h"
+#include <QScopedPointer>
+#include <QCryptographicHash>
+#include <QProcess>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTextStream>
+#include <QDebug>
+
+const int CompiledModel::abiVersion = 1;
+const int CompiledModel::compileTimeout = 120000; // ms
+
+CompiledModel::CompiledModel(ModelTables *tables, bool synchronousActions)
+{
+  this->tables = tables;
+  this->synchronousActions = synchronousActions;
+  this->init = NULL;
+  this->react = NULL;
+}
+
+// Code generation
+
+QString CompiledModel::lvalue(QString id, int fsm)
+{
+  const SymbolTable& syms = tables->syms;
+  int slot = syms.lookup(fsm, id);
+  return syms.isLocal(fsm, id) ? "s[" + QString::number(slot) + "]" : "nx[" + QString::number(slot) + "]";
+}
+
+QString CompiledModel::expr(const Expr *e, int fsm)
+{
+  switch ( e->kind ) {
+  case Expr::EInt:
+  case Expr::EBool:
+    return QString::number(e->value);
+  case Expr::EVar: {
+    int slot = tables->syms.lookup(fsm, e->name);
+    return shadows.value(slot, "s[" + QString::number(slot) + "]");
+    }
+  case Expr::EUnop:
+    return "(" + e->name + expr(e->args.at(0), fsm) + ")";
+  case Expr::EBinop: {
+    QString e1 = expr(e->args.at(0), fsm), e2 = expr(e->args.at(1), fsm);
+    if ( e->name == "/" ) return "dv(" + e1 + "," + e2 + ")";
+    if ( e->name == "%" ) return "md(" + e1 + "," + e2 + ")";
+    if ( e->name == "<<" ) return "sl(" + e1 + "," + e2 + ")";
+    if ( e->name == ">>" ) return "sr(" + e1 + "," + e2 + ")";
+    return "(" + e1 + (e->name == "=" ? "==" : e->name) + e2 + ")";
+    }
+  case Expr::EBit:
+    return "(sr(" + expr(e->args.at(0), fsm) + "," + expr(e->args.at(1), fsm) + ")&1)";
+  case Expr::ERange:
+    return "rg(" + expr(e->args.at(0), fsm) + "," + expr(e->args.at(1), fsm) + "," + expr(e->args.at(2), fsm) + ")";
+  case Expr::ECast:
+    return e->name == "bool" ? "(" + expr(e->args.at(0), fsm) + "!=0)" : expr(e->args.at(0), fsm);
+  case Expr::ECond:
+    return "(" + expr(e->args.at(0), fsm) + "?" + expr(e->args.at(1), fsm) + ":" + expr(e->args.at(2), fsm) + ")";
+  }
+  return "0";
+}
+
+QString CompiledModel::actions(const QList<Action*>& actions, int fsm, QString indent)
+{
+  QString r;
+  shadows.clear();
+  QList<Action*> assigns;
+  for ( int i=0; i<actions.length(); i++ ) {
+    Action *a = actions.at(i);
+    if ( a->kind == Action::Emit ) {
+      r += indent + "em[" + QString::number(tables->syms.event(a->lhs)) + "] = 1; // " + a->lhs + "\n";
+      continue;
+      }
+    if ( synchronousActions ) {
+      // All right-hand sides are evaluated before any update. Only the last assignment to a given variable is kept
+      bool overriden = false;
+      for ( int j=i+1; j<actions.length(); j++ )
+        if ( actions.at(j)->kind == Action::Assign && actions.at(j)->lhs == a->lhs ) overriden = true;
+      if ( ! overriden ) assigns.append(a);
+      continue;
+      }
+    QString lhs = lvalue(a->lhs, fsm);
+    r += indent + lhs + " = " + expr(a->rhs, fsm) + "; // " + a->lhs + "\n";
+    if ( ! tables->syms.isLocal(fsm, a->lhs) ) shadows.insert(tables->syms.lookup(fsm, a->lhs), lhs);
+    }
+  if ( ! assigns.isEmpty() ) {
+    for ( int i=0; i<assigns.length(); i++ )
+      r += indent + "const int t" + QString::number(i) + " = " + expr(assigns.at(i)->rhs, fsm) + ";\n";
+    for ( int i=0; i<assigns.length(); i++ )
+      r += indent + lvalue(assigns.at(i)->lhs, fsm) + " = t" + QString::number(i) + "; // " + assigns.at(i)->lhs + "\n";
+    }
+  shadows.clear();
+  return r;
+}
+
+QString CompiledModel::valuations(const QList<Valuation*>& valuations, int fsm, QString indent)
+{
+  QString r;
+  foreach ( Valuation *v, valuations )
+    r += indent + lvalue(v->output, fsm) + " = " + expr(v->value, fsm) + "; // " + v->output + "\n";
+  return r;
+}
+
+template<class T> static QList<T*> parseAll(QStringList texts, T* (FragmentParser::*parse)())
+{
+  QList<T*> r;
+  foreach ( QString text, texts ) {
+    FragmentParser parser(text);
+    T *f = (parser.*parse)();
+    if ( f ) r.append(f); // Parse errors have already been reported when building the tables
+    }
+  return r;
+}
+
+QString CompiledModel::fsmFunction(int i)
+{
+  const FsmTable *fsm = tables->fsms.at(i);
+  QString n = QString::number(i);
+  QString r;
+  QTextStream os(&r);
+  os << "// " << fsm->name << "\n";
+  os << "static int fsm_" << n << "(int *s, int *nx, int *st, const char *ev, char *em, const GraspSimTrace *tr, int *info)\n";
+  os << "{\n";
+  os << "  int f = -1;\n";
+  os << "  switch ( st[" << n << "] ) {\n";
+  for ( int s=0; s<fsm->nbStates; s++ ) {
+    os << "  case " << s << ": // " << fsm->stateNames.at(s) << "\n";
+    for ( int e=0; e<fsm->nbEvents; e++ ) {
+      const FsmTable::Cell& cell = fsm->cell(s, e);
+      for ( int k=cell.first; k<cell.first+cell.count; k++ ) {
+        int id = fsm->entries.at(k).id;
+        QList<Expr*> guards = parseAll<Expr>(fsm->transitions.at(id)->getGuards(), &FragmentParser::parseGuard);
+        QString cond = "ev[" + QString::number(e) + "]";
+        foreach ( Expr *g, guards ) cond += " && " + expr(g, i);
+        qDeleteAll(guards);
+        os << "    if ( " << cond << " ) { if ( f >= 0 ) return conflict(info, " << n << ", f, " << id << "); f = " << id << "; }\n";
+        }
+      }
+    os << "    break;\n";
+    }
+  os << "  }\n";
+  os << "  switch ( f ) {\n";
+  for ( int k=0; k<fsm->entries.size(); k++ ) {
+    const FsmTable::Entry& e = fsm->entries.at(k);
+    Transition *t = fsm->transitions.at(e.id);
+    QList<Action*> as = parseAll<Action>(t->getActions(), &FragmentParser::parseAction);
+    QList<Valuation*> vs = parseAll<Valuation>(fsm->states.at(e.dst)->getAttrs(), &FragmentParser::parseValuation);
+    os << "  case " << e.id << ": // " << t->toString() << "\n";
+    os << actions(as, i, "    ");
+    os << "    st[" << n << "] = " << e.dst << ";\n";
+    os << valuations(vs, i, "    ");
+    os << "    break;\n";
+    qDeleteAll(as);
+    qDeleteAll(vs);
+    }
+  os << "  default:\n";
+  os << "    return 0;\n";
+  os << "  }\n";
+  os << "  if ( tr ) tr->state(tr->data, " << n << ", st[" << n << "]);\n";
+  os << "  return 1;\n";
+  os << "}\n\n";
+  return r;
+}
+
+QString CompiledModel::source()
+{
+  const SymbolTable& syms = tables->syms;
+  int nbFsms = tables->fsms.length();
+  QString r;
+  QTextStream os(&r);
+  os << "// Generated by Grasp " << Globals::version << " for model " << tables->model->getName()
+     << (synchronousActions ? " (synchronous actions)" : "") << ". Do not edit\n\n";
+  os << "#include <string.h>\n#include <limits.h>\n\n";
+  os << "#if defined(_WIN32)\n#define EXPORT extern \"C\" __declspec(dllexport)\n#else\n#define EXPORT extern \"C\"\n#endif\n\n";
+  os << "struct GraspSimTrace {\n"
+     << "  void *data;\n"
+     << "  void (*change)(void *data, int slot, int value);\n"
+     << "  void (*event)(void *data, int event);\n"
+     << "  void (*state)(void *data, int fsm, int state);\n"
+     << "};\n\n";
+  os << "#define NB_SLOTS " << syms.getNbSlots() << "\n";
+  os << "#define NB_EVENTS " << syms.getNbEvents() << "\n";
+  os << "#define MAX_MICRO_STEPS 1000\n\n";
+  os << "static const char shared[NB_EVENTS+1] = {";
+  for ( int e=0; e<syms.getNbEvents(); e++ ) os << (tables->sharedEvent.at(e) ? "1," : "0,");
+  os << "0};\n";
+  QStringList globals; // Slots updated at the end of each micro-step
+  foreach ( Iov *io, tables->model->getIos() )
+    if ( io->type != Iov::TyEvent ) globals << QString::number(syms.global(io->name));
+  os << "static const int globals[" << globals.length() + 1 << "] = {" << globals.join(",") << (globals.isEmpty() ? "0" : "") << "};\n";
+  os << "static thread_local int err; // Several simulations may run concurrently\n\n";
+  // Same checks as the interpreter (see [Bytecode::run])
+  os << "static inline int dv(int a, int b) { if ( b == 0 ) { err = " << DivisionByZero << "; return 0; } "
+     << "if ( b == -1 && a == INT_MIN ) { err = " << Overflow << "; return 0; } return a / b; }\n";
+  os << "static inline int md(int a, int b) { if ( b == 0 ) { err = " << DivisionByZero << "; return 0; } "
+     << "if ( b == -1 && a == INT_MIN ) { err = " << Overflow << "; return 0; } return a % b; }\n";
+  os << "static inline int sl(int a, int n) { if ( n < 0 || n >= 32 ) { err = " << InvalidShift << "; return 0; } return (int)((unsigned)a << n); }\n";
+  os << "static inline int sr(int a, int n) { if ( n < 0 || n >= 32 ) { err = " << InvalidShift << "; return 0; } return a >> n; }\n";
+  os << "static inline int rg(int v, int hi, int lo) { if ( lo < 0 || hi < lo || hi >= 32 ) { err = " << InvalidRange << "; return 0; } "
+     << "int w = hi - lo + 1; return w >= 32 ? v : (int)((unsigned)(v >> lo) & ((1u << w) - 1)); }\n";
+  os << "static inline int conflict(int *info, int fsm, int t1, int t2) { info[0] = fsm; info[1] = t1; info[2] = t2; return " << NonDeterministic << "; }\n\n";
+  os << "static void commit(int *s, const int *nx, const GraspSimTrace *tr)\n{\n";
+  os << "  for ( int i=0; i<" << globals.length() << "; i++ ) {\n";
+  os << "    int k = globals[i];\n";
+  os << "    if ( nx[k] == s[k] ) continue;\n";
+  os << "    s[k] = nx[k];\n";
+  os << "    if ( tr ) tr->change(tr->data, k, s[k]);\n";
+  os << "    }\n}\n\n";
+  for ( int i=0; i<nbFsms; i++ ) os << fsmFunction(i);
+  // Entry points
+  os << "EXPORT int grasp_sim_abi() { return " << abiVersion << "; }\n\n";
+  os << "EXPORT int grasp_sim_init(int *s, int *st, const GraspSimTrace *tr, int *info)\n{\n";
+  os << "  int nx[NB_SLOTS+1];\n";
+  os << "  char em[NB_EVENTS+1];\n";
+  os << "  memcpy(nx, s, NB_SLOTS*sizeof(int));\n";
+  os << "  err = 0;\n";
+  for ( int i=0; i<nbFsms; i++ ) {
+    const FsmTable *fsm = tables->fsms.at(i);
+    QList<Action*> as = parseAll<Action>(fsm->init->getActions(), &FragmentParser::parseAction);
+    QList<Valuation*> vs = parseAll<Valuation>(fsm->states.at(fsm->initState)->getAttrs(), &FragmentParser::parseValuation);
+    os << "  // " << fsm->name << "\n";
+    os << actions(as, i, "  ");
+    os << "  st[" << i << "] = " << fsm->initState << ";\n";
+    os << valuations(vs, i, "  ");
+    os << "  if ( tr ) tr->state(tr->data, " << i << ", st[" << i << "]);\n";
+    qDeleteAll(as);
+    qDeleteAll(vs);
+    }
+  os << "  (void)em; (void)info;\n";
+  os << "  if ( err ) return err;\n";
+  os << "  commit(s, nx, tr);\n";
+  os << "  return 0;\n}\n\n";
+  os << "EXPORT int grasp_sim_react(int *s, int *st, const int *events, int nbEvents, const GraspSimTrace *tr, int *info)\n{\n";
+  os << "  char ev[NB_EVENTS+1], em[NB_EVENTS+1];\n";
+  os << "  int nx[NB_SLOTS+1];\n";
+  os << "  int n = 0, r;\n";
+  os << "  memset(ev, 0, sizeof(ev));\n";
+  os << "  for ( int i=0; i<nbEvents; i++ ) ev[events[i]] = 1;\n";
+  os << "  for ( int step=0; ; step++ ) {\n";
+  os << "    int more = 0;\n";
+  os << "    if ( step >= MAX_MICRO_STEPS ) return " << TooManyMicroSteps << ";\n";
+  os << "    memset(em, 0, sizeof(em));\n";
+  os << "    memcpy(nx, s, NB_SLOTS*sizeof(int));\n";
+  os << "    err = 0;\n";
+  for ( int i=0; i<nbFsms; i++ )
+    os << "    if ( (r = fsm_" << i << "(s, nx, st, ev, em, tr, info)) < 0 ) return r; n += r;\n";
+  os << "    if ( err ) return err;\n";
+  os << "    commit(s, nx, tr);\n";
+  os << "    for ( int e=0; e<NB_EVENTS; e++ ) {\n";
+  os << "      if ( em[e] && tr ) tr->event(tr->data, e);\n";
+  os << "      ev[e] = em[e] && shared[e];\n";
+  os << "      more |= ev[e];\n";
+  os << "      }\n";
+  os << "    if ( ! more ) return n;\n";
+  os << "    }\n}\n";
+  return r;
+}
+
+// Building and loading
+
+bool CompiledModel::compile(QString srcFile, QString libFile, QString compiler)
+{
+  QString tmpFile = libFile + ".tmp";
+  QStringList args = { "-O2", "-shared", "-fPIC", "-o", tmpFile, srcFile };
+  qDebug() << "CompiledModel::compile:" << compiler << args;
+  QProcess proc;
+  proc.start(compiler, args);
+  if ( ! proc.waitForStarted() ) {
+    errors << "cannot start C++ compiler " + compiler;
+    return false;
+    }
+  if ( ! proc.waitForFinished(compileTimeout) ) {
+    proc.kill();
+    proc.waitForFinished();
+    errors << "C++ compiler " + compiler + " timed out";
+    return false;
+    }
+  if ( proc.exitStatus() != QProcess::NormalExit || proc.exitCode() != 0 ) {
+    errors << "compilation of " + srcFile + " failed";
+    errors << QString::fromLocal8Bit(proc.readAllStandardError()).split("\n", SKIP_EMPTY_PARTS);
+    return false;
+    }
+  QFile::remove(libFile);
+  return QFile::rename(tmpFile, libFile);
+}
+
+bool CompiledModel::load(QString cacheDir, QString compiler)
+{
+  errors.clear();
+  QString src = source();
+  QString hash = QCryptographicHash::hash(src.toUtf8(), QCryptographicHash::Sha1).toHex().left(16);
+#if defined(Q_OS_WIN)
+  QString suffix = ".dll";
+#elif defined(Q_OS_MACOS)
+  QString suffix = ".dylib";
+#else
+  QString suffix = ".so";
+#endif
+  QString base = cacheDir + "/grasp_sim_" + hash;
+  QString libFile = base + suffix;
+  if ( ! QFileInfo::exists(libFile) ) {
+    if ( ! QDir().mkpath(cacheDir) ) {
+      errors << "cannot create directory " + cacheDir;
+      return false;
+      }
+    QFile file(base + ".cpp");
+    if ( ! file.open(QIODevice::WriteOnly | QIODevice::Text) ) {
+      errors << "cannot write file " + file.fileName();
+      return false;
+      }
+    file.write(src.toUtf8());
+    file.close();
+    if ( ! compile(file.fileName(), libFile, compiler) ) return false;
+    }
+  else
+    qDebug() << "CompiledModel::load: reusing" << libFile;
+  lib.setFileName(libFile);
+  typedef int (*AbiFn)();
+  AbiFn abi = (AbiFn)lib.resolve("grasp_sim_abi");
+  init = (InitFn)lib.resolve("grasp_sim_init");
+  react = (ReactFn)lib.resolve("grasp_sim_react");
+  if ( ! abi || ! init || ! react || abi() != abiVersion ) {
+    errors << "cannot load " + libFile + " (" + lib.errorString() + ")";
+    init = NULL;
+    react = NULL;
+    return false;
+    }
+  return true;
+}
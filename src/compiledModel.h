@@ -0,0 +1,87 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QSet>
+#include <QHash>
+#include <QLibrary>
+
+class ModelTables;
+class Expr;
+class Action;
+class Valuation;
+
+// Native code version of a model, for the compiled simulation mode.
+//
+// The lowered model (see [ModelTables]) is translated to a C++ unit, in which each automaton is
+// a function switching on its current state, guards and actions being inlined. This unit is
+// compiled to a shared library by the system C++ compiler and loaded with [QLibrary].
+// Libraries are kept in a cache directory, named after a hash of the generated source, so that
+// the compiler is only invoked when the model (or the simulation options) change.
+//
+// The library exports two functions, operating on the store and current states of the simulator
+// (see [Simulator] for the semantics)
+//   int grasp_sim_init(int *store, int *states, const GraspSimTrace *trace, int *info)
+//   int grasp_sim_react(int *store, int *states, const int *events, int nbEvents, const GraspSimTrace *trace, int *info)
+// Both return the number of fired transitions or a negative error code (see [Error]).
+// For [NonDeterministic], [info] gives the FSM and the ids of the conflicting transitions.
+
+struct GraspSimTrace {
+  void *data;
+  void (*change)(void *data, int slot, int value);
+  void (*event)(void *data, int event);
+  void (*state)(void *data, int fsm, int state);
+};
+
+class CompiledModel
+{
+public:
+  enum Error {
+    NonDeterministic = -1,
+    TooManyMicroSteps = -2,
+    DivisionByZero = -3,
+    Overflow = -4,       // INT_MIN / -1
+    InvalidShift = -5,   // Shift count or bit index outside 0..31
+    InvalidRange = -6    // Bit range [hi:lo] not within 31..0
+  };
+
+  CompiledModel(ModelTables *tables, bool synchronousActions = false);
+
+  QString source();
+  bool load(QString cacheDir, QString compiler); // false on error (see [getErrors])
+  QStringList getErrors() { return errors; }
+
+  typedef int (*InitFn)(int *store, int *states, const GraspSimTrace *trace, int *info);
+  typedef int (*ReactFn)(int *store, int *states, const int *events, int nbEvents, const GraspSimTrace *trace, int *info);
+  InitFn init;
+  ReactFn react;
+
+  static const int abiVersion;
+  static const int compileTimeout;
+
+private:
+  ModelTables *tables;
+  bool synchronousActions;
+  QLibrary lib;
+  QStringList errors;
+  QHash<int,QString> shadows; // Global slot -> C expression, for sequential actions
+
+  QString expr(const Expr *e, int fsm);
+  QString lvalue(QString id, int fsm);
+  QString actions(const QList<Action*>& actions, int fsm, QString indent);
+  QString valuations(const QList<Valuation*>& valuations, int fsm, QString indent);
+  QString fsmFunction(int fsm);
+  bool compile(QString srcFile, QString libFile, QString compiler);
+};
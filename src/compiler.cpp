@@ -15,8 +15,14 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QDebug>
-#include <QMessageBox>
+#include <QTemporaryFile>
+#include <QTextStream>
 #include "commandExec.h"
+#include "compilerSession.h"
+#include "globals.h"
+#include "compilerOptions.h"
+#include <QDir>
+#include <algorithm>
 
 // static const Compiler::QString name = "rfsmc";
 
@@ -24,16 +30,56 @@ Compiler::Compiler(QString path)
 {
   this->path = path;
   executor = new CommandExec();
+  session = new CompilerSession(path);
+  pool = new CompilerPool(path);
 }
 
 Compiler::~Compiler()
 {
+  delete pool;
+  delete session;
   delete executor;
 }
 
 void Compiler::setPath(QString path)
 {
   this->path = path;
+  session->setPath(path);
+  pool->setPath(path);
+}
+
+// Arguments for generating code for [target], built from the current compiler options.
+// With option [-target_dirs], the target directory is created in [wDir] if needed
+
+QStringList Compiler::targetArgs(QString target, QString mainName, QString wDir)
+{
+  QStringList genOpts = Globals::compilerOptions->getOptions("general");
+  QString targetDir = ".";
+  if ( target != "sim" && genOpts.contains("-target_dirs") ) {
+    targetDir = target;
+    QString targetPath = wDir + "/" + target; // TO FIX : do not use raw, OS-dependent "/" in file path
+    genOpts.removeOne("-target_dirs");
+    QDir dir(targetPath);
+    if ( ! dir.exists() ) {
+      qDebug() << "Creating directory " << targetPath;
+      QDir().mkdir(targetPath);
+      }
+    }
+  foreach ( QString opt, genOpts)
+    if ( genOpts.contains(opt) ) genOpts.removeOne(opt);
+  QStringList args =
+    QStringList()
+    << "-" + target
+    << "-main" << mainName
+    << "-target_dir" << targetDir
+    << genOpts
+    << Globals::compilerOptions->getOptions(target);
+  foreach ( QString opt, Globals::guiOnlyOpts ) {
+    args.removeAll(opt);
+    args.erase(std::remove_if(args.begin(), args.end(), [&](const QString& a) { return a.startsWith(opt + " "); }), args.end());
+    }
+  if ( target == "ctask" || target == "systemc" ) args << "-show_models";
+  return args;
 }
 
 bool Compiler::run(QString sFname, QStringList args, QString wDir)
@@ -41,6 +87,37 @@ bool Compiler::run(QString sFname, QStringList args, QString wDir)
   return executor->execute(wDir, path, args << "-gui" << sFname);
 }
 
+bool Compiler::checkFragment(QString fragment, QStringList& errors, bool batch)
+{
+  bool verdict = false;
+  if ( session->check(fragment, verdict, errors) ) return verdict;
+  // No server mode available. Fall back to one [-check_fragment] invocation per fragment
+  QTemporaryFile file;
+  //file.setAutoRemove(false); // For debug only
+  if ( ! file.open() ) return false;
+  QTextStream os(&file);
+  os << fragment;
+  os.flush();
+  file.close();
+  verdict = run(file.fileName(), QStringList() << (batch ? "-check_fragments" : "-check_fragment"), ".");
+  errors = getErrors();
+  return verdict;
+}
+
+bool Compiler::checkFragments(QList<CompilerPool::Job>& jobs)
+{
+  if ( session->isAvailable() ) {
+    // A single server process answers much faster than a pool of fresh ones
+    bool ok = true;
+    for ( CompilerPool::Job& job : jobs ) {
+      job.done = session->check(job.text, job.verdict, job.errors);
+      ok = ok && job.done;
+      }
+    return ok;
+    }
+  return pool->run(jobs);
+}
+
 QStringList Compiler::getOutputs()
 {
   return executor->getOutputs();
@@ -58,7 +135,7 @@ QStringList Compiler::getOutputFiles(QString target, QString wDir, QString model
   QStringList res;
   qDebug() << "Output files: rfile=" << rfile;
   if ( ! ff.exists() ) {
-      QMessageBox::warning(NULL, "", "Compiler cannot open file " + rfile);
+      Globals::warning("", "Compiler cannot open file " + rfile);
       return res;
     }
   ff.open(QIODevice::ReadOnly | QIODevice::Text);
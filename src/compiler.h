@@ -13,8 +13,10 @@
 
 #include <QString>
 #include <QProcess>
+#include "compilerPool.h"
 
 class CommandExec;
+class CompilerSession;
 
 class Compiler : QObject
 {
@@ -27,12 +29,18 @@ public:
   ~Compiler();
 
   void setPath(QString path);
+  QString getPath() const { return path; }
   
   bool run(QString srcFile, QStringList args, QString wDir);
+  QStringList targetArgs(QString target, QString mainName, QString wDir);
+  bool checkFragment(QString fragment, QStringList& errors, bool batch=false);
+  bool checkFragments(QList<CompilerPool::Job>& jobs); // Independent fragments
   QStringList getOutputs();
   QStringList getErrors();
   QStringList getOutputFiles(QString target, QString wDir, QString modelName);
 private:
   QString path;
   CommandExec* executor;
+  CompilerSession* session; // For checking fragments without spawning a process each time
+  CompilerPool* pool; // For checking independent fragments concurrently when no session is available
 };
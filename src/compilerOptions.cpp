@@ -20,6 +20,7 @@
 
 #include "qt_compat.h"
 #include "compilerOptions.h"
+#include "globals.h"
 
 CompilerOptions::CompilerOptions(QString specFile, QWidget *parent)
 {
@@ -37,7 +38,7 @@ void CompilerOptions::readSpecFile(QString fname)
   QFile file(fname);
   file.open(QIODevice::ReadOnly);
   if ( file.error() != QFile::NoError ) {
-    QMessageBox::warning(parent, "","Cannot read specification file " + file.fileName());
+    Globals::warning("","Cannot read specification file " + file.fileName());
     return;
   }
   qDebug() << "Reading options from" << fname;
@@ -72,7 +73,7 @@ void CompilerOptions::readFromFile(QString fname)
   QFile file(fname);
   file.open(QIODevice::ReadOnly);
   if ( file.error() != QFile::NoError ) {
-    QMessageBox::warning(parent, "","Cannot read file " + file.fileName());
+    Globals::warning("","Cannot read file " + file.fileName());
     return;
     }
   while ( ! file.atEnd() ) {
@@ -258,7 +259,8 @@ QStringList CompilerOptions::getOptions(QString category)
 
 void CompilerOptions::logMessage(QString msg)
 {
-  qobject_cast<QMainWindow*>(parent)->statusBar()->showMessage(msg);
+  QMainWindow *w = qobject_cast<QMainWindow*>(parent);
+  if ( w ) w->statusBar()->showMessage(msg); // No status bar in batch mode
 }
 
 void CompilerOptions::dump() // For debug only
@@ -27,6 +27,7 @@ public:
 
     void edit(QWidget *parent);
     QStringList getOptions(QString category);
+    void readFromFile(QString fname);
 
 private slots:
   void stringValueChanged(const QString);
@@ -41,7 +42,6 @@ private:
     QMap<QString,CompilerOption> options;
     QMap<QString,CompilerOption> editedOptions;
     void readSpecFile(QString fname);
-    void readFromFile(QString fname);
     void saveToFile(QString fname);
     void addTab(QString title, QString category, QTabWidget *tabs, QWidget *parent);
     void logMessage(QString msg);
@@ -23,6 +23,7 @@ static const QString defaultCompiler = "rfsmc";  // Fall-back, default values
 static const QString defaultDotProgram = "dot";
 static const QString defaultDotViewer = "graphviz";
 static const QString defaultVcdViewer = "gtkwave";
+static const QString defaultCxxCompiler = "c++"; // For the compiled simulation mode
 
 CompilerPaths::CompilerPaths(QString iniFile, QWidget *parent) : parent(parent)
 {
@@ -44,6 +45,7 @@ void CompilerPaths::setDefaults()
   paths.insert("DOTVIEWER", defaultDotViewer);
 #endif
   paths.insert("VCDVIEWER", defaultDotViewer);
+  paths.insert("CXXCOMPILER", defaultCxxCompiler);
   paths.insert("INITDIR", "");
 }
 
@@ -164,7 +166,8 @@ QString CompilerPaths::getPath(QString name)
 
 void CompilerPaths::logMessage(QString msg)
 {
-  qobject_cast<QMainWindow*>(parent)->statusBar()->showMessage(msg);
+  QMainWindow *w = qobject_cast<QMainWindow*>(parent);
+  if ( w ) w->statusBar()->showMessage(msg); // No status bar in batch mode
 }
 
   
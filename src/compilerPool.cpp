@@ -0,0 +1,82 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "compilerPool.h"
+#include <QProcess>
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <QThread>
+#include <QQueue>
+#include <QDebug>
+#include "qt_compat.h"
+
+const int CompilerPool::jobTimeout = 30000; // ms
+
+CompilerPool::CompilerPool(QString path, int size)
+{
+  this->path = path;
+  this->size = size > 0 ? size : qMax(1, QThread::idealThreadCount());
+}
+
+// Returns true iff all the jobs could be run (whatever their verdict)
+
+bool CompilerPool::run(QList<Job>& jobs)
+{
+  struct Running {
+    int job;
+    QProcess *proc;
+    QTemporaryFile *file;
+  };
+  QQueue<Running> running;
+  int next = 0;
+  bool ok = true;
+  qDebug() << "CompilerPool::run:" << jobs.length() << "jobs," << size << "workers";
+  while ( next < jobs.length() || ! running.isEmpty() ) {
+    // Fill the pool
+    while ( next < jobs.length() && running.length() < size ) {
+      Running r;
+      r.job = next++;
+      r.file = new QTemporaryFile();
+      if ( ! r.file->open() ) {
+        delete r.file;
+        ok = false;
+        continue;
+        }
+      QTextStream os(r.file);
+      os << jobs[r.job].text;
+      os.flush();
+      r.file->close();
+      r.proc = new QProcess();
+      r.proc->setProcessChannelMode(QProcess::SeparateChannels);
+      r.proc->start(path, QStringList() << "-check_fragment" << "-gui" << r.file->fileName());
+      running.enqueue(r);
+      }
+    if ( running.isEmpty() ) break;
+    // Wait for the oldest one. Others keep on running meanwhile
+    Running r = running.dequeue();
+    Job& job = jobs[r.job];
+    if ( r.proc->waitForStarted() && r.proc->waitForFinished(jobTimeout) ) {
+      job.done = true;
+      job.verdict = r.proc->exitStatus() == QProcess::NormalExit && r.proc->exitCode() == 0;
+      job.errors = QString(r.proc->readAllStandardError()).split("\n", SKIP_EMPTY_PARTS);
+      }
+    else {
+      qDebug() << "CompilerPool: job" << r.job << "failed:" << r.proc->errorString();
+      r.proc->kill();
+      r.proc->waitForFinished();
+      ok = false;
+      }
+    delete r.proc;
+    delete r.file;
+    }
+  return ok;
+}
@@ -0,0 +1,47 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+// A pool of [rfsmc -check_fragment] processes, used for checking a set of independent fragments
+// when the compiler does not support the server mode.
+// At most [size] processes are running at the same time (by default, the number of cores).
+// Results are stored in the submitted jobs, so that they can be exploited in submission order
+// whatever the order of completion.
+
+class CompilerPool
+{
+public:
+  struct Job {
+    Job(QString text) : text(text), verdict(false), done(false) { };
+    QString text;         // Fragment file content
+    bool verdict;
+    QStringList errors;
+    bool done;            // false if the compiler could not be run
+  };
+
+  CompilerPool(QString path, int size = 0);
+
+  void setPath(QString path) { this->path = path; }
+  int getSize() const { return size; }
+  bool run(QList<Job>& jobs);
+
+private:
+  QString path;
+  int size;
+
+  static const int jobTimeout;
+};
@@ -0,0 +1,109 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "compilerSession.h"
+#include <QDebug>
+
+const int CompilerSession::startTimeout = 2000; // ms
+const int CompilerSession::replyTimeout = 5000; // ms
+
+CompilerSession::CompilerSession(QString path)
+{
+  this->path = path;
+  unsupported = false;
+}
+
+void CompilerSession::setPath(QString path)
+{
+  stop();
+  this->path = path;
+  unsupported = false; // Give the new compiler a chance
+}
+
+bool CompilerSession::isAvailable()
+{
+  return start();
+}
+
+bool CompilerSession::start()
+{
+  if ( proc.state() == QProcess::Running ) return true;
+  if ( unsupported ) return false;
+  qDebug() << "CompilerSession: starting" << path << "in server mode";
+  proc.setProcessChannelMode(QProcess::SeparateChannels);
+  proc.setReadChannel(QProcess::StandardOutput);
+  proc.start(path, QStringList() << "-server" << "-gui");
+  if ( ! proc.waitForStarted(startTimeout) ) {
+    qDebug() << "CompilerSession: failed to start";
+    unsupported = true;
+    return false;
+    }
+  QString line;
+  if ( readLine(line) && line == "-- ready" ) return true;
+  qDebug() << "CompilerSession: server mode not supported by" << path;
+  stop();
+  unsupported = true;
+  return false;
+}
+
+void CompilerSession::stop()
+{
+  if ( proc.state() == QProcess::NotRunning ) return;
+  proc.closeWriteChannel();
+  if ( ! proc.waitForFinished(startTimeout) ) {
+    proc.kill();
+    proc.waitForFinished();
+    }
+}
+
+bool CompilerSession::readLine(QString& line)
+{
+  while ( ! proc.canReadLine() ) {
+    if ( proc.state() != QProcess::Running ) return false;
+    if ( ! proc.waitForReadyRead(replyTimeout) ) return false;
+    }
+  line = QString::fromUtf8(proc.readLine()).trimmed();
+  return true;
+}
+
+bool CompilerSession::exchange(QString request, bool& verdict, QStringList& errors)
+{
+  errors.clear();
+  if ( ! request.endsWith("\n") ) request += "\n";
+  proc.write(request.toUtf8());
+  proc.write("-- end\n");
+  proc.waitForBytesWritten(replyTimeout);
+  QString line;
+  while ( readLine(line) ) {
+    if ( line == "-- ok" ) { verdict = true; return true; }
+    if ( line == "-- error" ) { verdict = false; return true; }
+    if ( ! line.isEmpty() ) errors << line;
+    }
+  return false; // Child process died or stalled
+}
+
+bool CompilerSession::check(QString fragment, bool& verdict, QStringList& errors)
+{
+  for ( int attempt = 0; attempt < 2; attempt++ ) { // Restart (once) if the child process died
+    if ( ! start() ) return false;
+    if ( exchange(fragment, verdict, errors) ) return true;
+    qDebug() << "CompilerSession: lost child process (" << proc.exitStatus() << "). Restarting";
+    proc.kill();
+    proc.waitForFinished();
+    }
+  return false;
+}
+
+CompilerSession::~CompilerSession()
+{
+  stop();
+}
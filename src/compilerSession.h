@@ -0,0 +1,56 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QProcess>
+
+// A long-lived [rfsmc -server] process used for checking syntax fragments.
+//
+// Protocol (line-based, on the child stdin/stdout) :
+// - once started, the server writes a line "-- ready"
+// - each request is the text of a fragment file (as built by the [FragmentChecker]),
+//   followed by a line "-- end"
+// - each reply is a (possibly empty) list of diagnostic lines, followed by a line
+//   "-- ok" or "-- error"
+// - batch requests (numbered fragments, see [FragmentChecker::check_batch]) follow the same
+//   protocol, the server tagging each diagnostic line with the fragment number
+// If the compiler does not support the server mode (no "-- ready" line), the session is
+// flagged as unavailable and the caller must fall back to the [-check_fragment] mode.
+
+class CompilerSession : public QObject
+{
+  Q_OBJECT
+
+public:
+  CompilerSession(QString path);
+  ~CompilerSession();
+
+  void setPath(QString path);
+  bool isAvailable();
+  bool check(QString fragment, bool& verdict, QStringList& errors);
+
+private:
+  bool start();
+  void stop();
+  bool exchange(QString request, bool& verdict, QStringList& errors);
+  bool readLine(QString& line);
+
+  QString path;
+  QProcess proc;
+  bool unsupported;
+
+  static const int startTimeout;
+  static const int replyTimeout;
+};
@@ -17,6 +17,7 @@
 #include <QPushButton>
 #include <QBoxLayout>
 #include <QHBoxLayout>
+#include <QLineEdit>
 #include <QtDebug>
 
 DynamicPanel::DynamicPanel(QString title) : QGroupBox(title)
@@ -49,9 +50,30 @@ QHBoxLayout* DynamicPanel::addRow(void *row_data) {
   connect(delButton, &QPushButton::clicked, this, &DynamicPanel::deleteRow);
   mButtonToLayoutMap.insert(delButton, row_layout);
   layout->insertLayout(layout->count(), row_layout); // Add to bottom
+  QLineEdit* field = qobject_cast<QLineEdit*>(row_layout->itemAt(0)->widget());
+  if ( field ) connect(field, &QLineEdit::textChanged, this, &DynamicPanel::modified);
+  emit modified();
   return row_layout;
 }
 
+QList<QLineEdit*> DynamicPanel::lineEdits()
+{
+  QList<QLineEdit*> r;
+  for ( int i=1; i<layout->count(); i++ ) { // Exclude first row, carrying panel buttons
+    QHBoxLayout* row = static_cast<QHBoxLayout*>(layout->itemAt(i));
+    Q_ASSERT(row);
+    QLineEdit* field = qobject_cast<QLineEdit*>(row->itemAt(0)->widget());
+    if ( field ) r.append(field);
+    }
+  return r;
+}
+
+void DynamicPanel::markField(QLineEdit *field, QStringList errors)
+{
+  field->setStyleSheet(errors.isEmpty() ? "" : "QLineEdit { border: 1px solid red; }");
+  field->setToolTip(errors.join("\n"));
+}
+
 void DynamicPanel::addNewRow()
 {
   QHBoxLayout *row_layout = addRow(nullptr);
@@ -76,6 +98,7 @@ void DynamicPanel::deleteRow()
   QPushButton* button = qobject_cast<QPushButton*>(sender());
   QHBoxLayout* row_layout = static_cast<QHBoxLayout*>(mButtonToLayoutMap.take(button));
   DynamicPanel::delete_row(row_layout);
+  emit modified();
 }
 
 void DynamicPanel::clear()
@@ -86,6 +109,7 @@ void DynamicPanel::clear()
     qDebug() << "DynamicPanel: deleting row" << row->objectName();
     delete_row(row);
   }
+  emit modified();
 }
 
 DynamicPanel::~DynamicPanel()
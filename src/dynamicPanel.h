@@ -14,11 +14,13 @@
 
 #include <QGroupBox>
 #include <QMap>
+#include <QStringList>
 
 class QPushButton;
 class QBoxLayout;
 class QVBoxLayout;
 class QHBoxLayout;
+class QLineEdit;
 
 class DynamicPanel : public QGroupBox
 {
@@ -40,7 +42,12 @@ public slots:
   void clear();
   QHBoxLayout *addRow(void *row_data);
 
+public:
+  QList<QLineEdit*> lineEdits(); // First field of each row, when it is a line editor
+  static void markField(QLineEdit *field, QStringList errors); // Inline error marker
+
 signals:
+  void modified(); // A row has been added, removed or edited
     
 protected slots:
   void addNewRow();
@@ -0,0 +1,424 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+
+#include "explorer.h"
+#include "fsmTable.h"
+#include "clusterScheduler.h"
+#include "model.h"
+#include "iov.h"
+#include "transition.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QThread>
+#include <QMutexLocker>
+#include <QDebug>
+#include <stdexcept>
+#include "qt_compat.h"
+
+const int Explorer::nbShards;
+const int Explorer::maxIds;
+const int Explorer::maxValuations = 4096; // Combinations of input values tried at each step
+const int Explorer::maxTraces = 10;       // Counterexamples kept, for deadlocks and for errors
+const int Explorer::maxMicroSteps = 1000; // As in [Simulator]
+
+Explorer::Explorer(Model *model, bool synchronousActions)
+{
+  this->model = model;
+  this->synchronousActions = synchronousActions;
+  this->intMax = 3;
+  this->maxStates = 1000000;
+  this->nbThreads = qMax(1, QThread::idealThreadCount());
+  this->tables = NULL;
+  this->nbValuations = 1;
+  this->nbSteps = 0;
+  this->depth = 0;
+  this->complete = true;
+}
+
+Explorer::~Explorer()
+{
+  delete tables;
+}
+
+// Configurations
+
+void Explorer::setInputs(int valuation, int *store) const
+{
+  for ( int j=0; j<inSlots.size(); j++ ) {
+    store[inSlots.at(j)] = valuation % inDomains.at(j);
+    valuation /= inDomains.at(j);
+    }
+}
+
+QVector<int> Explorer::encode(const QVector<int>& current, const QVector<int>& store) const
+{
+  QVector<int> c = current;
+  c.reserve(current.size() + configSlots.size());
+  foreach ( int s, configSlots ) c.append(store.at(s));
+  return c;
+}
+
+void Explorer::decode(const QVector<int>& config, QVector<int>& current, QVector<int>& store) const
+{
+  int n = tables->fsms.length();
+  current = config.mid(0, n);
+  store = tables->initValues;
+  for ( int i=0; i<configSlots.size(); i++ ) store[configSlots.at(i)] = config.at(n+i);
+}
+
+QString Explorer::describe(const QVector<int>& config) const
+{
+  QStringList r;
+  foreach ( const FsmTable *fsm, tables->fsms ) r << fsm->name + "." + fsm->stateNames.at(config.at(fsm->fsm));
+  return r.join(", ");
+}
+
+// Sharded set. Identifiers are given by the rank of the configuration in its shard and the shard itself.
+// The shard is selected with a hash seeded differently from that used inside the shard, so that the keys
+// of a shard are still spread over its buckets
+
+int Explorer::insert(const QVector<int>& config, const Node& node, bool& added)
+{
+  added = false;
+  int s = qHash(config, 0x9e3779b9u) % nbShards;
+  Shard& shard = shards[s];
+  QMutexLocker lock(&shard.mutex);
+  auto i = shard.index.constFind(config);
+  if ( i != shard.index.constEnd() ) return i.value() * nbShards + s;
+  if ( nbStates.fetchAndAddOrdered(1) >= maxStates ) {
+    nbStates.fetchAndAddOrdered(-1);
+    full.storeRelease(1);
+    return -1;
+    }
+  int r = shard.configs.length();
+  shard.index.insert(config, r);
+  shard.configs.append(config);
+  shard.nodes.append(node);
+  added = true;
+  return r * nbShards + s;
+}
+
+QVector<int> Explorer::config(int id)
+{
+  Shard& shard = shards[id % nbShards];
+  QMutexLocker lock(&shard.mutex);
+  return shard.configs.at(id / nbShards);
+}
+
+QList<QPair<int,int>> Explorer::path(int id)
+{
+  QList<QPair<int,int>> steps;
+  while ( id >= 0 ) {
+    Shard& shard = shards[id % nbShards];
+    QMutexLocker lock(&shard.mutex);
+    const Node& n = shard.nodes.at(id / nbShards);
+    if ( n.parent >= 0 ) steps.prepend(QPair<int,int>(n.event, n.valuation));
+    id = n.parent;
+    }
+  return steps;
+}
+
+// Reaction to input event [event], as in [Simulator::react] (without trace). Returns false on error
+
+bool Explorer::react(QVector<int>& current, QVector<int>& store, int event, bool& fired, QString& error) const
+{
+  const Bytecode& code = tables->code;
+  QVector<int> events = { event };
+  QVector<QPair<int,int>> updates;
+  QVector<int> emitted;
+  Bytecode::Context ctx = { store.data(), &updates, &emitted };
+  QVector<int> dst(tables->fsms.length());
+  fired = false;
+  try {
+    for ( int step=0; ! events.isEmpty(); step++ ) {
+      if ( step >= maxMicroSteps ) {
+        error = "too many micro-steps (instantaneous loop on shared events ?)";
+        return false;
+        }
+      updates.clear();
+      emitted.clear();
+      dst.fill(-1);
+      foreach ( const FsmTable *fsm, tables->fsms ) {
+        const FsmTable::Entry *f = NULL;
+        foreach ( int ev, events ) {
+          const FsmTable::Cell& cell = fsm->cell(current.at(fsm->fsm), ev);
+          for ( int i=cell.first; i<cell.first+cell.count; i++ ) {
+            const FsmTable::Entry& e = fsm->entries.at(i);
+            if ( ! code.run(e.guard, ctx) ) continue;
+            if ( f ) {
+              error = fsm->name + ": non deterministic transitions " + fsm->transitions.at(f->id)->toString()
+                                                             + " and " + fsm->transitions.at(e.id)->toString();
+              return false;
+              }
+            f = &e;
+            }
+          }
+        if ( ! f ) continue;
+        code.run(f->action, ctx);
+        code.run(fsm->enter.at(f->dst), ctx);
+        dst[fsm->fsm] = f->dst;
+        fired = true;
+        }
+      for ( int i=0; i<dst.size(); i++ )
+        if ( dst.at(i) >= 0 ) current[i] = dst.at(i);
+      foreach ( const auto& u, updates ) store[u.first] = u.second;
+      QVector<int> next;
+      foreach ( int e, emitted )
+        if ( tables->sharedEvent.at(e) && ! next.contains(e) ) next.append(e);
+      events = next;
+      }
+    }
+  catch ( std::runtime_error& e ) {
+    error = QString::fromStdString(e.what());
+    return false;
+    }
+  return true;
+}
+
+// Successors of configuration [id], for all input events and values. New configurations are added to [next]
+
+void Explorer::expand(int id, QVector<int>& next, qint64& steps)
+{
+  QVector<int> c = config(id);
+  QVector<int> current, store;
+  bool live = false;
+  for ( int e=0; e<inEvents.size(); e++ )
+    for ( int v=0; v<nbValuations; v++ ) {
+      decode(c, current, store);
+      setInputs(v, store.data());
+      bool fired;
+      QString error;
+      if ( ! react(current, store, inEvents.at(e), fired, error) ) {
+        resultsMutex.lock();
+        bool known = failures.length() >= maxTraces;
+        foreach ( const Counterexample& f, failures ) known |= f.description == error;
+        resultsMutex.unlock();
+        if ( known ) continue;
+        Counterexample cex = counterexample(id, error, e, v);
+        QMutexLocker lock(&resultsMutex);
+        bool again = false;
+        foreach ( const Counterexample& f, failures ) again |= f.description == error;
+        if ( ! again && failures.length() < maxTraces ) failures.append(cex);
+        continue;
+        }
+      steps++;
+      if ( ! fired ) continue; // Same configuration
+      live = true;
+      bool added;
+      int n = insert(encode(current, store), Node { id, e, v }, added);
+      if ( added ) next.append(n);
+      }
+  if ( live ) return;
+  QString d = "deadlock in " + describe(c);
+  resultsMutex.lock();
+  bool known = deadlocks.length() >= maxTraces;
+  foreach ( const Counterexample& k, deadlocks ) known |= k.description == d;
+  resultsMutex.unlock();
+  if ( known ) return;
+  Counterexample cex = counterexample(id, d);
+  QMutexLocker lock(&resultsMutex);
+  bool again = false;
+  foreach ( const Counterexample& k, deadlocks ) again |= k.description == d;
+  if ( ! again && deadlocks.length() < maxTraces ) deadlocks.append(cex);
+}
+
+// Stimuli reaching configuration [id] (then performing step [event]/[valuation], if given): the i-th
+// reaction occurs at date 10*i
+
+Explorer::Counterexample Explorer::counterexample(int id, QString description, int event, int valuation)
+{
+  const int period = 10;
+  QList<QPair<int,int>> steps = path(id);
+  if ( event >= 0 ) steps.append(QPair<int,int>(event, valuation));
+  Counterexample c;
+  c.description = description;
+  c.length = steps.length();
+  foreach ( Iov *io, model->getIos() ) {
+    if ( io->kind != Iov::IoIn ) continue;
+    QString stim;
+    int e = inEventNames.indexOf(io->name);
+    int j = inNames.indexOf(io->name);
+    for ( int k=0, last=-1; k<steps.length(); k++ ) {
+      int t = (k+1) * period;
+      if ( e >= 0 && steps.at(k).first == e ) stim += " " + QString::number(t);
+      if ( j < 0 ) continue;
+      int v = steps.at(k).second;
+      for ( int i=0; i<j; i++ ) v /= inDomains.at(i);
+      v %= inDomains.at(j);
+      if ( v != last ) stim += " " + QString::number(t) + " " + QString::number(v);
+      last = v;
+      }
+    if ( stim.isEmpty() ) stim = "None";
+    else stim.prepend(io->type == Iov::TyEvent ? "Sporadic" : "ValueChanges");
+    c.stimuli.append(QPair<QString,QString>(io->name, stim));
+    }
+  return c;
+}
+
+// Search
+
+bool Explorer::run(std::function<bool(int)> progress)
+{
+  errors.clear();
+  deadlocks.clear();
+  failures.clear();
+  unreachable.clear();
+  for ( int s=0; s<nbShards; s++ ) {
+    shards[s].index.clear();
+    shards[s].configs.clear();
+    shards[s].nodes.clear();
+    }
+  nbStates.storeRelease(0);
+  full.storeRelease(0);
+  nbSteps = 0;
+  depth = 0;
+  complete = true;
+  delete tables;
+  tables = new ModelTables(model, synchronousActions);
+  if ( ! tables->build() ) {
+    errors = tables->getErrors();
+    return false;
+    }
+  const SymbolTable& syms = tables->syms;
+  // Inputs, and slots making up a configuration
+  inEvents.clear();
+  inEventNames.clear();
+  inSlots.clear();
+  inDomains.clear();
+  inNames.clear();
+  nbValuations = 1;
+  QVector<bool> saved(syms.getNbSlots(), true);
+  foreach ( int s, syms.scratchSlots() ) saved[s] = false;
+  foreach ( Iov *io, model->getIos() ) {
+    if ( io->kind != Iov::IoIn ) continue;
+    if ( io->type == Iov::TyEvent ) {
+      if ( syms.event(io->name) < 0 ) continue; // Not used by the automata
+      inEvents.append(syms.event(io->name));
+      inEventNames.append(io->name);
+      continue;
+      }
+    int slot = syms.global(io->name);
+    if ( slot < 0 ) continue;
+    saved[slot] = false;
+    inSlots.append(slot);
+    inNames.append(io->name);
+    inDomains.append(io->type == Iov::TyBool ? 2 : intMax + 1);
+    if ( qint64(nbValuations) * inDomains.last() > maxValuations ) {
+      errors << "too many combinations of input values (max " + QString::number(maxValuations) + "); reduce the range of integer inputs";
+      return false;
+      }
+    nbValuations *= inDomains.last();
+    }
+  configSlots.clear();
+  for ( int s=0; s<saved.size(); s++ )
+    if ( saved.at(s) ) configSlots.append(s);
+  // Initial configuration
+  QVector<int> store = tables->initValues;
+  QVector<int> current(tables->fsms.length(), -1);
+  QVector<QPair<int,int>> updates;
+  QVector<int> emitted;
+  Bytecode::Context ctx = { store.data(), &updates, &emitted };
+  try {
+    foreach ( const FsmTable *fsm, tables->fsms ) {
+      tables->code.run(fsm->initAction, ctx);
+      tables->code.run(fsm->enter.at(fsm->initState), ctx);
+      current[fsm->fsm] = fsm->initState;
+      }
+    }
+  catch ( std::runtime_error& e ) {
+    errors << "initialisation: " + QString::fromStdString(e.what());
+    return false;
+    }
+  foreach ( const auto& u, updates ) store[u.first] = u.second;
+  bool added;
+  QVector<int> frontier = { insert(encode(current, store), Node { -1, -1, -1 }, added) };
+  // Breadth-first search, each level being shared among the threads by chunks of configurations
+  QList<QVector<int>> jobs;
+  for ( int i=0; i<qMax(1, nbThreads); i++ ) jobs.append(QVector<int>({ i }));
+  ClusterScheduler scheduler(jobs, jobs.length());
+  bool aborted = false;
+  while ( ! frontier.isEmpty() ) {
+    QVector<QVector<int>> next(jobs.length());
+    QVector<qint64> steps(jobs.length(), 0);
+    QVector<int> *nx = next.data(); // Each job appends to its own list (no detach)
+    qint64 *st = steps.data();
+    QAtomicInt cursor(0);
+    const int chunk = 64;
+    scheduler.run([&](const QVector<int>& job) {
+      int w = job.first(), i;
+      while ( (i = cursor.fetchAndAddOrdered(chunk)) < frontier.size() )
+        for ( int k=i; k<qMin(i+chunk, frontier.size()); k++ ) expand(frontier.at(k), nx[w], st[w]);
+      });
+    frontier.clear();
+    for ( int w=0; w<jobs.length(); w++ ) {
+      frontier += next.at(w);
+      nbSteps += steps.at(w);
+      }
+    if ( ! frontier.isEmpty() ) depth++;
+    if ( progress && ! progress(nbStates.loadAcquire()) ) {
+      aborted = true;
+      break;
+      }
+    }
+  complete = ! full.loadAcquire() && ! aborted;
+  // Automaton states never reached
+  QVector<QVector<bool>> seen;
+  foreach ( const FsmTable *fsm, tables->fsms ) seen.append(QVector<bool>(fsm->nbStates, false));
+  for ( int s=0; s<nbShards; s++ )
+    foreach ( const QVector<int>& c, shards[s].configs )
+      for ( int i=0; i<seen.size(); i++ ) seen[i][c.at(i)] = true;
+  foreach ( const FsmTable *fsm, tables->fsms )
+    for ( int k=0; k<fsm->nbStates; k++ )
+      if ( ! seen.at(fsm->fsm).at(k) ) unreachable << fsm->name + "." + fsm->stateNames.at(k);
+  qDebug() << "Explorer::run:" << nbStates.loadAcquire() << "configurations," << nbSteps << "reactions, depth" << depth;
+  return ! aborted;
+}
+
+// Report
+
+bool Explorer::writeReport(QString fname, QStringList& files)
+{
+  QFile file(fname);
+  if ( ! file.open(QIODevice::WriteOnly | QIODevice::Text) ) {
+    errors << "cannot write file " + fname;
+    return false;
+    }
+  QFileInfo fi(fname);
+  QString base = fi.path() + "/" + fi.completeBaseName();
+  QTextStream os(&file);
+  os << "Configurations: " << nbStates.loadAcquire() << (complete ? "" : " (incomplete exploration)") << QT_ENDL;
+  os << "Reactions: " << nbSteps << ", depth: " << depth << QT_ENDL;
+  os << "Inputs: " << inEventNames.length() << " event(s), " << nbValuations << " combination(s) of values (integers in 0.." << intMax << ")" << QT_ENDL;
+  os << "Unreachable states: " << (unreachable.isEmpty() ? "none" : unreachable.join(", ")) << QT_ENDL;
+  QList<const Counterexample*> all;
+  for ( const Counterexample& c : deadlocks ) all.append(&c);
+  for ( const Counterexample& c : failures ) all.append(&c);
+  os << "Deadlocks: " << deadlocks.length() << (deadlocks.length() >= maxTraces ? " (or more)" : "") << QT_ENDL;
+  os << "Errors: " << failures.length() << (failures.length() >= maxTraces ? " (or more)" : "") << QT_ENDL;
+  for ( int k=0; k<all.length(); k++ ) {
+    const Counterexample& c = *all.at(k);
+    QString sFile = base + "_" + QString::number(k+1) + ".sweep";
+    QFile sf(sFile);
+    if ( ! sf.open(QIODevice::WriteOnly | QIODevice::Text) ) {
+      errors << "cannot write file " + sFile;
+      return false;
+      }
+    QTextStream ss(&sf);
+    ss << "# " << c.description << " (after " << c.length << " reaction(s))" << QT_ENDL;
+    for ( const auto& s : c.stimuli ) ss << s.first << ": " << s.second << QT_ENDL;
+    os << "  " << c.description << " (after " << c.length << " reaction(s)): " << QFileInfo(sFile).fileName() << QT_ENDL;
+    files << sFile;
+    }
+  return true;
+}
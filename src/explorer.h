@@ -0,0 +1,136 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QPair>
+#include <QVector>
+#include <QHash>
+#include <QMutex>
+#include <QAtomicInt>
+#include <functional>
+
+class Model;
+class ModelTables;
+class FsmTable;
+class ClusterScheduler;
+
+// Exhaustive (explicit-state) exploration of the reachable configurations of a model, for finding the
+// behaviours that stimuli never exercise.
+//
+// A configuration is given by the current state of each automaton and the values of all the variables
+// (outputs, shared and local variables). The inputs are not part of it: at each step, any input event may
+// occur, with any values of the other inputs (booleans, and integers in 0..[setIntRange]). A step is then
+// a reaction of the built-in simulator (see [Simulator]) to this event. Simultaneous input events are not
+// considered.
+//
+// Configurations are hash-consed in a set sharded by hash value, each shard having its own lock, and the
+// search proceeds breadth-first, each level being expanded by all the threads (see [ClusterScheduler]).
+// Each configuration records the step by which it was first reached, so that the shortest path leading to
+// it can be rebuilt. The search stops when all configurations have been explored or when [setMaxStates]
+// of them have been found.
+//
+// Results are the automaton states never reached, the deadlocks (configurations in which no automaton
+// can take any transition, whatever the inputs) and the reactions ending in an error (non-deterministic
+// transitions, instantaneous loops, ...). Each deadlock and error comes with a counterexample, given as
+// stimuli for all inputs, which can be saved as a sweep file (see [SweepRunner]) and replayed.
+
+class Explorer
+{
+public:
+  Explorer(Model *model, bool synchronousActions = false);
+  ~Explorer();
+
+  struct Counterexample {
+    QString description;
+    int length;                                   // Number of reactions
+    QList<QPair<QString,QString>> stimuli;        // Input, textual form of a [Stimulus]
+  };
+
+  void setIntRange(int max) { this->intMax = max; }       // Default: 3
+  void setMaxStates(int n) { this->maxStates = qBound(1, n, maxIds); } // Default: 1000000
+  void setThreads(int n) { this->nbThreads = n; }         // Default: number of cores
+  // Returns false if the model could not be explored, or if the search has been aborted by [progress]
+  // (called with the number of configurations found after each level)
+  bool run(std::function<bool(int)> progress = nullptr);
+  QStringList getErrors() const { return errors; }
+
+  int getNbStates() const { return nbStates.loadAcquire(); }
+  qint64 getNbSteps() const { return nbSteps; }
+  int getDepth() const { return depth; }
+  bool isComplete() const { return complete; } // false if stopped by [setMaxStates]
+  QStringList getUnreachable() const { return unreachable; } // "<fsm>.<state>"
+  const QList<Counterexample>& getDeadlocks() const { return deadlocks; }
+  const QList<Counterexample>& getFailures() const { return failures; }
+
+  // Writes a summary of the results, and each counterexample as a sweep file <report>_<n>.sweep
+  bool writeReport(QString fname, QStringList& files);
+
+private:
+  struct Node {
+    int parent;          // -1 for the initial configuration
+    int event;           // Input event of the step leading to it (index in [inEvents])
+    int valuation;       // Values of the other inputs for this step (see [setInputs])
+  };
+  struct Shard {
+    QMutex mutex;
+    QHash<QVector<int>,int> index;  // Configuration -> rank in [configs]
+    QList<QVector<int>> configs;
+    QVector<Node> nodes;
+  };
+
+  static const int nbShards = 64;
+  static const int maxIds = 1 << 24;  // Per shard, so that identifiers (rank * nbShards + shard) fit in an int
+  static const int maxValuations;
+  static const int maxTraces;
+  static const int maxMicroSteps;
+
+  Model *model;
+  bool synchronousActions;
+  int intMax;
+  int maxStates;
+  int nbThreads;
+  ModelTables *tables;
+  QStringList errors;
+  QVector<int> inEvents;         // Event index of each input event
+  QStringList inEventNames;
+  QVector<int> inSlots;          // Slot of each other input
+  QVector<int> inDomains;        // Number of values of each other input
+  QStringList inNames;
+  int nbValuations;
+  QVector<int> configSlots;      // Slots saved in configurations (neither inputs nor scratch slots)
+  Shard shards[nbShards];
+  QAtomicInt nbStates;
+  QAtomicInt full;
+  qint64 nbSteps;
+  int depth;
+  bool complete;
+  QStringList unreachable;
+  QMutex resultsMutex;
+  QList<Counterexample> deadlocks;
+  QList<Counterexample> failures;
+
+  void setInputs(int valuation, int *store) const;
+  QVector<int> encode(const QVector<int>& current, const QVector<int>& store) const;
+  void decode(const QVector<int>& config, QVector<int>& current, QVector<int>& store) const;
+  int insert(const QVector<int>& config, const Node& node, bool& added);
+  QVector<int> config(int id);
+  bool react(QVector<int>& current, QVector<int>& store, int event, bool& fired, QString& error) const;
+  void expand(int id, QVector<int>& next, qint64& steps);
+  QList<QPair<int,int>> path(int id); // Event and valuation of each step from the initial configuration
+  Counterexample counterexample(int id, QString description, int event = -1, int valuation = -1);
+  QString describe(const QVector<int>& config) const;
+};
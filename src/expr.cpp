@@ -0,0 +1,60 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "expr.h"
+
+bool Expr::isConst() const
+{
+  switch ( kind ) {
+  case EInt:
+  case EBool:
+    return true;
+  case EVar:
+    return false;
+  default:
+    for ( const Expr* e : args )
+      if ( ! e->isConst() ) return false;
+    return true;
+  }
+}
+
+void Expr::vars(QSet<QString>& r) const
+{
+  if ( kind == EVar ) r.insert(name);
+  for ( const Expr* e : args ) e->vars(r);
+}
+
+QString Expr::toString() const
+{
+  switch ( kind ) {
+  case EInt: return QString::number(value);
+  case EBool: return value ? "true" : "false";
+  case EVar: return name;
+  case EUnop: return name + args.at(0)->toString();
+  case EBinop: return "(" + args.at(0)->toString() + name + args.at(1)->toString() + ")";
+  case EBit: return args.at(0)->toString() + "[" + args.at(1)->toString() + "]";
+  case ERange: return args.at(0)->toString() + "[" + args.at(1)->toString() + ":" + args.at(2)->toString() + "]";
+  case ECast: return args.at(0)->toString() + "::" + name;
+  case ECond: return "(" + args.at(0)->toString() + "?" + args.at(1)->toString() + ":" + args.at(2)->toString() + ")";
+  }
+  return "";
+}
+
+QString Action::toString() const
+{
+  return kind == Emit ? lhs : lhs + ":=" + rhs->toString();
+}
+
+QString Valuation::toString() const
+{
+  return output + "=" + value->toString();
+}
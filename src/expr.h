@@ -0,0 +1,89 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QList>
+#include <QSet>
+
+// Abstract syntax of the guards, actions and state valuations handled by Grasp
+// (see [FragmentParser] for the concrete syntax)
+
+class Expr
+{
+public:
+  enum Kind {
+    EInt,       // Integer literal
+    EBool,      // Boolean literal (true, false)
+    EVar,       // IO or variable
+    EUnop,      // op e
+    EBinop,     // e1 op e2
+    EBit,       // e[i]
+    ERange,     // e[hi:lo]
+    ECast,      // e::int, e::bool
+    ECond       // e1 ? e2 : e3
+  };
+
+  Kind kind;
+  int value;          // For EInt and EBool
+  QString name;       // For EVar (identifier), EUnop and EBinop (operator) and ECast (target type)
+  QList<Expr*> args;  // Sub-expressions (owned)
+
+  Expr(Kind kind, int value) : kind(kind), value(value) { }
+  Expr(Kind kind, QString name, QList<Expr*> args = QList<Expr*>()) : kind(kind), value(0), name(name), args(args) { }
+  ~Expr() { qDeleteAll(args); }
+
+  bool isConst() const;
+  void vars(QSet<QString>& r) const; // Add identifiers occuring in expression to [r]
+  QString toString() const;
+
+private:
+  Q_DISABLE_COPY(Expr)
+};
+
+class Action
+{
+public:
+  enum Kind {
+    Assign,  // lhs := rhs
+    Emit     // lhs (event emission)
+  };
+
+  Kind kind;
+  QString lhs;
+  Expr *rhs; // NULL for Emit
+
+  Action(QString lhs) : kind(Emit), lhs(lhs), rhs(NULL) { }
+  Action(QString lhs, Expr *rhs) : kind(Assign), lhs(lhs), rhs(rhs) { }
+  ~Action() { delete rhs; }
+
+  QString toString() const;
+
+private:
+  Q_DISABLE_COPY(Action)
+};
+
+class Valuation // <output>=<value>
+{
+public:
+  QString output;
+  Expr *value;
+
+  Valuation(QString output, Expr *value) : output(output), value(value) { }
+  ~Valuation() { delete value; }
+
+  QString toString() const;
+
+private:
+  Q_DISABLE_COPY(Valuation)
+};
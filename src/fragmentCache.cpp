@@ -0,0 +1,158 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "fragmentCache.h"
+#include "include/nlohmann_json.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QDebug>
+
+const int FragmentCache::maxEntries = 20000;
+
+FragmentCache::FragmentCache(QString fname)
+{
+  this->fname = fname;
+  this->nbLines = 0;
+  load();
+}
+
+QByteArray FragmentCache::key(QString stamp, QString context, QString kind, QString fragment)
+{
+  QCryptographicHash h(QCryptographicHash::Sha1);
+  h.addData(stamp.toUtf8());
+  h.addData("\n", 1);
+  h.addData(context.toUtf8());
+  h.addData(kind.toUtf8());
+  h.addData(" ", 1);
+  h.addData(fragment.toUtf8());
+  return h.result().toHex();
+}
+
+// Identifies the executable actually run for [compiler]
+
+QString FragmentCache::stamp(QString compiler)
+{
+  QFileInfo f(compiler);
+  if ( ! f.exists() ) {
+    QString path = QStandardPaths::findExecutable(compiler);
+    if ( ! path.isEmpty() ) f.setFile(path);
+    }
+  if ( ! f.exists() ) return compiler;
+  return compiler + " " + QString::number(f.size()) + " " + QString::number(f.lastModified().toMSecsSinceEpoch());
+}
+
+bool FragmentCache::lookup(const QByteArray& key, bool& verdict, QStringList& errors)
+{
+  auto i = entries.constFind(key);
+  if ( i == entries.constEnd() ) return false;
+  verdict = i.value().verdict;
+  errors = i.value().errors;
+  return true;
+}
+
+void FragmentCache::insert(const QByteArray& key, bool verdict, const QStringList& errors)
+{
+  Entry e = { verdict, errors };
+  insert(QList<QByteArray>() << key, QList<Entry>() << e);
+}
+
+void FragmentCache::insert(const QList<QByteArray>& keys, const QList<Entry>& entries)
+{
+  if ( keys.isEmpty() ) return;
+  for ( int i=0; i<keys.length(); i++ ) {
+    if ( ! this->entries.contains(keys[i]) ) this->keys.append(keys[i]);
+    this->entries.insert(keys[i], entries[i]);
+    }
+  append(keys);
+  if ( nbLines > maxEntries || this->keys.length() > maxEntries ) compact();
+}
+
+void FragmentCache::clear()
+{
+  entries.clear();
+  keys.clear();
+  nbLines = 0;
+  QFile::remove(fname);
+}
+
+void FragmentCache::load()
+{
+  QFile file(fname);
+  if ( ! file.open(QIODevice::ReadOnly | QIODevice::Text) ) return; // No cache yet
+  while ( ! file.atEnd() ) {
+    QByteArray line = file.readLine().trimmed();
+    if ( line.isEmpty() ) continue;
+    nbLines++;
+    try {
+      auto json = nlohmann::json::parse(line.toStdString());
+      QByteArray k = QByteArray::fromStdString(json.at("k").get<std::string>());
+      Entry e;
+      e.verdict = json.at("v").get<bool>();
+      for ( const auto& err : json.at("e") )
+        e.errors << QString::fromStdString(err.get<std::string>());
+      if ( ! entries.contains(k) ) keys.append(k);
+      entries.insert(k, e);
+      }
+    catch ( const std::exception& ) {
+      qDebug() << "FragmentCache: ignoring corrupted entry in" << fname;
+      }
+    }
+  file.close();
+  qDebug() << "FragmentCache: read" << entries.size() << "entries from" << fname;
+  if ( nbLines > maxEntries ) compact();
+}
+
+// Keeps the most recent half of the entries
+
+void FragmentCache::compact()
+{
+  QList<QByteArray> kept = keys.mid(qMax(0, keys.length() - maxEntries/2));
+  QHash<QByteArray,Entry> keptEntries;
+  for ( const QByteArray& k : kept ) keptEntries.insert(k, entries.value(k));
+  entries = keptEntries;
+  keys = kept;
+  append(keys, true);
+}
+
+// Writes the entries of [keys] through a single open file, replacing its contents if [truncate] is set
+
+void FragmentCache::append(const QList<QByteArray>& keys, bool truncate)
+{
+  if ( truncate ) nbLines = 0;
+  QFile file(fname);
+  QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Text;
+  if ( ! file.open(mode | (truncate ? QIODevice::Truncate : QIODevice::Append)) ) {
+    qDebug() << "FragmentCache: cannot write" << fname;
+    return;
+    }
+  QByteArray buf;
+  for ( const QByteArray& k : keys ) {
+    const Entry& e = entries[k];
+    nlohmann::json json;
+    json["k"] = k.toStdString();
+    json["v"] = e.verdict;
+    json["e"] = nlohmann::json::array();
+    for ( const QString& err : e.errors ) json["e"].push_back(err.toStdString());
+    buf.append(QByteArray::fromStdString(json.dump()));
+    buf.append('\n');
+    nbLines++;
+    }
+  file.write(buf);
+  file.close();
+}
+
+FragmentCache::~FragmentCache()
+{
+}
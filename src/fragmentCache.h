@@ -0,0 +1,56 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+
+// A persistent, content-addressed cache of fragment check verdicts.
+// Keys are hashes of the compiler [stamp] (path, size and modification date of its executable, so
+// that verdicts are not reused after an upgrade), the context block built by the [FragmentChecker],
+// the fragment kind and the fragment text. Values are the verdict and the associated errors.
+// Entries are appended, one JSON object per line, to a file stored next to [grasp.ini]. The file
+// is compacted, keeping the most recent entries, when it exceeds [maxEntries] lines.
+
+class FragmentCache
+{
+public:
+  FragmentCache(QString fname);
+  ~FragmentCache();
+
+  struct Entry {
+    bool verdict;
+    QStringList errors;
+  };
+
+  static QString stamp(QString compiler);  // Stats the executable : compute it once per check
+  static QByteArray key(QString stamp, QString context, QString kind, QString fragment);
+  bool lookup(const QByteArray& key, bool& verdict, QStringList& errors);
+  void insert(const QByteArray& key, bool verdict, const QStringList& errors);
+  void insert(const QList<QByteArray>& keys, const QList<Entry>& entries);  // Through a single write
+  void clear();
+
+private:
+  QString fname;
+  QHash<QByteArray,Entry> entries;
+  QList<QByteArray> keys;  // In insertion order
+  int nbLines;             // In the file
+  void load();
+  void compact();
+  void append(const QList<QByteArray>& keys, bool truncate=false);
+
+  static const int maxEntries;
+};
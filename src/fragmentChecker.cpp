@@ -14,7 +14,12 @@
 #include "model.h"
 #include "automaton.h"
 #include "compiler.h"
-#include <QTemporaryFile>
+#include "fragmentCache.h"
+#include "nativeChecker.h"
+#include "globals.h"
+#include <QTextStream>
+#include <QRegularExpression>
+#include <QHash>
 #include <QMessageBox>
 #include <QtDebug>
 #include "qt_compat.h"
@@ -26,15 +31,10 @@ FragmentChecker::FragmentChecker(Compiler *compiler, Automaton *automaton, QWidg
   this->automaton = automaton;
 }
 
-bool FragmentChecker::check(QString kind, QString frag)
+QString FragmentChecker::contextOf(Automaton *automaton)
 {
-  // Build fragment file
-  QTemporaryFile file;
-  //file.setAutoRemove(false); // For debug only
-  if ( ! file.open() ) return false;
-  QString fname = file.fileName();
-  //qDebug() << "Temporary file name is" << fname;
-  QTextStream os(&file);
+  QString txt;
+  QTextStream os(&txt);
   os << "-- context" << QT_ENDL;
   foreach ( Iov* iov, automaton->enclosingModel()->getIos() ) {
     os << Iov::stringOfKind(iov->kind) << " " << iov->name << ": " << Iov::stringOfType(iov->type) << ";" << QT_ENDL;
@@ -42,35 +42,210 @@ bool FragmentChecker::check(QString kind, QString frag)
   foreach ( Iov* iov, automaton->getVars() ) {
     os << Iov::stringOfKind(iov->kind) << " " << iov->name << ": " << Iov::stringOfType(iov->type) << ";" << QT_ENDL;
   }
+  os.flush();
+  return txt;
+}
+
+QString FragmentChecker::fragmentText(QString context, QString kind, QString frag)
+{
+  QString txt;
+  QTextStream os(&txt);
+  os << context;
   os << "-- fragment" << QT_ENDL;
   os << kind<< " " << frag << ";" << QT_ENDL;
-  file.close();
-  QStringList args = { "-check_fragment" };
-  // Call compiler
-  return compiler->run(fname, args, ".");
-  // TODO : add a "transition" fragment class and let the compiler return (on stdout ?), in this case,
-  // the list of of IOs and variables read (resp. written) by the guards and actions
-  // More generally, implement a "server" mode for the rfsmc compiler, allowing it to be used for
-  // checking / extracting semantic informations from syntax fragments 
+  os.flush();
+  return txt;
+}
+
+bool FragmentChecker::check(QString kind, QString frag)
+{
+  // Build fragment text
+  QString context = contextOf(automaton);
+  QString txt = fragmentText(context, kind, frag);
+  // Look for a previous verdict
+  FragmentCache *cache = Globals::fragmentCache;
+  QByteArray key;
+  bool ok;
+  if ( cache ) {
+    key = FragmentCache::key(FragmentCache::stamp(compiler->getPath()), context, kind, frag);
+    if ( cache->lookup(key, ok, errors) ) return ok;
+    }
+  // Submit it to the compiler (server session if available, temporary file otherwise)
+  ok = compiler->checkFragment(txt, errors);
+  if ( cache && (ok || ! errors.isEmpty()) ) // Do not record failures to run the compiler
+    cache->insert(key, ok, errors);
+  return ok;
+}
+
+bool FragmentChecker::check_batch(Compiler *compiler, QList<Fragment>& fragments)
+{
+  FragmentCache *cache = Globals::fragmentCache;
+  if ( ! cache ) return submit_batch(compiler, fragments);
+  // Only submit the fragments for which no verdict has been recorded
+  QList<int> misses;
+  QList<Fragment> pending;
+  QList<QByteArray> keys;
+  QHash<Automaton*,QString> contexts;
+  QString stamp = FragmentCache::stamp(compiler->getPath());
+  bool ok = true;
+  for ( int i=0; i<fragments.length(); i++ ) {
+    Fragment& f = fragments[i];
+    if ( ! contexts.contains(f.automaton) ) contexts.insert(f.automaton, contextOf(f.automaton));
+    QByteArray key = FragmentCache::key(stamp, contexts.value(f.automaton), f.kind, f.text);
+    bool verdict;
+    if ( cache->lookup(key, verdict, f.errors) ) {
+      ok = ok && verdict;
+      continue;
+      }
+    misses.append(i);
+    pending.append(f);
+    keys.append(key);
+    }
+  qDebug() << "FragmentChecker::check_batch:" << fragments.length() - misses.length() << "cached verdicts," << misses.length() << "to check";
+  if ( pending.isEmpty() ) return ok;
+  bool r = submit_batch(compiler, pending, &keys);
+  for ( int j=0; j<misses.length(); j++ )
+    fragments[misses[j]].errors = pending[j].errors;
+  return ok && r;
+}
+
+bool FragmentChecker::submit_batch(Compiler *compiler, QList<Fragment>& fragments, const QList<QByteArray> *keys)
+{
+  if ( fragments.isEmpty() ) return true;
+  // Build batch text, grouping fragments by automaton (each one has its own context)
+  QString txt;
+  QTextStream os(&txt);
+  Automaton *current = NULL;
+  for ( int i=0; i<fragments.length(); i++ ) {
+    Fragment& f = fragments[i];
+    f.errors.clear();
+    if ( f.automaton != current ) {
+      os << contextOf(f.automaton);
+      current = f.automaton;
+      }
+    os << "-- fragment " << i << QT_ENDL;
+    os << f.kind << " " << f.text << ";" << QT_ENDL;
+    }
+  os.flush();
+  QStringList errors;
+  FragmentCache *cache = Globals::fragmentCache;
+  if ( compiler->checkFragment(txt, errors, true) ) {
+    if ( cache && keys ) {
+      QList<FragmentCache::Entry> verdicts;
+      for ( int i=0; i<fragments.length(); i++ ) verdicts.append(FragmentCache::Entry { true, QStringList() });
+      cache->insert(*keys, verdicts);
+      }
+    return true;
+    }
+  // Dispatch diagnostics
+  static const QRegularExpression re_tag("^\\[(\\d+)\\]\\s*(.*)$");
+  bool dispatched = false;
+  foreach ( QString error, errors ) {
+    QRegularExpressionMatch m = re_tag.match(error);
+    int i = m.hasMatch() ? m.captured(1).toInt() : -1;
+    if ( i >= 0 && i < fragments.length() ) {
+      fragments[i].errors << m.captured(2);
+      dispatched = true;
+      }
+    else
+      qDebug() << "FragmentChecker::check_batch: unattributed diagnostic" << error;
+    }
+  if ( dispatched ) {
+    if ( cache && keys ) {
+      QList<FragmentCache::Entry> verdicts;
+      for ( const Fragment& f : fragments ) verdicts.append(FragmentCache::Entry { f.errors.isEmpty(), f.errors });
+      cache->insert(*keys, verdicts);
+      }
+    return false;
+    }
+  // No diagnostic could be attributed : the compiler probably does not support batch mode.
+  // Fall back to individual checks, run concurrently
+  qDebug() << "FragmentChecker::check_batch: falling back to individual checks";
+  QList<CompilerPool::Job> jobs;
+  QHash<Automaton*,QString> contexts;
+  for ( const Fragment& f : fragments ) {
+    if ( ! contexts.contains(f.automaton) ) contexts.insert(f.automaton, contextOf(f.automaton));
+    jobs.append(CompilerPool::Job(fragmentText(contexts.value(f.automaton), f.kind, f.text)));
+    }
+  compiler->checkFragments(jobs);
+  bool ok = true;
+  QList<QByteArray> recorded;
+  QList<FragmentCache::Entry> verdicts;
+  for ( int i=0; i<fragments.length(); i++ ) {
+    Fragment& f = fragments[i];
+    const CompilerPool::Job& job = jobs.at(i);
+    if ( keys && job.done && (job.verdict || ! job.errors.isEmpty()) ) { // Do not record failures to run the compiler
+      recorded.append(keys->at(i));
+      verdicts.append(FragmentCache::Entry { job.verdict, job.errors });
+      }
+    if ( job.done && job.verdict ) continue;
+    f.errors = job.errors;
+    if ( f.errors.isEmpty() ) f.errors << (job.done ? "rejected by compiler" : "cannot run compiler");
+    ok = false;
+    }
+  if ( cache ) cache->insert(recorded, verdicts);
+  return ok;
+}
+
+QString FragmentChecker::kindName(QString kind)
+{
+  if ( kind == "guard" ) return "guard";
+  else if ( kind == "action" ) return "action";
+  else if ( kind == "sval" ) return "state valuation";
+  else return kind;
+}
+
+QString FragmentChecker::errorReport(const QList<Fragment>& fragments)
+{
+  QStringList r;
+  for ( const Fragment& f : fragments ) {
+    if ( f.errors.isEmpty() ) continue;
+    r << "Illegal " + kindName(f.kind) + ": \"" + f.text + "\" (" + f.origin + ")\n" + f.errors.join("\n");
+    }
+  return r.join("\n");
+}
+
+bool FragmentChecker::check_interactive(QString kind, QString frag)
+{
+  // The native checker is tried first. The compiler is only invoked for fragments using
+  // constructs it does not handle
+  NativeChecker native(automaton);
+  switch ( native.check(kind, frag) ) {
+    case NativeChecker::Ok:
+      errors.clear();
+      return true;
+    case NativeChecker::Error:
+      errors = native.getErrors();
+      return false;
+    case NativeChecker::Unsupported:
+      break;
+    }
+  if ( check(kind, frag) ) return true;
+  if ( errors.isEmpty() ) {
+    // The compiler could not be run. Accept the fragment, it will be checked again before code generation
+    qDebug() << "FragmentChecker: cannot check" << kind << frag << "(" << native.getErrors().join(",") << ")";
+    return true;
+    }
+  return false;
 }
 
 bool FragmentChecker::check_state_valuation(QString valuation)
 {
-  return check("sval", valuation);
+  return check_interactive("sval", valuation);
 }
 
 bool FragmentChecker::check_guard(QString guard)
 {
-  return check("guard", guard);
+  return check_interactive("guard", guard);
 }
 
 bool FragmentChecker::check_action(QString action)
 {
-  return check("action", action);
+  return check_interactive("action", action);
 }
 
 QStringList FragmentChecker::getErrors() 
 {
-  return compiler->getErrors();
+  return errors;
 }
   
@@ -13,22 +13,56 @@
 #pragma once
 
 #include <QString>
+#include <QStringList>
+#include <QList>
+#include <QByteArray>
 
 class Compiler;
 class Automaton;
 class QWidget;
+class QGraphicsItem;
 
 class FragmentChecker
 {
  public:
   FragmentChecker(Compiler *compiler, Automaton *automaton, QWidget *parent);
+  // Interactive checks (from the state and transition dialogs). These first use the [NativeChecker]
+  // and only resort to the compiler for fragments it cannot decide
   bool check_state_valuation(QString valuation);
   bool check_guard(QString guard);
   bool check_action(QString action);
   QStringList getErrors();
+
+  // Batch checking. All fragments are packed in a single file, with one "-- context" block
+  // per automaton and one numbered "-- fragment <n>" block per fragment, and submitted to
+  // a single [rfsmc -check_fragments] invocation. The compiler reports each diagnostic
+  // as "[<n>] <message>", which is used to dispatch it to the corresponding fragment.
+  // Fragments for which a verdict has already been recorded in [Globals::fragmentCache]
+  // are not submitted.
+  struct Fragment {
+    Fragment(Automaton *automaton, QString kind, QString text, QString origin, QGraphicsItem *item = NULL, quint64 revision = 0) :
+      automaton(automaton), kind(kind), text(text), origin(origin), item(item), revision(revision) { };
+    Automaton *automaton;
+    QString kind; // "guard", "action" or "sval"
+    QString text;
+    QString origin; // For error reporting
+    QGraphicsItem *item; // State or transition holding the fragment, with its revision stamp
+    quint64 revision;
+    QStringList errors; // Filled by [check_batch]
+  };
+  static bool check_batch(Compiler *compiler, QList<Fragment>& fragments);
+  static QString errorReport(const QList<Fragment>& fragments);
+
+  static QString contextOf(Automaton *automaton);
+  static QString fragmentText(QString context, QString kind, QString frag);
+
 private:
   QWidget *parent;
   Compiler *compiler;
   Automaton *automaton;
+  QStringList errors;
   bool check(QString kind, QString frag);
+  bool check_interactive(QString kind, QString frag);
+  static bool submit_batch(Compiler *compiler, QList<Fragment>& fragments, const QList<QByteArray> *keys = NULL);
+  static QString kindName(QString kind);
 };
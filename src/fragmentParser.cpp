@@ -0,0 +1,335 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "fragmentParser.h"
+#include <QScopedPointer>
+#include <QRegularExpression>
+
+FragmentParser::FragmentParser(QString text)
+{
+  this->text = text;
+  this->cur = 0;
+  this->unsupported = false;
+}
+
+// Read/write sets
+
+void FragmentParser::rwSets(QString kind, QString text, QSet<QString>& rd, QSet<QString>& wr)
+{
+  FragmentParser parser(text);
+  if ( kind == "guard" ) {
+    QScopedPointer<Expr> e(parser.parseGuard());
+    if ( e ) { e->vars(rd); return; }
+    }
+  else if ( kind == "action" ) {
+    QScopedPointer<Action> a(parser.parseAction());
+    if ( a ) {
+      wr.insert(a->lhs);
+      if ( a->rhs ) a->rhs->vars(rd);
+      return;
+      }
+    }
+  else if ( kind == "sval" ) {
+    QScopedPointer<Valuation> v(parser.parseValuation());
+    if ( v ) {
+      wr.insert(v->output);
+      v->value->vars(rd);
+      return;
+      }
+    }
+  static const QRegularExpression re_id("[A-Za-z_][A-Za-z0-9_]*");
+  QRegularExpressionMatchIterator i = re_id.globalMatch(text);
+  while ( i.hasNext() ) rd.insert(i.next().captured(0));
+}
+
+// Lexer
+
+void FragmentParser::tokenize()
+{
+  static const QStringList ops2 = { ":=", "::", "<=", ">=", "!=", "<<", ">>", "&&", "||" };
+  static const QString ops1 = "+-*/%()[]:<>=&|^~!?";
+  tokens.clear();
+  cur = 0;
+  int i = 0, n = text.length();
+  while ( i < n ) {
+    QChar c = text.at(i);
+    if ( c.isSpace() ) { i++; continue; }
+    Token t;
+    t.pos = i;
+    t.value = 0;
+    if ( c.isDigit() ) {
+      int j = i;
+      bool hex = c == '0' && i+1 < n && (text.at(i+1) == 'x' || text.at(i+1) == 'X');
+      if ( hex ) j += 2;
+      while ( j < n && (hex ? isxdigit(text.at(j).toLatin1()) : text.at(j).isDigit()) ) j++;
+      if ( j < n && (text.at(j) == '.' || text.at(j) == 'e' || text.at(j) == 'E') ) notSupported("float constant");
+      bool ok;
+      t.kind = TInt;
+      t.text = text.mid(i, j-i);
+      t.value = hex ? t.text.mid(2).toInt(&ok, 16) : t.text.toInt(&ok, 10);
+      if ( ! ok ) fail("invalid integer constant \"" + t.text + "\"", i);
+      i = j;
+      }
+    else if ( c.isLetter() || c == '_' ) {
+      int j = i+1;
+      while ( j < n && (text.at(j).isLetterOrNumber() || text.at(j) == '_') ) j++;
+      t.kind = TIdent;
+      t.text = text.mid(i, j-i);
+      i = j;
+      }
+    else if ( i+1 < n && ops2.contains(text.mid(i, 2)) ) {
+      t.kind = TOp;
+      t.text = text.mid(i, 2);
+      i += 2;
+      }
+    else if ( ops1.contains(c) ) {
+      t.kind = TOp;
+      t.text = c;
+      i++;
+      }
+    else if ( c == '.' || c == '\'' || c == '"' || c == '{' || c == ',' )
+      notSupported(QString("'") + c + "'");
+    else
+      fail(QString("illegal character '") + c + "'", i);
+    tokens.append(t);
+    }
+  Token t;
+  t.kind = TEnd;
+  t.pos = n;
+  t.value = 0;
+  tokens.append(t);
+}
+
+const FragmentParser::Token& FragmentParser::peek(int k)
+{
+  static const Token none = { TEnd, QString(), 0, 0 };
+  return cur+k < tokens.length() ? tokens.at(cur+k) : none;
+}
+
+// Whether the next tokens are [<INT>] or [<INT:INT>], so that [x::int < 3] remains a comparison
+
+bool FragmentParser::isSize()
+{
+  if ( ! isOp("<") || peek(1).kind != TInt ) return false;
+  if ( isOpAt(2, ">") ) return true;
+  return isOpAt(2, ":") && peek(3).kind == TInt && isOpAt(4, ">");
+}
+
+// Error handling
+
+// The token list is only complete once [tokenize] has returned: the lexer gives its own position
+
+void FragmentParser::fail(QString msg, int pos)
+{
+  if ( pos < 0 ) pos = peek().pos;
+  throw SyntaxError("syntax error at character " + QString::number(pos+1) + ": " + msg);
+}
+
+void FragmentParser::notSupported(QString what)
+{
+  throw SyntaxError("unsupported construct: " + what, true);
+}
+
+void FragmentParser::expect(QString op)
+{
+  if ( ! isOp(op) ) fail("\"" + op + "\" expected");
+  next();
+}
+
+void FragmentParser::expectEnd()
+{
+  if ( peek().kind != TEnd ) fail("unexpected \"" + peek().text + "\"");
+}
+
+// Entry points
+
+Expr* FragmentParser::parseGuard()
+{
+  try {
+    tokenize();
+    QScopedPointer<Expr> e(expr());
+    expectEnd();
+    return e.take();
+    }
+  catch ( SyntaxError& err ) {
+    error = err.msg;
+    unsupported = err.unsupported;
+    return NULL;
+    }
+}
+
+Action* FragmentParser::parseAction()
+{
+  try {
+    tokenize();
+    if ( peek().kind != TIdent ) fail("identifier expected");
+    QString lhs = next().text;
+    if ( isOp("[") ) notSupported("assignation to an array element or a bit field");
+    if ( peek().kind == TEnd ) return new Action(lhs);
+    expect(":=");
+    QScopedPointer<Expr> e(expr());
+    expectEnd();
+    return new Action(lhs, e.take());
+    }
+  catch ( SyntaxError& err ) {
+    error = err.msg;
+    unsupported = err.unsupported;
+    return NULL;
+    }
+}
+
+Valuation* FragmentParser::parseValuation()
+{
+  try {
+    tokenize();
+    if ( peek().kind != TIdent ) fail("identifier expected");
+    QString lhs = next().text;
+    expect("=");
+    QScopedPointer<Expr> e(expr());
+    expectEnd();
+    return new Valuation(lhs, e.take());
+    }
+  catch ( SyntaxError& err ) {
+    error = err.msg;
+    unsupported = err.unsupported;
+    return NULL;
+    }
+}
+
+// Expressions
+
+Expr* FragmentParser::expr()
+{
+  QScopedPointer<Expr> c(binary(0));
+  if ( ! isOp("?") ) return c.take();
+  next();
+  QScopedPointer<Expr> e1(expr());
+  expect(":");
+  Expr *e2 = expr();
+  return new Expr(Expr::ECond, "?", { c.take(), e1.take(), e2 });
+}
+
+Expr* FragmentParser::binary(int level)
+{
+  static const QList<QStringList> levels = {
+    { "||" },
+    { "&&" },
+    { "=", "!=", "<", ">", "<=", ">=" },
+    { "|", "^" },
+    { "&" },
+    { "<<", ">>" },
+    { "+", "-" },
+    { "*", "/", "%", "mod" }
+  };
+  if ( level >= levels.length() ) return unary();
+  const QStringList& ops = levels.at(level);
+  QScopedPointer<Expr> l(binary(level+1));
+  while ( (peek().kind == TOp || peek().kind == TIdent) && ops.contains(peek().text) ) {
+    QString op = next().text;
+    if ( op == "mod" ) op = "%";
+    Expr *r = binary(level+1);
+    l.reset(new Expr(Expr::EBinop, op, { l.take(), r }));
+    }
+  return l.take();
+}
+
+Expr* FragmentParser::unary()
+{
+  if ( isOp("-") || isOp("~") || isOp("!") ) {
+    QString op = next().text;
+    Expr *e = unary();
+    return new Expr(Expr::EUnop, op, { e });
+    }
+  return postfix();
+}
+
+Expr* FragmentParser::postfix()
+{
+  QScopedPointer<Expr> e(primary());
+  while ( true ) {
+    if ( isOp("[") ) {
+      next();
+      QScopedPointer<Expr> i(expr());
+      if ( isOp(":") ) {
+        next();
+        QScopedPointer<Expr> j(expr());
+        expect("]");
+        e.reset(new Expr(Expr::ERange, "[:]", { e.take(), i.take(), j.take() }));
+        }
+      else {
+        expect("]");
+        e.reset(new Expr(Expr::EBit, "[]", { e.take(), i.take() }));
+        }
+      }
+    else if ( isOp("::") ) {
+      next();
+      QString ty;
+      if ( isKeyword("bool") ) {
+        next();
+        ty = "bool";
+        }
+      else if ( isKeyword("int") ) {
+        next();
+        ty = "int";
+        if ( isSize() ) { // Sized int
+          next();
+          ty += "<" + next().text;
+          if ( isOp(":") ) {
+            next();
+            ty += ":" + next().text;
+            }
+          expect(">");
+          ty += ">";
+          }
+        }
+      else if ( peek().kind == TIdent )
+        notSupported("cast to type " + peek().text);
+      else
+        fail("type expected");
+      e.reset(new Expr(Expr::ECast, ty, { e.take() }));
+      }
+    else
+      return e.take();
+    }
+}
+
+Expr* FragmentParser::primary()
+{
+  const Token& t = peek();
+  switch ( t.kind ) {
+  case TInt:
+    next();
+    return new Expr(Expr::EInt, t.value);
+  case TIdent:
+    if ( t.text == "true" || t.text == "false" ) {
+      next();
+      return new Expr(Expr::EBool, t.text == "true" ? 1 : 0);
+      }
+    if ( t.text == "mod" || t.text == "int" || t.text == "bool" ) fail("unexpected \"" + t.text + "\"");
+    else {
+      QString id = next().text;
+      if ( isOp("(") ) notSupported("function call");
+      return new Expr(Expr::EVar, id);
+      }
+  case TOp:
+    if ( t.text == "(" ) {
+      next();
+      QScopedPointer<Expr> e(expr());
+      expect(")");
+      return e.take();
+      }
+    fail("unexpected \"" + t.text + "\"");
+  case TEnd:
+    fail("unexpected end of text");
+  }
+  fail("unexpected token");
+}
@@ -0,0 +1,89 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QList>
+#include "expr.h"
+
+// A recursive-descent parser for guards, actions and state valuations.
+//
+// Syntax (by increasing precedence) :
+//   guard     ::= expr
+//   action    ::= ident ":=" expr | ident
+//   valuation ::= ident "=" expr
+//   expr      ::= e "?" e ":" e | e "||" e | e "&&" e
+//               | e ("="|"!="|"<"|">"|"<="|">=") e
+//               | e ("|"|"^") e | e "&" e | e ("<<"|">>") e
+//               | e ("+"|"-") e | e ("*"|"/"|"%"|"mod") e
+//               | ("-"|"~"|"!") e
+//               | e "[" expr "]" | e "[" expr ":" expr "]" | e "::" ("int" ["<" int ">"] | "bool")
+//               | int | "true" | "false" | ident | "(" expr ")"
+//
+// The parsing functions return NULL on error, the corresponding message being available by [getError].
+// Constructs which are accepted by the compiler but not by this parser (function calls, arrays, records,
+// floats, chars, ...) are not reported as errors but flagged by [isUnsupported].
+
+class FragmentParser
+{
+public:
+  FragmentParser(QString text);
+
+  Expr* parseGuard();
+  Action* parseAction();
+  Valuation* parseValuation();
+  QString getError() { return error; }
+  bool isUnsupported() { return unsupported; }
+
+  // Adds to [rd] (resp. [wr]) the identifiers read (resp. written) by a fragment ("guard", "action" or "sval").
+  // Fragments which cannot be parsed are conservatively assumed to read all the identifiers they contain
+  static void rwSets(QString kind, QString text, QSet<QString>& rd, QSet<QString>& wr);
+
+private:
+  enum TokKind { TEnd, TInt, TIdent, TOp };
+  struct Token {
+    TokKind kind;
+    QString text;
+    int value;
+    int pos;
+  };
+  struct SyntaxError { // Raised internally
+    SyntaxError(QString msg, bool unsupported=false) : msg(msg), unsupported(unsupported) { }
+    QString msg;
+    bool unsupported;
+  };
+
+  QString text;
+  QList<Token> tokens;
+  int cur;
+  QString error;
+  bool unsupported;
+
+  void tokenize();
+  const Token& peek(int k = 0); // [k] tokens ahead
+  Token next() { Token t = peek(); if ( cur < tokens.length()-1 ) cur++; return t; }
+  bool isOp(QString op) { return peek().kind == TOp && peek().text == op; }
+  bool isKeyword(QString kw) { return peek().kind == TIdent && peek().text == kw; }
+  bool isOpAt(int k, QString op) { return peek(k).kind == TOp && peek(k).text == op; }
+  bool isSize();
+  void expect(QString op);
+  void expectEnd();
+  [[noreturn]] void fail(QString msg, int pos = -1); // At the current token by default
+  [[noreturn]] void notSupported(QString what);
+
+  Expr* expr();
+  Expr* binary(int level);
+  Expr* unary();
+  Expr* postfix();
+  Expr* primary();
+};
@@ -0,0 +1,154 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "fragmentValidator.h"
+#include "fragmentChecker.h"
+#include "fragmentCache.h"
+#include "nativeChecker.h"
+#include "compiler.h"
+#include "globals.h"
+#include <QProcess>
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <QDebug>
+#include "qt_compat.h"
+
+FragmentValidator::FragmentValidator(Automaton *automaton, QObject *parent) : QObject(parent)
+{
+  this->automaton = automaton;
+  this->context = FragmentChecker::contextOf(automaton);
+}
+
+void FragmentValidator::validate(QString kind, QString text)
+{
+  QString key = keyOf(kind, text);
+  if ( verdicts.contains(key) || jobs.contains(key) ) return;
+  // Native check first
+  NativeChecker native(automaton);
+  switch ( native.check(kind, text) ) {
+    case NativeChecker::Ok:
+      setVerdict(kind, text, true, QStringList());
+      return;
+    case NativeChecker::Error:
+      setVerdict(kind, text, false, native.getErrors());
+      return;
+    case NativeChecker::Unsupported:
+      break;
+    }
+  // Then previously recorded verdicts
+  if ( ! Globals::compiler ) return;
+  QByteArray cacheKey;
+  if ( Globals::fragmentCache ) {
+    bool ok;
+    QStringList errors;
+    cacheKey = FragmentCache::key(FragmentCache::stamp(Globals::compiler->getPath()), context, kind, text);
+    if ( Globals::fragmentCache->lookup(cacheKey, ok, errors) ) {
+      setVerdict(kind, text, ok, errors);
+      return;
+      }
+    }
+  // Finally, the compiler
+  start(kind, text, cacheKey);
+}
+
+bool FragmentValidator::verdict(QString kind, QString text, bool& ok, QStringList& errors)
+{
+  QString key = keyOf(kind, text);
+  if ( ! verdicts.contains(key) ) return false;
+  const Verdict& v = verdicts[key];
+  ok = v.ok;
+  errors = v.errors;
+  return true;
+}
+
+void FragmentValidator::setVerdict(QString kind, QString text, bool ok, QStringList errors)
+{
+  Verdict v;
+  v.ok = ok;
+  v.errors = errors;
+  verdicts.insert(keyOf(kind, text), v);
+  emit verdictReady(kind, text);
+}
+
+void FragmentValidator::start(QString kind, QString text, QByteArray cacheKey)
+{
+  Job job;
+  job.kind = kind;
+  job.text = text;
+  job.cacheKey = cacheKey;
+  job.file = new QTemporaryFile();
+  if ( ! job.file->open() ) {
+    delete job.file;
+    return;
+    }
+  QTextStream os(job.file);
+  os << FragmentChecker::fragmentText(context, kind, text);
+  os.flush();
+  job.file->close();
+  job.proc = new QProcess();
+  job.proc->setProperty("key", keyOf(kind, text));
+  connect(job.proc, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(jobFinished()));
+  connect(job.proc, SIGNAL(errorOccurred(QProcess::ProcessError)), this, SLOT(jobFinished()));
+  jobs.insert(keyOf(kind, text), job);
+  qDebug() << "FragmentValidator: checking" << kind << text;
+  job.proc->start(Globals::compiler->getPath(), QStringList() << "-check_fragment" << "-gui" << job.file->fileName());
+}
+
+void FragmentValidator::jobFinished()
+{
+  QProcess *proc = qobject_cast<QProcess*>(sender());
+  Q_ASSERT(proc);
+  QString key = proc->property("key").toString();
+  if ( ! jobs.contains(key) ) return; // Already handled (error signal followed by finished, for ex)
+  Job job = jobs.take(key);
+  if ( proc->error() == QProcess::FailedToStart || proc->exitStatus() != QProcess::NormalExit ) {
+    // No verdict. The fragment will be checked synchronously when the dialog is accepted
+    qDebug() << "FragmentValidator: cannot check" << job.kind << job.text << ":" << proc->errorString();
+    release(job);
+    return;
+    }
+  bool ok = proc->exitCode() == 0;
+  QStringList errors = QString(proc->readAllStandardError()).split("\n", SKIP_EMPTY_PARTS);
+  if ( Globals::fragmentCache && ! job.cacheKey.isEmpty() && (ok || ! errors.isEmpty()) )
+    Globals::fragmentCache->insert(job.cacheKey, ok, errors);
+  release(job);
+  setVerdict(job.kind, job.text, ok, errors);
+}
+
+void FragmentValidator::cancelAllBut(QSet<QString> keys)
+{
+  foreach ( QString key, jobs.keys() ) {
+    if ( keys.contains(key) ) continue;
+    qDebug() << "FragmentValidator: cancelling check of" << key;
+    Job job = jobs.take(key);
+    release(job);
+    }
+}
+
+void FragmentValidator::release(Job& job)
+{
+  job.proc->disconnect(this);
+  if ( job.proc->state() != QProcess::NotRunning ) {
+    job.proc->kill();
+    job.proc->waitForFinished(100);
+    }
+  job.proc->deleteLater(); // We may be called from one of its signals
+  delete job.file;
+}
+
+FragmentValidator::~FragmentValidator()
+{
+  foreach ( QString key, jobs.keys() ) {
+    Job job = jobs.take(key);
+    release(job);
+    }
+}
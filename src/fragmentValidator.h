@@ -0,0 +1,72 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+
+class Automaton;
+class QProcess;
+class QTemporaryFile;
+
+// Asynchronous fragment validation, used for giving feedback while the user is editing.
+// Fragments are first checked by the [NativeChecker] and then looked up in [Globals::fragmentCache].
+// The remaining ones are submitted to a [rfsmc -check_fragment] process running in the background,
+// the [verdictReady] signal being emitted when it terminates.
+// Verdicts are indexed by (kind,text) and remain available for the lifetime of the validator.
+
+class FragmentValidator : public QObject
+{
+  Q_OBJECT
+
+public:
+  FragmentValidator(Automaton *automaton, QObject *parent = 0);
+  ~FragmentValidator();
+
+  void validate(QString kind, QString text);
+  void cancelAllBut(QSet<QString> keys); // Kill the jobs for fragments which are no longer edited
+  bool verdict(QString kind, QString text, bool& ok, QStringList& errors); // false if not (yet) known
+
+  static QString keyOf(QString kind, QString text) { return kind + " " + text; }
+
+signals:
+  void verdictReady(QString kind, QString text);
+
+private slots:
+  void jobFinished();
+
+private:
+  struct Verdict {
+    bool ok;
+    QStringList errors;
+  };
+  struct Job {
+    QString kind;
+    QString text;
+    QByteArray cacheKey;
+    QProcess *proc;
+    QTemporaryFile *file;
+  };
+
+  Automaton *automaton;
+  QString context;
+  QHash<QString,Verdict> verdicts;
+  QHash<QString,Job> jobs;
+
+  void setVerdict(QString kind, QString text, bool ok, QStringList errors);
+  void start(QString kind, QString text, QByteArray cacheKey);
+  void release(Job& job);
+};
@@ -0,0 +1,204 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "fsmTable.h"
+#include "model.h"
+#include "automaton.h"
+#include "transition.h"
+#include "state.h"
+#include "iov.h"
+#include "fragmentParser.h"
+#include <QScopedPointer>
+#include <QHash>
+#include <stdexcept>
+
+ModelTables::ModelTables(Model *model, bool synchronousActions)
+{
+  this->model = model;
+  this->synchronousActions = synchronousActions;
+}
+
+ModelTables::~ModelTables()
+{
+  qDeleteAll(fsms);
+}
+
+bool ModelTables::build()
+{
+  errors.clear();
+  // Global symbols first, then the local variables of each automaton
+  foreach ( Iov *io, model->getIos() ) {
+    if ( io->type == Iov::TyEvent ) syms.addEvent(io->name);
+    else syms.addGlobal(io->name);
+    }
+  QList<Automaton*> automatons = model->getAutomatons();
+  for ( int i=0; i<automatons.length(); i++ )
+    foreach ( Iov *v, automatons.at(i)->getVars() ) syms.addLocal(i, v->name);
+  sharedEvent = QVector<bool>(syms.getNbEvents(), false);
+  foreach ( QString e, model->getSharedEvents() ) sharedEvent[syms.event(e)] = true;
+  for ( int i=0; i<automatons.length(); i++ ) {
+    FsmTable *t = lower(automatons.at(i), i);
+    if ( t ) fsms.append(t);
+    }
+  initValues = QVector<int>(syms.getNbSlots(), 0); // Scratch slots are allocated during lowering
+  return errors.isEmpty();
+}
+
+// Parsing helpers. Fragments which cannot be parsed are reported and skipped
+
+template<class T> static T* parseFragment(QString text, QString what, QString origin, QStringList& errors, T* (FragmentParser::*parse)())
+{
+  FragmentParser parser(text);
+  T *r = (parser.*parse)();
+  if ( ! r ) errors << origin + ": cannot lower " + what + " \"" + text + "\" (" + parser.getError() + ")";
+  return r;
+}
+
+FsmTable* ModelTables::lower(Automaton *automaton, int fsm)
+{
+  QScopedPointer<FsmTable> t(new FsmTable);
+  t->name = automaton->getName();
+  t->fsm = fsm;
+  t->nbEvents = syms.getNbEvents();
+  t->initState = -1;
+  t->initAction = -1;
+  t->init = NULL;
+  foreach ( Iov *v, automaton->getVars() ) t->varNames.append(v->name);
+  int nbErrors = errors.length();
+  // States
+  QHash<State*,int> index;
+  QList<QList<Valuation*>> valuations;
+  for ( State *s : automaton->states() ) {
+    if ( s->isPseudo() ) continue;
+    index.insert(s, t->stateNames.length());
+    t->stateNames.append(s->getId());
+    t->states.append(s);
+    QList<Valuation*> vs;
+    foreach ( QString valuation, s->getAttrs() ) {
+      Valuation *v = parseFragment<Valuation>(valuation, "valuation", t->name + ", state " + s->getId(), errors, &FragmentParser::parseValuation);
+      if ( v ) vs.append(v);
+      }
+    valuations.append(vs);
+    }
+  t->nbStates = t->stateNames.length();
+  // Transitions, grouped by cell
+  QVector<QList<FsmTable::Entry>> cells(t->nbStates * t->nbEvents);
+  t->codeStart = code.code.length();
+  try {
+    for ( int i=0; i<t->nbStates; i++ ) t->enter.append(code.compileValuations(valuations.at(i), syms, fsm));
+    for ( Transition *tr : automaton->transitions() ) {
+      QString origin = t->name + ", transition " + tr->toString();
+      QList<Action*> actions;
+      foreach ( QString action, tr->getActions() ) {
+        Action *a = parseFragment<Action>(action, "action", origin, errors, &FragmentParser::parseAction);
+        if ( a ) actions.append(a);
+        }
+      int action = code.compileActions(actions, syms, fsm, synchronousActions);
+      qDeleteAll(actions);
+      if ( tr->isInitial() ) {
+        t->initState = index.value(tr->getDstState(), -1);
+        t->initAction = action;
+        t->init = tr;
+        continue;
+        }
+      QList<Expr*> guards;
+      foreach ( QString guard, tr->getGuards() ) {
+        Expr *g = parseFragment<Expr>(guard, "guard", origin, errors, &FragmentParser::parseGuard);
+        if ( g ) guards.append(g);
+        }
+      int guard = code.compileGuards(guards, syms, fsm);
+      qDeleteAll(guards);
+      int ev = syms.event(tr->getEvent());
+      if ( ev < 0 ) {
+        errors << origin + ": unknown event " + tr->getEvent();
+        continue;
+        }
+      FsmTable::Entry e;
+      e.guard = guard;
+      e.action = action;
+      e.dst = index.value(tr->getDstState());
+      e.id = t->transitions.length();
+      t->transitions.append(tr);
+      cells[index.value(tr->getSrcState()) * t->nbEvents + ev].append(e);
+      }
+    }
+  catch ( std::runtime_error& e ) {
+    errors << t->name + ": " + QString::fromStdString(e.what());
+    }
+  t->codeEnd = code.code.length();
+  foreach ( QList<Valuation*> vs, valuations ) qDeleteAll(vs);
+  if ( t->initState < 0 ) errors << t->name + ": no initial transition";
+  if ( errors.length() > nbErrors ) return NULL;
+  // Flatten
+  t->cells.resize(cells.size());
+  for ( int i=0; i<cells.size(); i++ ) {
+    t->cells[i].first = t->entries.size();
+    t->cells[i].count = cells.at(i).length();
+    foreach ( const FsmTable::Entry& e, cells.at(i) ) t->entries.append(e);
+    }
+  return t.take();
+}
+
+// Dependency analysis. Two automata depend on each other if they use the same output or shared variable
+// (whether reading or writing it), or the same shared event (whether emitting it or being triggered by it).
+// Inputs and input events are not modified during a reaction, so they create no dependency.
+// Clusters are the connected components of this relation
+
+static int root(QVector<int>& parent, int i)
+{
+  while ( parent.at(i) != i ) i = parent[i] = parent.at(parent.at(i));
+  return i;
+}
+
+QList<QVector<int>> ModelTables::clusters() const
+{
+  QHash<int,int> users; // Slot, or -1-event -> first automaton using it (-1 if none yet)
+  foreach ( Iov *io, model->getIos() )
+    if ( io->kind != Iov::IoIn && io->type != Iov::TyEvent ) users.insert(syms.global(io->name), -1);
+  for ( int e=0; e<sharedEvent.size(); e++ )
+    if ( sharedEvent.at(e) ) users.insert(-1-e, -1);
+  int n = fsms.length();
+  QVector<int> parent(n);
+  for ( int i=0; i<n; i++ ) parent[i] = i;
+  auto use = [&](int fsm, int key) {
+    auto u = users.find(key);
+    if ( u == users.end() ) return;
+    if ( u.value() < 0 ) u.value() = fsm;
+    else parent[root(parent, fsm)] = root(parent, u.value());
+  };
+  const qint32 *c = code.code.constData();
+  for ( int i=0; i<n; i++ ) {
+    const FsmTable *t = fsms.at(i);
+    for ( int pc=t->codeStart; pc<t->codeEnd; ) {
+      switch ( c[pc] ) {
+      case Bytecode::LOAD: use(i, c[pc+1]); pc += 2; break;
+      case Bytecode::STOREG: use(i, c[pc+1]); pc += 3; break;
+      case Bytecode::EMIT: use(i, -1-c[pc+1]); pc += 2; break;
+      case Bytecode::PUSH: case Bytecode::STORE: case Bytecode::JZ: case Bytecode::JMP: pc += 2; break;
+      default: pc++; break;
+      }
+    }
+    for ( int k=0; k<t->cells.size(); k++ )
+      if ( t->cells.at(k).count > 0 ) use(i, -1-(k % t->nbEvents));
+    }
+  QHash<int,int> rank; // Root -> cluster
+  QList<QVector<int>> r;
+  for ( int i=0; i<n; i++ ) {
+    int k = root(parent, i);
+    if ( ! rank.contains(k) ) {
+      rank.insert(k, r.length());
+      r.append(QVector<int>());
+      }
+    r[rank.value(k)].append(i);
+    }
+  return r;
+}
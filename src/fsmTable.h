@@ -0,0 +1,89 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QList>
+#include "bytecode.h"
+
+class Model;
+class Automaton;
+class Transition;
+class State;
+
+// Flat, table-based representation of the automata of a model, for simulation and exploration.
+//
+// Each automaton is lowered to a dense (state x event) table. Each cell gives the range of the
+// candidate transitions for this state and event in the [entries] array. Each entry refers to
+// pre-compiled guard, action and target state valuation code in the shared [Bytecode] block.
+// States and events are designated by their index (see [SymbolTable] for events and variables).
+
+class FsmTable
+{
+public:
+  struct Entry {
+    qint32 guard;   // Code offset
+    qint32 action;  // Code offset
+    qint32 dst;     // Target state
+    qint32 id;      // Rank of the transition in the automaton (see [transitions])
+  };
+  struct Cell {
+    qint32 first;   // Index in [entries]
+    qint32 count;
+  };
+
+  QString name;
+  int fsm;                   // Rank in the model
+  int nbStates;
+  int nbEvents;
+  QStringList stateNames;
+  QStringList varNames;      // Local variables
+  QVector<Cell> cells;       // nbStates x nbEvents, row-major
+  QVector<Entry> entries;
+  QVector<qint32> enter;     // Per-state valuation code offset
+  int initState;
+  qint32 initAction;
+  QList<Transition*> transitions; // Source transitions, indexed by [Entry::id]
+  QList<State*> states;           // Source states, indexed like [stateNames]
+  Transition *init;               // Source initial transition
+  qint32 codeStart, codeEnd;      // Range of its code in the shared [Bytecode] block
+
+  const Cell& cell(int state, int event) const { return cells.at(state * nbEvents + event); }
+};
+
+class ModelTables
+{
+public:
+  ModelTables(Model *model, bool synchronousActions = false);
+  ~ModelTables();
+
+  bool build(); // false on error (see [getErrors])
+  QStringList getErrors() { return errors; }
+  // Partition of the automata into independent clusters, each given by increasing rank (see [ClusterScheduler])
+  QList<QVector<int>> clusters() const;
+
+  Model *model;
+  SymbolTable syms;
+  Bytecode code;
+  QList<FsmTable*> fsms;
+  QVector<bool> sharedEvent;  // Indexed by event
+  QVector<int> initValues;    // Initial store
+
+private:
+  bool synchronousActions;
+  QStringList errors;
+
+  FsmTable* lower(Automaton *automaton, int fsm);
+};
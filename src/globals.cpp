@@ -15,16 +15,50 @@
 #include "compilerOptions.h"
 #include "compiler.h"
 #include "commandExec.h"
+#include "fragmentCache.h"
 #include <QRegularExpression>
+#include <QMessageBox>
+#include <stdio.h>
 
 const QString Globals::version = "2.0.0"; 
-const QStringList Globals::guiOnlyOpts = { "-dot_external_viewer", "-sync_externals" };
+const QStringList Globals::guiOnlyOpts = { "-dot_external_viewer", "-vcd_external_viewer", "-sync_externals", "-native_sim", "-compiled_sim", "-vcd_compress",
+                                            "-sim_snapshot_interval", "-sim_stop_time", "-sliced_sim", "-sim_threads", "-sim_log", "-sim_animation_delay", "-sim_profile",
+                                            "-explore_int_max", "-explore_max_states" };
 CompilerPaths *Globals::compilerPaths = NULL;
 CompilerOptions *Globals::compilerOptions = NULL;
 Compiler *Globals::compiler = NULL;
 CommandExec *Globals::executor = NULL;
+FragmentCache *Globals::fragmentCache = NULL;
 Globals::Mode Globals::mode = SelectItem;
 QString Globals::initDir = ".";
+QString Globals::simCacheDir = "";
 QWidget *Globals::mainWindow = NULL;
+bool Globals::batch = false;
+int Globals::nbWarnings = 0;
+quint64 Globals::revision = 0;
 //const QString Globals::defaultModelName = "main";
 const QRegularExpression Globals::re_lid("[a-z][A-Za-z0-9_]*");
+
+void Globals::init(QString appDir, QWidget *parent)
+{
+  compilerPaths = new CompilerPaths(appDir + "/grasp.ini", parent);
+  compilerOptions = new CompilerOptions(appDir + "/options_spec.txt", parent);
+  initDir = compilerPaths->getPath("INITDIR");
+  QString compilerPath = compilerPaths->getPath("COMPILER");
+  if ( compilerPath.isNull() || compilerPath.isEmpty() ) compilerPath = "rfsmc"; // Last chance..
+  compiler = new Compiler(compilerPath);
+  executor = new CommandExec();
+  fragmentCache = new FragmentCache(appDir + "/fragments.cache");
+  simCacheDir = appDir + "/simcache";
+}
+
+void Globals::warning(QString title, QString msg)
+{
+  if ( batch ) {
+    QString txt = title.isEmpty() ? msg : title + ": " + msg;
+    fprintf(stderr, "grasp: %s\n", txt.toLocal8Bit().constData());
+    nbWarnings++;
+    }
+  else
+    QMessageBox::warning(mainWindow, title, msg);
+}
@@ -20,6 +20,7 @@ class CompilerPaths;
 class CompilerOptions;
 class Compiler;
 class CommandExec;
+class FragmentCache;
 
 class Globals
 {
@@ -37,11 +38,20 @@ public:
     static CompilerOptions *compilerOptions;
     static Compiler *compiler; // For calling the rfsmc compiler
     static CommandExec *executor; // For calling externals commands
+    static FragmentCache *fragmentCache; // Persistent fragment check verdicts
     static QString initDir;
+    static QString simCacheDir; // Compiled simulation models
     const static QString version;
     const static QStringList guiOnlyOpts;
     static QWidget *mainWindow;
+    static bool batch; // Headless mode (see [Batch]): no widget is created
+    static int nbWarnings; // Reported in batch mode
+    static void warning(QString title, QString msg); // Message box, or stderr in batch mode
+    static void init(QString appDir, QWidget *parent); // Paths, options, compiler and caches
     // const static QString defaultModelName;
     static const QRegularExpression re_lid;
+    static quint64 newRevision() { return ++revision; } // Revision stamps for model items (see [State], [Transition], [Iov])
+private:
+    static quint64 revision;
 };
 
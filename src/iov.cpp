@@ -11,6 +11,12 @@
 /***********************************************************************/
 
 #include "iov.h"
+#include "globals.h"
+
+void Iov::touch()
+{
+  revision = Globals::newRevision();
+}
 
 Iov::IoKind Iov::ioKindOfString(QString s)
 {
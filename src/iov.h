@@ -30,14 +30,21 @@ public:
         const IoKind& kind,
         const IoType& type,
         const Stimulus& stim):
-  name(name), kind(kind), type(type), stim(stim) {};
+  name(name), kind(kind), type(type), stim(stim) { touch(); };
   ~Iov() { };
 
+  // The revision stamp changes whenever the name or type of the IO is modified 
+  quint64 getRevision() const { return revision; }
+  void touch();
+
   static IoKind ioKindOfString(QString s);
   static IoType ioTypeOfString(QString s);
   static QString stringOfKind(IoKind k);
   static QString stringOfType(IoType t);
   QString toString(bool withStim=true);
   static QString stringOfList(QList<Iov*> ios);
+
+private:
+  quint64 revision;
   };
 
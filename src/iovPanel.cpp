@@ -78,31 +78,13 @@ void setTypeSelector(QComboBox *type_selector, bool enabled, Iov* io)
 
 void setStimSelector(QComboBox *stim_selector, bool enabled, Iov* io)
 {
-  if ( enabled ) {
-    switch ( io->type ) {
-      case Iov::TyEvent: 
-        setComboBoxItemEnabled(stim_selector, 0, true); // None
-        setComboBoxItemEnabled(stim_selector, 1, true); // Periodic
-        setComboBoxItemEnabled(stim_selector, 2, true); // Sporadic
-        setComboBoxItemEnabled(stim_selector, 3, false); // ValueChanges
-        break;
-      case Iov::TyInt: 
-      case Iov::TyBool: 
-        setComboBoxItemEnabled(stim_selector, 0, true); // None
-        setComboBoxItemEnabled(stim_selector, 1, false); // Periodic
-        setComboBoxItemEnabled(stim_selector, 2, false); // Sporadic
-        setComboBoxItemEnabled(stim_selector, 3, true); // ValueChanges
-        break;
-      }
-    stim_selector->setCurrentIndex(io->stim.kind);
+  // Stimulus kinds applying to events (the others apply to int and bool inputs). [Repeat] and [File] apply to both
+  static const QList<bool> forEvents = { true, true, true, false, true, true, true, false, false, true, true };
+  for ( int k=0; k<forEvents.length(); k++ ) {
+    bool ok = enabled && ( k == Stimulus::None || k == Stimulus::Repeat || k == Stimulus::File || forEvents.at(k) == (io->type == Iov::TyEvent) );
+    setComboBoxItemEnabled(stim_selector, k, ok);
     }
-  else {
-    setComboBoxItemEnabled(stim_selector, 0, false); // None
-    setComboBoxItemEnabled(stim_selector, 1, false); // Periodic
-    setComboBoxItemEnabled(stim_selector, 2, false); // Sporadic
-    setComboBoxItemEnabled(stim_selector, 3, false); // ValueChanges
-    stim_selector->setCurrentIndex(-1);
-  }
+  stim_selector->setCurrentIndex(enabled ? io->stim.kind : -1);
 }
 
 void IovPanel::addRowFields(QHBoxLayout *row_layout, void *row_data)
@@ -157,6 +139,13 @@ void IovPanel::addRowFields(QHBoxLayout *row_layout, void *row_data)
     stim_selector->addItem("Periodic", QVariant(Stimulus::Periodic));
     stim_selector->addItem("Sporadic", QVariant(Stimulus::Sporadic));
     stim_selector->addItem("ValueChanges", QVariant(Stimulus::ValueChanges));
+    stim_selector->addItem("Random", QVariant(Stimulus::Random));
+    stim_selector->addItem("Poisson", QVariant(Stimulus::Poisson));
+    stim_selector->addItem("Bursty", QVariant(Stimulus::Bursty));
+    stim_selector->addItem("Counter", QVariant(Stimulus::Counter));
+    stim_selector->addItem("RandomValues", QVariant(Stimulus::RandomValues));
+    stim_selector->addItem("Repeat", QVariant(Stimulus::Repeat));
+    stim_selector->addItem("File", QVariant(Stimulus::File));
     setStimSelector(stim_selector, io->name != "", io);
     row_layout->addWidget(stim_selector);
     connect(stim_selector, QCOMBOBOX_ACTIVATED, this, &IovPanel::stimEdited);
@@ -248,6 +237,7 @@ void IovPanel::nameEdited()
     Iov* io = row_desc->io;
     qDebug() << "Setting input name to" << name;
     io->name = name;
+    io->touch();
   //   }
   emit modelModified();
 }
@@ -260,6 +250,7 @@ void IovPanel::typeEdited()
   Q_ASSERT(row_desc);
   Iov* io = row_desc->io;
   io->type = (Iov::IoType)(type_selector->currentIndex());
+  io->touch();
   qDebug () << "Setting IO type: " << io->type;
   if ( row_desc->io->kind == Iov::IoIn ) 
     updateStimChoices(row_desc);
@@ -11,6 +11,7 @@
 /***********************************************************************/
 
 #include "mainwindow.h"
+#include "batch.h"
 
 #include <QApplication>
 #include "debug.h"
@@ -19,6 +20,13 @@ int main(int argv, char *args[])
 {
     qInstallMessageHandler(debugMessageHandler); 
 
+    if ( Batch::requested(argv, args) ) {
+      // No window is created, so no display is needed
+      if ( qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM") ) qputenv("QT_QPA_PLATFORM", "offscreen");
+      QApplication app(argv, args); // Still required by the graphics scenes holding the automata
+      return Batch::run(app.arguments());
+      }
+
     QApplication app(argv, args);
     MainWindow mainWindow;
     mainWindow.setGeometry(100, 100, 1200, 700);
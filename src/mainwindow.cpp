@@ -24,6 +24,12 @@
 #include "compilerOptions.h"
 #include "commandExec.h"
 #include "compiler.h"
+#include "simulator.h"
+#include "sweepRunner.h"
+#include "explorer.h"
+#include "traceReplay.h"
+#include "replayAnimation.h"
+#include "waveformViewer.h"
 #include "debug.h"
 #include "stimuli.h"
 #include "modelPanel.h"
@@ -48,14 +54,8 @@ MainWindow::MainWindow()
     Globals::mainWindow = this;
     QString appDir = QApplication::applicationDirPath();
     qDebug() << "APPDIR=" << appDir;
-    Globals::compilerPaths = new CompilerPaths(appDir + "/grasp.ini", this);
+    Globals::init(appDir, this);
     connect(Globals::compilerPaths, SIGNAL(compilerPathChanged(QString)), this, SLOT(compilerPathUpdated(QString)));
-    Globals::compilerOptions = new CompilerOptions(appDir + "/options_spec.txt", this);
-    Globals::initDir = Globals::compilerPaths->getPath("INITDIR");
-    QString compilerPath = Globals::compilerPaths->getPath("COMPILER");
-    if ( compilerPath.isNull() || compilerPath.isEmpty() ) compilerPath = "rfsmc"; // Last chance..
-    Globals::compiler = new Compiler(compilerPath);
-    Globals::executor = new CommandExec();
 
     // GUI setup
 
@@ -78,6 +78,10 @@ MainWindow::MainWindow()
     model = new Model(QString(),this);
     Q_ASSERT(model);
 
+    animation = new ReplayAnimation(model, this);
+    connect(animation, SIGNAL(dateChanged(qint64)), this, SLOT(animationDate(qint64)));
+    connect(animation, SIGNAL(finished()), this, SLOT(animationFinished()));
+
     // Left panel
 
     model_panel = new ModelPanel(model,this); 
@@ -250,6 +254,31 @@ void MainWindow::createActions()
     runSimulationAction->setToolTip(tr("Simulate and open VCD viewer"));
     connect(runSimulationAction, SIGNAL(triggered()), this, SLOT(runSimulation()));
 
+    runSweepAction = new QAction(tr("Run stimulus sweep..."), this);
+    runSweepAction->setToolTip(tr("Simulate the model with each variant of the stimuli described in sweep files"));
+    connect(runSweepAction, SIGNAL(triggered()), this, SLOT(runSweep()));
+
+    exploreAction = new QAction(tr("Explore state space"), this);
+    exploreAction->setToolTip(tr("Enumerate the reachable configurations of the model, looking for unreachable states, deadlocks and errors"));
+    connect(exploreAction, SIGNAL(triggered()), this, SLOT(exploreModel()));
+
+    resumeSimulationAction = new QAction(tr("Resume simulation..."), this);
+    resumeSimulationAction->setToolTip(tr("Resume a simulation of the model from a snapshot saved by the built-in simulator"));
+    connect(resumeSimulationAction, SIGNAL(triggered()), this, SLOT(resumeSimulation()));
+
+    replayLogAction = new QAction(tr("Replay simulation log..."), this);
+    replayLogAction->setToolTip(tr("Rebuild the trace of a simulation from the log written by the built-in simulator"));
+    connect(replayLogAction, SIGNAL(triggered()), this, SLOT(replayLog()));
+
+    animateLogAction = new QAction(tr("Animate simulation log..."), this);
+    animateLogAction->setToolTip(tr("Show the states and transitions of a logged simulation on the automata, date by date"));
+    connect(animateLogAction, SIGNAL(triggered()), this, SLOT(animateLog()));
+
+    stopAnimationAction = new QAction(tr("Stop animation"), this);
+    stopAnimationAction->setToolTip(tr("Stop the animation of a simulation log and remove its highlighting"));
+    connect(stopAnimationAction, SIGNAL(triggered()), this, SLOT(stopAnimation()));
+    stopAnimationAction->setEnabled(false);
+
     zoomInAction = new QAction(tr("Zoom In"), this);
     zoomInAction->setShortcut(tr("Ctrl++"));
     connect(zoomInAction, SIGNAL(triggered()), this, SLOT(zoomIn()));
@@ -269,6 +298,11 @@ void MainWindow::createActions()
     closeResultsAction = new QAction(tr("Close all results_panel"), this);
     connect(closeResultsAction, SIGNAL(triggered()), this, SLOT(closeResultTabs()));
 
+    hideProfileAction = new QAction(tr("Hide firing profile"), this);
+    hideProfileAction->setToolTip(tr("Remove the heatmap painted on the automata by a profiled simulation"));
+    connect(hideProfileAction, SIGNAL(triggered()), this, SLOT(hideProfile()));
+    hideProfileAction->setEnabled(false);
+
     pathConfigAction = new QAction(tr("Compiler and tools"), this);
     connect(pathConfigAction, SIGNAL(triggered()), this, SLOT(setCompilerPaths()));
 
@@ -357,6 +391,14 @@ void MainWindow::updateViewActions()
     normalSizeAction->setEnabled(true);
     return;
     }
+  else if ( kind == "WaveformViewer" ) {
+    fitToWindowAction->setEnabled(true);
+    fitToWindowAction->setChecked(false);
+    zoomInAction->setEnabled(true);
+    zoomOutAction->setEnabled(true);
+    normalSizeAction->setEnabled(false);
+    return;
+    }
  unselect:
     fitToWindowAction->setEnabled(false);
     zoomInAction->setEnabled(false);
@@ -399,6 +441,12 @@ void MainWindow::createMenus()
     compileMenu->addAction(generateRfsmTestbenchAction);
     compileMenu->addSeparator();
     compileMenu->addAction(runSimulationAction);
+    compileMenu->addAction(runSweepAction);
+    compileMenu->addAction(exploreAction);
+    compileMenu->addAction(resumeSimulationAction);
+    compileMenu->addAction(replayLogAction);
+    compileMenu->addAction(animateLogAction);
+    compileMenu->addAction(stopAnimationAction);
 
     viewMenu = menuBar()->addMenu(tr("&View"));
     viewMenu->addAction(zoomInAction);
@@ -407,6 +455,7 @@ void MainWindow::createMenus()
     viewMenu->addAction(fitToWindowAction);
     viewMenu->addSeparator();
     viewMenu->addAction(closeResultsAction);
+    viewMenu->addAction(hideProfileAction);
 
     configMenu = menuBar()->addMenu("&Configuration");
     configMenu->addAction(pathConfigAction);
@@ -492,6 +541,7 @@ void MainWindow::openFile()
       QMessageBox::warning(this, "Error", "Unable to import : " + QString(e.what()));
       return;
       }
+    stopAnimation();
     closeAutomatonTabs();
     addAutomatonTabs(model);
     model_panel->update();
@@ -527,6 +577,7 @@ void MainWindow::newModel()
 {
   checkUnsavedChanges();
   model_panel->clear();
+  stopAnimation();
   closeAutomatonTabs();
   model->clear();
   currentFileName.clear();
@@ -738,7 +789,11 @@ void MainWindow::addResultTab(QString fname)
   QString tabName = f.suffix() == "gif" ? changeSuffix(f.fileName(),".dot") : f.fileName();
   for ( int i=0; i<results_panel->count(); i++ )
     if ( results_panel->tabText(i) == tabName ) closeResultTab(i); // Do not open two tabs with the same name
-  if ( f.suffix() == "gif" ) {
+  if ( f.suffix() == "vcd" ) {
+    WaveformViewer *viewer = new WaveformViewer(f.filePath(), results_panel);
+    results_panel->addTab(viewer, tabName);
+    }
+  else if ( f.suffix() == "gif" ) {
     QPixmap pixmap(f.filePath());
     ImageViewer *viewer = new ImageViewer(pixmap, results_panel);
     results_panel->addTab(viewer, tabName);
@@ -779,8 +834,11 @@ void MainWindow::openResultFile(QString fname)
         openResultFile(changeSuffix(fname, ".gif"));
       }
     }
-  else if ( f.suffix() == "vcd" ) {
-    QString gFile = changeSuffix(fname, ".gtkw");
+  else if ( f.suffix() == "vcd" && ! genOpts.contains("-vcd_external_viewer") ) {
+    addResultTab(fname);
+    }
+  else if ( f.suffix() == "vcd" || fname.endsWith(".vcd.gz") ) {
+    QString gFile = changeSuffix(f.suffix() == "gz" ? fname.left(fname.length()-3) : fname, ".gtkw");
     QFile gf(gFile);
     if ( gf.exists() ) args << gFile;
     customView("VCDVIEWER", args, wDir, true);
@@ -816,30 +874,8 @@ void MainWindow::generate(QString target, bool withTestbench)
   if ( fname.isEmpty() ) return;
   qDebug () << "generate.fname = " << fname;
   QString wDir = QFileInfo(fname).absolutePath();
-  QStringList genOpts = Globals::compilerOptions->getOptions("general");
-  QString targetDir = ".";
-  if ( target != "sim" && genOpts.contains("-target_dirs") ) {
-    targetDir = target;
-    QString targetPath = wDir + "/" + target; // TO FIX : do not use raw, OS-dependent "/" in file path
-    genOpts.removeOne("-target_dirs");
-    QDir dir(targetPath);
-    if ( ! dir.exists() ) {
-      qDebug() << "Creating directory " << targetPath;
-      QDir().mkdir(targetPath);
-      }
-    }
-  foreach ( QString opt, genOpts)
-    if ( genOpts.contains(opt) ) genOpts.removeOne(opt);
   QString mainName = model->getName().isEmpty() ? "main" : model->getName();
-  QStringList args =
-    QStringList()
-    << "-" + target
-    << "-main" << mainName
-    << "-target_dir" << targetDir
-    << genOpts
-    << Globals::compilerOptions->getOptions(target);
-  //if ( target == "sim" ) args << "-main" <<  fi.baseName();
-  if ( target == "ctask" || target == "systemc" ) args << "-show_models";
+  QStringList args = Globals::compiler->targetArgs(target, mainName, wDir);
   if ( Globals::compiler->run(fi.fileName(), args, wDir) ) {
     QStringList resFiles = Globals::compiler->getOutputFiles(target, wDir, mainName); 
     if ( ! resFiles.isEmpty() ) {
@@ -863,7 +899,256 @@ void MainWindow::generateSystemCTestbench() { generate("systemc", true); }
 void MainWindow::generateVHDLModel() { generate("vhdl", false); }
 void MainWindow::generateVHDLTestbench() { generate("vhdl", true); }
 
-void MainWindow::runSimulation() { generate("sim", true); }
+void MainWindow::runSimulation()
+{
+  QStringList simOpts = Globals::compilerOptions->getOptions("sim");
+  if ( simOpts.contains("-native_sim") )
+    simulate(simOpts);
+  else
+    generate("sim", true);
+}
+
+void MainWindow::simulate(QStringList simOpts)
+{
+  if ( ! checkModelWithStimuli() ) return;
+  QString sFname = getCurrentFileName();
+  if ( sFname.isEmpty() ) return;
+  QString mainName = model->getName().isEmpty() ? "main" : model->getName();
+  QString vcdFile = QFileInfo(sFname).absolutePath() + "/" + mainName + ".vcd";
+  int vcdIntSize;
+  bool compressed;
+  QString cxx;
+  QString warning = Simulator::settings(simOpts, vcdIntSize, compressed, cxx);
+  if ( ! warning.isEmpty() ) logMessage(warning);
+  if ( compressed ) vcdFile += ".gz";
+  Simulator simulator(model, simOpts.contains("-synchronous_actions"));
+  if ( ! cxx.isEmpty() ) simulator.setCompiled(Globals::simCacheDir, cxx);
+  simulator.setSnapshots(Simulator::intOption(simOpts, "-sim_snapshot_interval", 0), Simulator::intOption(simOpts, "-sim_stop_time", -1));
+  simulator.setThreads(Simulator::intOption(simOpts, "-sim_threads", 1));
+  simulator.setLog(simOpts.contains("-sim_log"));
+  simulator.setProfiling(simOpts.contains("-sim_profile"));
+  if ( simHistory.run(simulator, model, simOpts.join(" "), vcdFile, vcdIntSize, compressed) ) {
+    QString resumed = simHistory.getResumedAt() < 0 ? "" : " (re-simulated from t=" + QString::number(simHistory.getResumedAt()) + ")";
+    QStringList files = QStringList(vcdFile) + simulator.getSnapshots();
+    if ( ! simulator.getLogFile().isEmpty() ) files << simulator.getLogFile();
+    if ( ! simulator.getProfileFile().isEmpty() ) files << simulator.getProfileFile();
+    logMessage("Generated file(s) : " + files.join(", ") + resumed);
+    if ( ! simulator.getProfileFile().isEmpty() ) openResultFile(simulator.getProfileFile());
+    openResultFile(vcdFile);
+    showProfile(simulator.getProfile());
+    }
+  else
+    QMessageBox::warning(this, "", "Error when simulating model\n" + simulator.getErrors().join("\n"));
+  updateActions();
+}
+
+void MainWindow::resumeSimulation()
+{
+  if ( ! checkModelWithStimuli() ) return;
+  QString sFname = getCurrentFileName();
+  if ( sFname.isEmpty() ) return;
+  QString fname = QFileDialog::getOpenFileName(this, "Select snapshot", QFileInfo(sFname).absolutePath(), "Snapshots (*.snap)");
+  if ( fname.isEmpty() ) return;
+  SimSnapshot snapshot;
+  QString error;
+  if ( ! snapshot.load(fname, error) ) {
+    QMessageBox::warning(this, "", error);
+    return;
+    }
+  QStringList simOpts = Globals::compilerOptions->getOptions("sim");
+  int vcdIntSize;
+  bool compressed;
+  QString cxx;
+  QString warning = Simulator::settings(simOpts, vcdIntSize, compressed, cxx);
+  if ( ! warning.isEmpty() ) logMessage(warning);
+  QFileInfo f(fname);
+  QString vcdFile = f.absolutePath() + "/" + f.completeBaseName() + "_resumed.vcd" + (compressed ? ".gz" : "");
+  Simulator simulator(model, simOpts.contains("-synchronous_actions"));
+  if ( ! cxx.isEmpty() ) simulator.setCompiled(Globals::simCacheDir, cxx);
+  simulator.setSnapshots(Simulator::intOption(simOpts, "-sim_snapshot_interval", 0), Simulator::intOption(simOpts, "-sim_stop_time", -1));
+  simulator.setThreads(Simulator::intOption(simOpts, "-sim_threads", 1));
+  simulator.setLog(simOpts.contains("-sim_log"));
+  simulator.setProfiling(simOpts.contains("-sim_profile"));
+  if ( simulator.resume(snapshot, vcdFile, vcdIntSize, compressed) ) {
+    QStringList files = QStringList(vcdFile) + simulator.getSnapshots();
+    if ( ! simulator.getLogFile().isEmpty() ) files << simulator.getLogFile();
+    if ( ! simulator.getProfileFile().isEmpty() ) files << simulator.getProfileFile();
+    logMessage("Resumed at t=" + QString::number(snapshot.time) + ". Generated file(s) : " + files.join(", "));
+    if ( ! simulator.getProfileFile().isEmpty() ) openResultFile(simulator.getProfileFile());
+    openResultFile(vcdFile);
+    showProfile(simulator.getProfile());
+    }
+  else
+    QMessageBox::warning(this, "", "Error when resuming simulation\n" + simulator.getErrors().join("\n"));
+  updateActions();
+}
+
+void MainWindow::showProfile(const SimProfile& profile)
+{
+  stopAnimation(); // Both use the same highlighting
+  foreach ( Automaton *a, model->getAutomatons() ) {
+    if ( profile.isEmpty() ) a->hideProfile();
+    else a->showProfile(profile);
+    }
+  hideProfileAction->setEnabled(! profile.isEmpty());
+}
+
+void MainWindow::hideProfile()
+{
+  showProfile(SimProfile());
+}
+
+void MainWindow::animateLog()
+{
+  QString dir = currentFileName.isEmpty() ? "" : QFileInfo(currentFileName).absolutePath();
+  QString fname = QFileDialog::getOpenFileName(this, "Select simulation log", dir, "Simulation logs (*.glog)");
+  if ( fname.isEmpty() ) return;
+  hideProfile();
+  TraceReplay replay;
+  QString error;
+  if ( ! replay.open(fname) || ! animation->load(replay, error) ) {
+    QMessageBox::warning(this, "", "Error when replaying simulation log\n" + (error.isEmpty() ? replay.getError() : error));
+    return;
+    }
+  if ( animation->isTruncated() )
+    logMessage("Log " + fname + " is too long: only its first " + QString::number(ReplayAnimation::maxSteps) + " changes are animated");
+  QStringList simOpts = Globals::compilerOptions->getOptions("sim");
+  animation->start(Simulator::intOption(simOpts, "-sim_animation_delay", 500));
+  stopAnimationAction->setEnabled(true);
+}
+
+void MainWindow::stopAnimation()
+{
+  animation->stop();
+  stopAnimationAction->setEnabled(false);
+}
+
+void MainWindow::animationDate(qint64 time)
+{
+  logMessage("Animation: t=" + QString::number(time));
+}
+
+void MainWindow::animationFinished()
+{
+  logMessage("Animation finished");
+}
+
+void MainWindow::replayLog()
+{
+  QString dir = currentFileName.isEmpty() ? "" : QFileInfo(currentFileName).absolutePath();
+  QString fname = QFileDialog::getOpenFileName(this, "Select simulation log", dir, "Simulation logs (*.glog)");
+  if ( fname.isEmpty() ) return;
+  QStringList simOpts = Globals::compilerOptions->getOptions("sim");
+  int vcdIntSize;
+  bool compressed;
+  QString cxx;
+  Simulator::settings(simOpts, vcdIntSize, compressed, cxx);
+  QFileInfo f(fname);
+  QString vcdFile = f.absolutePath() + "/" + f.completeBaseName() + "_replay.vcd" + (compressed ? ".gz" : "");
+  TraceReplay replay;
+  if ( replay.open(fname) && replay.toVcd(vcdFile, vcdIntSize, compressed) ) {
+    logMessage("Replayed " + fname + ". Generated file : " + vcdFile);
+    openResultFile(vcdFile);
+    }
+  else
+    QMessageBox::warning(this, "", "Error when replaying simulation log\n" + replay.getError());
+}
+
+void MainWindow::runSweep()
+{
+  if ( ! checkModelWithStimuli() ) return;
+  QString sFname = getCurrentFileName();
+  if ( sFname.isEmpty() ) return;
+  QString dir = QFileInfo(sFname).absolutePath();
+  QStringList files = QFileDialog::getOpenFileNames(this, "Select sweep file(s)", dir, "Sweep files (*.sweep);;All files (*)");
+  if ( files.isEmpty() ) return;
+  QStringList simOpts = Globals::compilerOptions->getOptions("sim");
+  int vcdIntSize;
+  bool compressed;
+  QString cxx;
+  QString warning = Simulator::settings(simOpts, vcdIntSize, compressed, cxx);
+  if ( ! warning.isEmpty() ) logMessage(warning);
+  SweepRunner runner(model, simOpts.contains("-synchronous_actions"));
+  runner.setTrace(vcdIntSize, compressed);
+  runner.setSliced(simOpts.contains("-sliced_sim"));
+  if ( ! cxx.isEmpty() ) runner.setCompiled(Globals::simCacheDir, cxx);
+  QList<SweepRunner::Run> runs;
+  foreach ( QString f, files ) runner.parse(f, runs);
+  if ( ! runner.getErrors().isEmpty() ) {
+    QMessageBox::warning(this, "", "Error when reading sweep file(s)\n" + runner.getErrors().join("\n"));
+    return;
+    }
+  QProgressDialog progress("Running " + QString::number(runs.length()) + " simulations", "Abort", 0, runs.length(), this);
+  progress.setWindowModality(Qt::WindowModal);
+  progress.setMinimumDuration(500);
+  bool ok = runner.run(runs, dir, [&](int done) {
+    progress.setValue(done);
+    QCoreApplication::processEvents();
+    return ! progress.wasCanceled();
+    });
+  progress.setValue(runs.length());
+  if ( ! runner.getWarning().isEmpty() ) logMessage(runner.getWarning());
+  if ( ! ok && ! progress.wasCanceled() ) {
+    QMessageBox::warning(this, "", "Error when simulating model\n" + runner.getErrors().join("\n"));
+    return;
+    }
+  int nbFailed = 0;
+  foreach ( const SweepRunner::Run& r, runs ) {
+    if ( r.ok || ! r.done ) continue;
+    logMessage("Run " + r.name + ": " + r.errors.join("; "));
+    nbFailed++;
+    }
+  QString mainName = model->getName().isEmpty() ? "main" : model->getName();
+  QString summary = dir + "/" + mainName + "_sweep.csv";
+  if ( runner.writeSummary(summary, runs) ) {
+    logMessage("Sweep: " + QString::number(runs.length()) + " runs, " + QString::number(nbFailed) + " failed"
+               + (progress.wasCanceled() ? " (aborted)" : "") + ". Summary in " + summary);
+    openResultFile(summary);
+    }
+  else
+    QMessageBox::warning(this, "", runner.getErrors().join("\n"));
+  updateActions();
+}
+
+void MainWindow::exploreModel()
+{
+  if ( ! checkModel() ) return;
+  QString sFname = getCurrentFileName();
+  if ( sFname.isEmpty() ) return;
+  QString dir = QFileInfo(sFname).absolutePath();
+  QStringList simOpts = Globals::compilerOptions->getOptions("sim");
+  Explorer explorer(model, simOpts.contains("-synchronous_actions"));
+  explorer.setIntRange(Simulator::intOption(simOpts, "-explore_int_max", 3));
+  explorer.setMaxStates(Simulator::intOption(simOpts, "-explore_max_states", 1000000));
+  QProgressDialog progress("Exploring the state space", "Abort", 0, 0, this);
+  progress.setWindowModality(Qt::WindowModal);
+  progress.setMinimumDuration(500);
+  bool ok = explorer.run([&](int nbStates) {
+    progress.setLabelText("Exploring the state space (" + QString::number(nbStates) + " configurations)");
+    QCoreApplication::processEvents();
+    return ! progress.wasCanceled();
+    });
+  progress.reset();
+  if ( ! ok && ! progress.wasCanceled() ) {
+    QMessageBox::warning(this, "", "Error when exploring model\n" + explorer.getErrors().join("\n"));
+    return;
+    }
+  QString mainName = model->getName().isEmpty() ? "main" : model->getName();
+  QString report = dir + "/" + mainName + "_explore.txt";
+  QStringList files;
+  if ( explorer.writeReport(report, files) ) {
+    logMessage("Exploration: " + QString::number(explorer.getNbStates()) + " configurations, "
+               + QString::number(explorer.getUnreachable().length()) + " unreachable state(s), "
+               + QString::number(explorer.getDeadlocks().length()) + " deadlock(s), "
+               + QString::number(explorer.getFailures().length()) + " error(s)"
+               + (progress.wasCanceled() ? " (aborted)" : explorer.isComplete() ? "" : " (incomplete)")
+               + ". Report in " + report);
+    openResultFile(report);
+    }
+  else
+    QMessageBox::warning(this, "", explorer.getErrors().join("\n"));
+  updateActions();
+}
 
 bool MainWindow::dotTransform(QFileInfo f, QString wDir)
 {
@@ -888,8 +1173,10 @@ void MainWindow::setCodeFont()
   QFont font = QFontDialog::getFont(&ok, QFont("Courier", 10), this);
   //qDebug() << "Got font " << font.toString();
   if ( ok ) {
-    for ( int i=0; i<results_panel->count(); i++ )
-      (static_cast<QPlainTextEdit*>(results_panel->widget(i)))->document()->setDefaultFont(font);
+    for ( int i=0; i<results_panel->count(); i++ ) {
+      QPlainTextEdit *text = qobject_cast<QPlainTextEdit*>(results_panel->widget(i));
+      if ( text ) text->document()->setDefaultFont(font);
+      }
     codeFont = font;
     }
 }
@@ -926,6 +1213,10 @@ void MainWindow::fitToWindow()
     if ( viewer == NULL ) return;
     viewer->fitToWindow(fitToWindowAction->isChecked() );
     }
+  else if ( k == "WaveformViewer" ) {
+    static_cast<WaveformViewer*>(w)->fitToWindow();
+    fitToWindowAction->setChecked(false); // Not a mode for waveforms
+    }
   // updateSelectedTabTitle(); // TODO ? 
   //updateViewActions(viewer);
 }
@@ -942,6 +1233,10 @@ void MainWindow::scaleImage(double factor)
 {
   QWidget *w = selectedTab();
   QString k = w->metaObject()->className();
+  if ( k == "WaveformViewer" ) { // Time axis only, unbounded
+    static_cast<WaveformViewer*>(w)->zoom(factor);
+    return;
+    }
   currentScaleFactor = factor * currentScaleFactor;
   if ( k == "ImageViewer" ) {
     ImageViewer* viewer = static_cast<ImageViewer*>(w);
@@ -16,6 +16,7 @@
 #include "state.h"
 #include "modelPanel.h"
 #include "model.h"
+#include "simHistory.h"
 
 #include <QMainWindow>
 #include <QFileInfo>
@@ -41,6 +42,8 @@ class CompilerPaths;
 class CompilerOptions;
 class CommandExec;
 class Compiler;
+class SimProfile;
+class ReplayAnimation;
 QT_END_NAMESPACE
 
 class MainWindow : public QMainWindow
@@ -76,6 +79,15 @@ private slots:
     void generateVHDLModel();
     void generateVHDLTestbench();
     void runSimulation();
+    void runSweep();
+    void exploreModel();
+    void resumeSimulation();
+    void replayLog();
+    void animateLog();
+    void stopAnimation();
+    void animationFinished();
+    void animationDate(qint64 time);
+    void hideProfile();
     void closeAutomatonTab(int index);
     void closeResultTab(int index);
     void resultTabChanged(int index);
@@ -114,8 +126,11 @@ private:
     void addDotTab(void);
 #endif
     void openResultFile(QString fname);
+    void showProfile(const SimProfile& profile); // On the automata (an empty profile hides it)
     
     Model* model;
+    SimHistory simHistory; // Last run of the built-in simulator, for incremental re-simulation
+    ReplayAnimation *animation; // Of a simulation log, on the automata
     QMap<QWidget*,Automaton*> panelToAutomaton;
     QFrame *toolbar;
     QButtonGroup *buttons;
@@ -145,6 +160,13 @@ private:
     QAction *generateVHDLModelAction;
     QAction *generateVHDLTestbenchAction;
     QAction *runSimulationAction;
+    QAction *runSweepAction;
+    QAction *exploreAction;
+    QAction *resumeSimulationAction;
+    QAction *replayLogAction;
+    QAction *animateLogAction;
+    QAction *stopAnimationAction;
+    QAction *hideProfileAction;
     QAction *zoomInAction;
     QAction *zoomOutAction;
     QAction *normalSizeAction;
@@ -181,6 +203,7 @@ private:
     QStringList compile(QString target, QString wDir, QString srcFile, QStringList args);
     QStringList getOutputFiles(QString target, QString wdir);
     void generate(QString target, bool withTestbench);
+    void simulate(QStringList simOpts); // With the built-in simulator
     void customView(QString toolName, QStringList args, QString wDir, bool detach);
     void customView(QString toolName, QString fname, QString wDir);
     void exportDot();
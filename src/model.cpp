@@ -13,10 +13,10 @@
 #include "globals.h"
 #include "model.h"
 #include "include/nlohmann_json.h"
-#include <QMessageBox>
 #include <QInputDialog>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QTextStream>
 #include <QDebug>
 #include <QGuiApplication>
@@ -135,7 +135,7 @@ QStringList Model::getShared()
 
 void Model::report_error(QString msg)
 {
-  QMessageBox::warning(Globals::mainWindow, "", msg);
+  Globals::warning("", msg);
 }
 
 bool Model::check(bool withStimuli)
@@ -155,10 +155,28 @@ bool Model::check(bool withStimuli)
         report_error("No stimulus for input " + io->name);
         return false;
         }  
+      if ( io->kind == Iov::IoIn && Stimulus::isGenerator(io->stim.kind) ) {
+        QString err = Stimulus::check(io->stim.toString(), io->type == Iov::TyEvent);
+        if ( ! err.isEmpty() ) {
+          report_error("Input " + io->name + ": " + err);
+          return false;
+          }
+        }
       }
     }
-  for ( Automaton* a: automatons )
-    if ( ! a->check(ios) ) return false;
+  // Structural checks first, then all guards, actions and valuations in a single batch.
+  // Only the fragments which have been modified since the last successful check are submitted
+  QList<FragmentChecker::Fragment> fragments;
+  for ( Automaton* a: automatons ) {
+    if ( ! a->check(ios, false) ) return false;
+    fragments.append(a->fragments(true));
+    }
+  bool ok = FragmentChecker::check_batch(Globals::compiler, fragments);
+  for ( Automaton* a: automatons ) a->setChecked(fragments);
+  if ( ! ok ) {
+    report_error(FragmentChecker::errorReport(fragments));
+    return false;
+    }
   return true;
 }
 
@@ -168,9 +186,10 @@ void Model::readFromFile(QString fname)
 {
     QFile file(fname);
     qDebug() << "Reading model from file" << file.fileName();
+    Stimulus::baseDir = QFileInfo(fname).absolutePath(); // For file-backed stimuli
     file.open(QIODevice::ReadOnly);
     if ( file.error() != QFile::NoError ) {
-      QMessageBox::warning(Globals::mainWindow, "","Cannot open file " + file.fileName());
+      Globals::warning("","Cannot open file " + file.fileName());
       return;
       }
     QTextStream is(&file);
@@ -225,9 +244,10 @@ void Model::saveToFile(QString fname)
 {
     QFile file(fname);
     qDebug() << "Saving model to file" << file.fileName();
+    Stimulus::baseDir = QFileInfo(fname).absolutePath();
     file.open(QIODevice::WriteOnly | QIODevice::Text);
     if ( file.error() != QFile::NoError ) {
-      QMessageBox::warning(Globals::mainWindow, "","Cannot open file " + file.fileName());
+      Globals::warning("","Cannot open file " + file.fileName());
       return;
       }
 
@@ -240,7 +260,7 @@ void Model::saveToFile(QString fname)
     for ( const Iov* io: ios ) {
       nlohmann::json json;
       if ( io->name == "" ) {
-        QMessageBox::warning(Globals::mainWindow, "Warning", "IO #" + QString::number(cnt) + " has no name. Ignoring it");
+        Globals::warning("Warning", "IO #" + QString::number(cnt) + " has no name. Ignoring it");
         continue;
         }
       json["name"] = io->name.toStdString(); 
@@ -296,7 +316,7 @@ QString Model::exportSingleDot(Automaton *automaton, QString basename, QStringLi
   QFile file(fname);
   file.open(QIODevice::WriteOnly | QIODevice::Text);
   if ( file.error() != QFile::NoError ) {
-    QMessageBox::warning(Globals::mainWindow, "","Cannot open file " + file.fileName());
+    Globals::warning("","Cannot open file " + file.fileName());
     return QString();
     }
   QTextStream os(&file);
@@ -334,7 +354,7 @@ void Model::exportDot(QString fname, QStringList options)
   QFile file(fname);
   file.open(QIODevice::WriteOnly | QIODevice::Text);
   if ( file.error() != QFile::NoError ) {
-    QMessageBox::warning(Globals::mainWindow, "","Cannot open file " + file.fileName());
+    Globals::warning("","Cannot open file " + file.fileName());
     return;
   }
   QTextStream os(&file);
@@ -365,54 +385,48 @@ void Model::exportDot(QString fname, QStringList options)
 
 // RFSM export
 
-QString export_rfsm_stim(Stimulus &st) 
+void export_rfsm_stim(QTextStream& os, Stimulus &st) 
 // We cannot use Stimulus::toString() since the syntax is different :(
+// Occurrences are written as they are enumerated, since generated and file-backed stimuli can be very long
 {
-  QString r;
   switch ( st.kind ) {
-  case Stimulus::None: return "";
+  case Stimulus::None: return;
   case Stimulus::Periodic:
-    r = "periodic(";
-    r +=      QString::number(st.desc.periodic.period);
-    r += "," + QString::number(st.desc.periodic.start_time);
-    r += "," + QString::number(st.desc.periodic.end_time) + ")";
+    os << "periodic(";
+    os <<        QString::number(st.desc.periodic.period);
+    os << "," << QString::number(st.desc.periodic.start_time);
+    os << "," << QString::number(st.desc.periodic.end_time) << ")";
     break;
-  case Stimulus::Sporadic:
-    r = "sporadic(";
-    for ( const auto t: st.desc.sporadic.dates ) {
-      r += " " + QString::number(t);
-      r += ",";
+  default: {
+    // Generators and file-backed stimuli have no RFSM counterpart and are expanded
+    StimulusCursor c(st);
+    bool values = st.hasValues();
+    os << (values ? "value_changes(" : "sporadic(");
+    int t, v;
+    for ( int i=0; c.next(t, v); i++ ) {
+      if ( i > 0 ) os << ",";
+      os << QString::number(t);
+      if ( values ) os << ":" << QString::number(v);
       }
-    if ( r.endsWith(",") ) r.chop(1);
-    r += ")";
-    break;
-  case Stimulus::ValueChanges: 
-    r = "value_changes(";
-    for ( const QPair<int,int> &vc: st.desc.valueChanges.vcs ) {
-      r += QString::number(vc.first) + ":" + QString::number(vc.second);
-      r += ",";
-      }
-    if ( r.endsWith(",") ) r.chop(1);
-    r += ")";
+    os << ")";
     break;
+    }
   }
-  return r;
 }
 void Model::export_rfsm_ios(QTextStream& os)
 {
     // QList<Iov*> gios;
-    QString ss;
     for ( const auto io : ios ) {
       switch ( io->kind ) {
         case Iov::IoIn:
-          ss = export_rfsm_stim(io->stim);
-          if ( ss != "" )  {
-            os << "input " << io->name << " : " << Iov::stringOfType(io->type) << " = " << ss;;
+          if ( io->stim.kind != Stimulus::None )  {
+            os << "input " << io->name << " : " << Iov::stringOfType(io->type) << " = ";
+            export_rfsm_stim(os, io->stim);
             // gios.append(io);
             os << "\n";
             }
           else {
-            QMessageBox::warning(Globals::mainWindow, "","No stimulus for input " + io->name);
+            Globals::warning("","No stimulus for input " + io->name);
             return;
             }
           break;
@@ -435,7 +449,7 @@ void Model::exportRfsm(QString fname, bool withTestbench)
   QFile file(fname);
   file.open(QIODevice::WriteOnly | QIODevice::Text);
   if ( file.error() != QFile::NoError ) {
-    QMessageBox::warning(Globals::mainWindow, "","Cannot open file " + file.fileName());
+    Globals::warning("","Cannot open file " + file.fileName());
     return;
   }
   QTextStream os(&file);
@@ -0,0 +1,208 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "nativeChecker.h"
+#include "fragmentParser.h"
+#include "automaton.h"
+#include "model.h"
+#include <QScopedPointer>
+
+NativeChecker::NativeChecker(Automaton *automaton)
+{
+  bind(automaton->enclosingModel()->getIos());
+  bind(automaton->getVars());
+}
+
+NativeChecker::NativeChecker(QList<Iov*> ios, QList<Iov*> vars)
+{
+  bind(ios);
+  bind(vars);
+}
+
+void NativeChecker::bind(QList<Iov*> ios)
+{
+  foreach ( Iov* iov, ios ) env.insert(iov->name, iov);
+}
+
+QStringList NativeChecker::getErrors()
+{
+  return errors;
+}
+
+NativeChecker::Verdict NativeChecker::fail(const TypeError& err)
+{
+  errors << err.msg;
+  return err.unsupported ? Unsupported : Error;
+}
+
+Iov* NativeChecker::lookup(QString id)
+{
+  Iov *iov = env.value(id, NULL);
+  if ( ! iov ) throw TypeError("unbound identifier \"" + id + "\"");
+  return iov;
+}
+
+QString NativeChecker::stringOfTy(Ty t)
+{
+  switch ( t ) {
+  case TInt: return "int";
+  case TBool: return "bool";
+  case TBit: return "int";
+  }
+  return "";
+}
+
+NativeChecker::Ty NativeChecker::unify(Ty t1, Ty t2, const Expr *e)
+{
+  if ( t1 == t2 ) return t1;
+  if ( t1 == TBit ) return t2;
+  if ( t2 == TBit ) return t1;
+  throw TypeError("type mismatch in \"" + e->toString() + "\" (" + stringOfTy(t1) + " vs " + stringOfTy(t2) + ")");
+}
+
+void NativeChecker::expect(Ty expected, const Expr *e)
+{
+  Ty t = type_of(e);
+  if ( t == expected || t == TBit ) return;
+  throw TypeError("\"" + e->toString() + "\" has type " + stringOfTy(t) + " but is used with type " + stringOfTy(expected));
+}
+
+NativeChecker::Ty NativeChecker::type_of(const Expr *e)
+{
+  switch ( e->kind ) {
+  case Expr::EInt:
+    return e->value == 0 || e->value == 1 ? TBit : TInt;
+  case Expr::EBool:
+    return TBool;
+  case Expr::EVar: {
+    Iov *iov = lookup(e->name);
+    switch ( iov->type ) {
+    case Iov::TyInt: return TInt;
+    case Iov::TyBool: return TBool;
+    case Iov::TyEvent: throw TypeError("event \"" + e->name + "\" cannot be used in an expression");
+    }
+    }
+    break;
+  case Expr::EUnop:
+    if ( e->name == "!" ) { expect(TBool, e->args.at(0)); return TBool; }
+    expect(TInt, e->args.at(0));
+    return TInt;
+  case Expr::EBinop: {
+    const QString& op = e->name;
+    const Expr *e1 = e->args.at(0), *e2 = e->args.at(1);
+    if ( op == "&&" || op == "||" ) {
+      expect(TBool, e1);
+      expect(TBool, e2);
+      return TBool;
+      }
+    if ( op == "=" || op == "!=" ) {
+      unify(type_of(e1), type_of(e2), e);
+      return TBool;
+      }
+    if ( op == "<" || op == ">" || op == "<=" || op == ">=" ) {
+      expect(TInt, e1);
+      expect(TInt, e2);
+      return TBool;
+      }
+    if ( op == "&" || op == "|" || op == "^" ) {
+      Ty t = unify(type_of(e1), type_of(e2), e);
+      if ( t == TBool ) throw TypeError("bitwise operator on booleans", true);
+      return TInt;
+      }
+    expect(TInt, e1); // Arithmetic and shift operators
+    expect(TInt, e2);
+    return TInt;
+    }
+  case Expr::EBit:
+    expect(TInt, e->args.at(0));
+    expect(TInt, e->args.at(1));
+    return TBit;
+  case Expr::ERange:
+    expect(TInt, e->args.at(0));
+    expect(TInt, e->args.at(1));
+    expect(TInt, e->args.at(2));
+    return TInt;
+  case Expr::ECast:
+    type_of(e->args.at(0));
+    return e->name == "bool" ? TBool : TInt;
+  case Expr::ECond:
+    expect(TBool, e->args.at(0));
+    return unify(type_of(e->args.at(1)), type_of(e->args.at(2)), e);
+  }
+  return TInt;
+}
+
+NativeChecker::Verdict NativeChecker::check_guard(QString guard)
+{
+  errors.clear();
+  FragmentParser parser(guard);
+  QScopedPointer<Expr> e(parser.parseGuard());
+  if ( e.isNull() ) return fail(TypeError(parser.getError(), parser.isUnsupported()));
+  try {
+    expect(TBool, e.data());
+    }
+  catch ( TypeError& err ) {
+    return fail(err);
+    }
+  return Ok;
+}
+
+NativeChecker::Verdict NativeChecker::check_action(QString action)
+{
+  errors.clear();
+  FragmentParser parser(action);
+  QScopedPointer<Action> a(parser.parseAction());
+  if ( a.isNull() ) return fail(TypeError(parser.getError(), parser.isUnsupported()));
+  try {
+    Iov *iov = lookup(a->lhs);
+    if ( iov->kind == Iov::IoIn ) throw TypeError("input \"" + a->lhs + "\" cannot be assigned or emitted");
+    if ( a->kind == Action::Emit ) {
+      if ( iov->type != Iov::TyEvent ) throw TypeError("\"" + a->lhs + "\" is not an event and cannot be emitted");
+      }
+    else {
+      if ( iov->type == Iov::TyEvent ) throw TypeError("event \"" + a->lhs + "\" cannot be assigned");
+      expect(iov->type == Iov::TyBool ? TBool : TInt, a->rhs);
+      }
+    }
+  catch ( TypeError& err ) {
+    return fail(err);
+    }
+  return Ok;
+}
+
+NativeChecker::Verdict NativeChecker::check_state_valuation(QString valuation)
+{
+  errors.clear();
+  FragmentParser parser(valuation);
+  QScopedPointer<Valuation> v(parser.parseValuation());
+  if ( v.isNull() ) return fail(TypeError(parser.getError(), parser.isUnsupported()));
+  try {
+    Iov *iov = lookup(v->output);
+    if ( iov->kind != Iov::IoOut ) throw TypeError("\"" + v->output + "\" is not an output");
+    if ( iov->type == Iov::TyEvent ) throw TypeError("event output \"" + v->output + "\" cannot be valuated");
+    expect(iov->type == Iov::TyBool ? TBool : TInt, v->value);
+    if ( ! v->value->isConst() ) throw TypeError("non constant state valuation", true);
+    }
+  catch ( TypeError& err ) {
+    return fail(err);
+    }
+  return Ok;
+}
+
+NativeChecker::Verdict NativeChecker::check(QString kind, QString frag)
+{
+  if ( kind == "guard" ) return check_guard(frag);
+  else if ( kind == "action" ) return check_action(frag);
+  else if ( kind == "sval" ) return check_state_valuation(frag);
+  errors.clear();
+  return fail(TypeError("unknown fragment kind " + kind, true));
+}
@@ -0,0 +1,66 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include "iov.h"
+
+class Automaton;
+class Expr;
+
+// In-process syntax and type checker for guards, actions and state valuations.
+// Fragments are checked against the IOs of the enclosing model and the variables of the automaton.
+// The [Unsupported] verdict is returned for fragments using constructs outside of the subset
+// handled here, in which case the decision must be left to the compiler (see [FragmentChecker]).
+//
+// Typing rules
+// - integer constants 0 and 1 (and bit extractions [e[i]]) can be used where a boolean is expected
+// - events can only be emitted (action [e]) and cannot appear in expressions
+// - inputs cannot be assigned, only outputs can be valuated in states
+
+class NativeChecker
+{
+public:
+  enum Verdict { Ok, Error, Unsupported };
+
+  NativeChecker(Automaton *automaton);
+  NativeChecker(QList<Iov*> ios, QList<Iov*> vars);
+
+  Verdict check(QString kind, QString frag); // kind is "guard", "action" or "sval"
+  Verdict check_guard(QString guard);
+  Verdict check_action(QString action);
+  Verdict check_state_valuation(QString valuation);
+  QStringList getErrors();
+
+private:
+  enum Ty { TInt, TBool, TBit }; // TBit : 0/1 integer, compatible with both TInt and TBool
+  struct TypeError { // Raised internally
+    TypeError(QString msg, bool unsupported=false) : msg(msg), unsupported(unsupported) { }
+    QString msg;
+    bool unsupported;
+  };
+
+  QHash<QString,Iov*> env;
+  QStringList errors;
+
+  void bind(QList<Iov*> ios);
+  Iov* lookup(QString id);
+  Ty type_of(const Expr *e);
+  Ty unify(Ty t1, Ty t2, const Expr *e);
+  void expect(Ty expected, const Expr *e);
+  static QString stringOfTy(Ty t);
+  Verdict fail(const TypeError& err);
+};
@@ -21,6 +21,7 @@
 #define QCOMBOBOX_ACTIVATED (&QComboBox::activated)
 #define POLYLINE_INTERSECT polyLine.intersects
 #define QSET_FROM_LIST(type,qlist) (QSet<type> (qlist.constBegin(), qlist.constEnd()))
+#define WHEEL_EVENT_X(e) (e->position().x())
 #else
 #define QT_ENDL endl
 #define SKIP_EMPTY_PARTS QString::SkipEmptyParts
@@ -30,4 +31,5 @@
 #define QCOMBOBOX_ACTIVATED (QOverload<int>::of(&QComboBox::activated))
 #define POLYLINE_INTERSECT polyLine.intersect
 #define QSET_FROM_LIST(type,qlist) (QSet<type>::fromList(qlist))
+#define WHEEL_EVENT_X(e) (e->pos().x())
 #endif
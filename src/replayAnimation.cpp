@@ -0,0 +1,127 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+
+#include "replayAnimation.h"
+#include "traceReplay.h"
+#include "model.h"
+#include "automaton.h"
+#include "transition.h"
+#include <QTimer>
+
+const int ReplayAnimation::maxSteps = 1000000;
+
+ReplayAnimation::ReplayAnimation(Model *model, QObject *parent) : QObject(parent)
+{
+  this->model = model;
+  this->pos = 0;
+  this->truncated = false;
+  timer = new QTimer(this);
+  connect(timer, SIGNAL(timeout()), this, SLOT(step()));
+}
+
+bool ReplayAnimation::load(TraceReplay& replay, QString& error)
+{
+  stop();
+  fsms = replay.getHeader().fsms;
+  int nbIos = replay.getHeader().ioNames.length();
+  steps.clear();
+  truncated = false;
+  auto add = [&](qint64 t, int fsm, int state, int transition) {
+    if ( steps.length() >= maxSteps ) {
+      truncated = true;
+      return;
+      }
+    steps.append(Step { t, fsm, state, transition });
+  };
+  bool ok = replay.replay(
+    [&](qint64 t, int s, int v) { if ( s >= nbIos ) add(t, s - nbIos, v, -1); },
+    [&](qint64 t, int f, int tr) { add(t, f, -1, tr); });
+  if ( ! ok ) error = replay.getError();
+  pos = 0;
+  current = QVector<int>(fsms.length(), -1);
+  return ok;
+}
+
+Automaton* ReplayAnimation::automaton(int fsm) const
+{
+  foreach ( Automaton *a, model->getAutomatons() )
+    if ( a->getName() == fsms.at(fsm).name ) return a;
+  return NULL;
+}
+
+State* ReplayAnimation::state(int fsm, int state) const
+{
+  Automaton *a = automaton(fsm);
+  return a ? a->getState(fsms.at(fsm).states.at(state)) : NULL;
+}
+
+// Transitions are numbered as in [FsmTable], skipping the initial one
+
+Transition* ReplayAnimation::transition(int fsm, int transition) const
+{
+  Automaton *a = automaton(fsm);
+  if ( ! a ) return NULL;
+  int k = 0;
+  foreach ( Transition *t, a->transitions() ) {
+    if ( t->isInitial() ) continue;
+    if ( k++ == transition ) return t->toString() == fsms.at(fsm).labels.at(transition) ? t : NULL;
+    }
+  return NULL;
+}
+
+void ReplayAnimation::start(int delay)
+{
+  pos = 0;
+  current.fill(-1);
+  step();
+  timer->start(delay);
+}
+
+bool ReplayAnimation::isRunning() const
+{
+  return timer->isActive();
+}
+
+void ReplayAnimation::stop()
+{
+  timer->stop();
+  clear();
+}
+
+void ReplayAnimation::clear()
+{
+  foreach ( Automaton *a, model->getAutomatons() ) a->hideProfile();
+}
+
+// All the changes occuring at the next date
+
+void ReplayAnimation::step()
+{
+  if ( pos >= steps.length() ) {
+    timer->stop();
+    emit finished();
+    return;
+    }
+  clear();
+  qint64 time = steps.at(pos).time;
+  QString info = "t=" + QString::number(time);
+  for ( ; pos < steps.length() && steps.at(pos).time == time; pos++ ) {
+    const Step& s = steps.at(pos);
+    if ( s.state >= 0 ) current[s.fsm] = s.state;
+    else if ( Transition *t = transition(s.fsm, s.transition) ) t->setHeat(1, info);
+    }
+  for ( int f=0; f<current.size(); f++ )
+    if ( current.at(f) >= 0 )
+      if ( State *st = state(f, current.at(f)) ) st->setHeat(1, info);
+  emit dateChanged(time);
+}
@@ -0,0 +1,78 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QVector>
+#include "traceLog.h"
+
+class QTimer;
+class Model;
+class Automaton;
+class State;
+class Transition;
+class TraceReplay;
+
+// Animation of a simulation log (see [TraceReplay]) on the automata of a model. At each tick of a timer,
+// the log advances to its next date: the current state of each automaton and the transitions taken at this
+// date are highlighted, with the colors of the firing profile heatmap (see [State::setHeat]).
+//
+// Automata, states and transitions are looked up by name and label at each date, so that the model can be
+// edited (or a log animated on a model modified since): changes concerning items which no longer exist
+// are skipped.
+
+class ReplayAnimation : public QObject
+{
+  Q_OBJECT
+
+public:
+  ReplayAnimation(Model *model, QObject *parent = NULL);
+
+  bool load(TraceReplay& replay, QString& error); // Reads the whole log (up to [maxSteps] changes)
+  bool isTruncated() const { return truncated; }
+  void start(int delay);  // In ms, between two dates
+  void stop();            // Also removes the highlighting
+  bool isRunning() const;
+
+  static const int maxSteps;
+
+signals:
+  void dateChanged(qint64 time);
+  void finished();
+
+private slots:
+  void step();
+
+private:
+  struct Step {
+    qint64 time;
+    int fsm;
+    int state;        // Index of the new state, or -1
+    int transition;   // Index of the transition taken (in the log), or -1
+  };
+  Model *model;
+  QTimer *timer;
+  QList<Step> steps;
+  int pos;                               // Next step
+  bool truncated;
+  QList<TraceLog::Fsm> fsms;             // From the header of the log
+  QVector<int> current;                  // State of each FSM, -1 before the first one
+
+  Automaton* automaton(int fsm) const;   // NULL if not found in the model
+  State* state(int fsm, int state) const;
+  Transition* transition(int fsm, int transition) const;
+  void clear();
+};
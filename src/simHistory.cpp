@@ -0,0 +1,191 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+
+#include "simHistory.h"
+#include "simulator.h"
+#include "vcdCheckpoints.h"
+#include "model.h"
+#include "automaton.h"
+#include "transition.h"
+#include "iov.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDebug>
+#include <climits>
+
+const int SimHistory::checkpointPeriod = 256;
+
+SimHistory::Fingerprint SimHistory::fingerprintOf(Model *model)
+{
+  Fingerprint fp;
+  QStringList global;
+  foreach ( Iov *io, model->getIos() ) global << io->toString(false);
+  foreach ( Automaton *a, model->getAutomatons() ) global << a->getName();
+  fp.insert("", global.join(";"));
+  foreach ( Automaton *a, model->getAutomatons() ) {
+    QStringList vars;
+    foreach ( Iov *v, a->getVars() ) vars << v->toString(false);
+    Transition *init = a->initTransition();
+    fp.insert(a->getName(), vars.join(";") + "|" + (init ? init->toString() : ""));
+    foreach ( State *s, a->states() ) {
+      if ( s->isPseudo() ) continue;
+      QStringList transitions;
+      foreach ( Transition *t, s->getTransitionsOut() ) transitions << t->toString();
+      transitions.sort(); // Their order is not significant
+      fp.insert(a->getName() + "." + s->getId(), s->getAttrs().join(",") + "|" + transitions.join(";"));
+      }
+    }
+  return fp;
+}
+
+int SimHistory::firstDifference(const Stimulus& s1, const Stimulus& s2)
+{
+  StimulusCursor c1(s1), c2(s2);
+  int t1, v1, t2, v2;
+  while ( true ) {
+    bool ok1 = c1.next(t1, v1);
+    bool ok2 = c2.next(t2, v2);
+    if ( ! ok1 && ! ok2 ) return INT_MAX;
+    if ( ! ok1 ) return t2;
+    if ( ! ok2 ) return t1;
+    if ( t1 != t2 || v1 != v2 ) return qMin(t1, t2);
+    }
+}
+
+// Earliest date at which a run with [fp] and [stims] can differ from the recorded one
+
+int SimHistory::divergence(const Fingerprint& fp, const QHash<QString,Stimulus>& stims) const
+{
+  if ( fp.value("") != fingerprint.value("") ) return 0;
+  int d = INT_MAX;
+  for ( auto i = fp.constBegin(); i != fp.constEnd(); ++i ) {
+    if ( i.value() == fingerprint.value(i.key()) ) continue;
+    if ( ! i.key().contains('.') ) return 0; // Variables or initial transition
+    d = qMin(d, firstVisits.value(i.key(), INT_MAX)); // States never visited do not matter
+    }
+  for ( auto i = stims.constBegin(); i != stims.constEnd(); ++i ) {
+    Stimulus old = stimuli.value(i.key(), Stimulus(Stimulus::None));
+    // A file-backed stimulus is unchanged if its file has not been modified since the recorded run
+    if ( i.value().kind == Stimulus::File && i.value().toString() == old.toString()
+         && QFileInfo(i.value().filePath()).lastModified() < vcdDate ) continue;
+    d = qMin(d, firstDifference(i.value(), old));
+    }
+  return d;
+}
+
+// Offset of the end of date [time] in the recorded trace, searched from the last checkpoint of its index
+
+qint64 SimHistory::endOf(int time) const
+{
+  QFile file(vcdFile);
+  if ( ! file.open(QIODevice::ReadOnly) ) return -1;
+  VcdCheckpoints index;
+  if ( index.load(vcdFile, nbSignals) ) {
+    const VcdCheckpoints::Checkpoint *c = index.before(time);
+    if ( c ) file.seek(c->offset);
+    }
+  while ( ! file.atEnd() ) {
+    qint64 pos = file.pos();
+    QByteArray line = file.readLine();
+    if ( line.startsWith('#') && line.mid(1).trimmed().toLongLong() > time ) return pos;
+    }
+  return file.size();
+}
+
+// Replaces what follows offset [cut] in [prefixFile] by the dates after [time] of [tailFile], which
+// has been written by a run resumed at [time], and moves the result to [tailFile]
+
+bool SimHistory::splice(QString prefixFile, qint64 cut, QString tailFile, int time)
+{
+  QFile prefix(prefixFile), tail(tailFile);
+  if ( ! prefix.open(QIODevice::ReadWrite) || ! tail.open(QIODevice::ReadOnly) ) return false;
+  // Start of the first date after [time] in the tail (it starts with a dump of all values at [time])
+  while ( ! tail.atEnd() ) {
+    qint64 pos = tail.pos();
+    QByteArray line = tail.readLine();
+    if ( line.startsWith('#') && line.mid(1).trimmed().toLongLong() > time ) {
+      tail.seek(pos);
+      break;
+      }
+    }
+  if ( ! prefix.resize(cut) || ! prefix.seek(cut) ) return false;
+  while ( ! tail.atEnd() )
+    if ( prefix.write(tail.read(1 << 20)) < 0 ) return false;
+  prefix.close();
+  tail.close();
+  QFile::remove(VcdCheckpoints::fileOf(tailFile)); // Stale, rebuilt by the viewer
+  return QFile::remove(tailFile) && QFile::rename(prefixFile, tailFile);
+}
+
+bool SimHistory::run(Simulator& sim, Model *model, QString settings, QString vcdFile, int vcdIntSize, bool vcdCompressed)
+{
+  resumedAt = -1;
+  Fingerprint fp = fingerprintOf(model);
+  QHash<QString,Stimulus> stims;
+  foreach ( Iov *io, model->getIos() )
+    if ( io->kind == Iov::IoIn ) stims.insert(io->name, io->stim);
+  // Last checkpoint before the divergence date
+  SimSnapshot from;
+  QFileInfo f(vcdFile);
+  if ( valid && ! vcdCompressed && ! sim.isLogging() && ! sim.isProfiling() && vcdFile == this->vcdFile && settings == this->settings
+       && f.exists() && f.size() == vcdSize && f.lastModified() == vcdDate ) {
+    int d = divergence(fp, stims);
+    foreach ( const SimSnapshot& c, checkpoints )
+      if ( c.time < d ) {
+        from = c;
+        resumedAt = c.time;
+        }
+    }
+  sim.setCheckpoints(checkpointPeriod);
+  bool ok = false;
+  if ( resumedAt >= 0 ) {
+    // The recorded trace is kept aside while the rest of the run is written
+    QString prev = f.path() + "/" + f.completeBaseName() + "_prev.vcd";
+    qint64 cut = endOf(resumedAt);
+    QFile::remove(prev);
+    QFile::remove(VcdCheckpoints::fileOf(vcdFile));
+    if ( cut >= 0 && QFile::rename(vcdFile, prev) ) {
+      ok = sim.resume(from, vcdFile, vcdIntSize, false);
+      if ( ! splice(prev, cut, vcdFile, resumedAt) ) {
+        qDebug() << "SimHistory: cannot splice trace" << vcdFile << ", running the complete simulation";
+        QFile::remove(prev);
+        resumedAt = -1;
+        }
+      }
+    else resumedAt = -1;
+    }
+  if ( resumedAt < 0 ) ok = sim.run(vcdFile, vcdIntSize, vcdCompressed);
+  qDebug() << "SimHistory::run: resumed at" << resumedAt;
+  // What happened before the restored checkpoint is still valid
+  QList<SimSnapshot> keptCheckpoints;
+  QHash<QString,int> keptVisits;
+  if ( resumedAt >= 0 ) {
+    foreach ( const SimSnapshot& c, checkpoints )
+      if ( c.time <= resumedAt ) keptCheckpoints.append(c);
+    for ( auto i = firstVisits.constBegin(); i != firstVisits.constEnd(); ++i )
+      if ( i.value() <= resumedAt ) keptVisits.insert(i.key(), i.value());
+    }
+  checkpoints = keptCheckpoints + sim.getCheckpoints();
+  firstVisits = sim.getFirstVisits();
+  for ( auto i = keptVisits.constBegin(); i != keptVisits.constEnd(); ++i ) firstVisits.insert(i.key(), i.value());
+  this->vcdFile = vcdFile;
+  this->settings = settings;
+  fingerprint = fp;
+  stimuli = stims;
+  nbSignals = model->getIos().length() + model->getAutomatons().length();
+  f.refresh();
+  vcdSize = f.size();
+  vcdDate = f.lastModified();
+  valid = ok;
+  return ok;
+}
@@ -0,0 +1,72 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include <QDateTime>
+#include "stimulus.h"
+#include "simSnapshot.h"
+
+class Model;
+class Simulator;
+
+// Record of the last run of the built-in simulator, for re-simulating a model incrementally.
+//
+// After an edition of the stimuli or of the automata, a new run cannot differ from the recorded
+// one before the divergence date, which is the earliest of
+// - the first date at which the occurrences of an input stimulus differ,
+// - the first date at which an FSM has been in a state whose valuations or outgoing transitions
+//   have changed.
+// The last checkpoint taken before this date is restored (see [SimSnapshot]), only the rest of
+// the run is simulated and its trace replaces the end of the recorded one.
+//
+// Changes to the IOs, local variables, initial transitions or simulation options, as well as
+// compressed traces, simulation logs and firing profiles (which are not spliced), force a complete run.
+
+class SimHistory
+{
+public:
+  SimHistory() : valid(false), resumedAt(-1), vcdSize(0), nbSignals(0) { };
+
+  static const int checkpointPeriod; // In dates
+
+  // Runs [sim] (built for [model]), incrementally if possible. [settings] identifies the simulation options
+  bool run(Simulator& sim, Model *model, QString settings, QString vcdFile, int vcdIntSize, bool vcdCompressed);
+  int getResumedAt() const { return resumedAt; } // Date of the restored checkpoint, -1 after a complete run
+  void clear() { valid = false; }
+
+private:
+  typedef QHash<QString,QString> Fingerprint; // "" -> IOs and FSMs, "<fsm>" -> variables and init, "<fsm>.<state>" -> state
+
+  bool valid;
+  int resumedAt;
+  QString vcdFile;
+  qint64 vcdSize;
+  QDateTime vcdDate;
+  int nbSignals;
+  QString settings;
+  Fingerprint fingerprint;
+  QHash<QString,Stimulus> stimuli;
+  QList<SimSnapshot> checkpoints;
+  QHash<QString,int> firstVisits;
+
+  static Fingerprint fingerprintOf(Model *model);
+  static int firstDifference(const Stimulus& s1, const Stimulus& s2);
+  int divergence(const Fingerprint& fp, const QHash<QString,Stimulus>& stims) const;
+  qint64 endOf(int time) const;
+  static bool splice(QString prefixFile, qint64 cut, QString tailFile, int time);
+};
@@ -0,0 +1,61 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+
+#include "simProfile.h"
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include "qt_compat.h"
+
+const SimProfile::Fsm* SimProfile::fsm(QString name) const
+{
+  for ( const Fsm& f : fsms )
+    if ( f.name == name ) return &f;
+  return NULL;
+}
+
+qint64 SimProfile::maxFired() const
+{
+  qint64 m = 0;
+  for ( const Fsm& f : fsms )
+    for ( const TransitionStats& t : f.transitions ) m = qMax(m, t.fired);
+  return m;
+}
+
+QString SimProfile::fileName(QString vcdFile)
+{
+  QString base = vcdFile;
+  if ( base.endsWith(".gz") ) base.chop(3);
+  if ( base.endsWith(".vcd") ) base.chop(4);
+  return base + "_profile.csv";
+}
+
+bool SimProfile::save(QString fname) const
+{
+  QFile file(fname);
+  if ( ! file.open(QIODevice::WriteOnly | QIODevice::Text) ) return false;
+  QTextStream os(&file);
+  os << "automaton,kind,item,count,guard evaluations,guard false,time,time %" << QT_ENDL;
+  for ( const Fsm& f : fsms ) {
+    for ( const StateStats& s : f.states ) {
+      QString pc = duration > 0 ? QString::number(100.0 * s.time / duration, 'f', 1) : "";
+      os << QStringList({ f.name, "state", s.name, QString::number(s.entered), "", "", QString::number(s.time), pc }).join(",") << QT_ENDL;
+      }
+    for ( const TransitionStats& t : f.transitions ) {
+      QString label = "\"" + QString(t.label).replace('"', '\'') + "\"";
+      os << QStringList({ f.name, "transition", label, QString::number(t.fired), QString::number(t.tried),
+                          QString::number(t.failed), "", "" }).join(",") << QT_ENDL;
+      }
+    }
+  return os.status() == QTextStream::Ok;
+}
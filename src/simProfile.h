@@ -0,0 +1,57 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+
+#pragma once
+
+#include <QString>
+#include <QList>
+
+// Firing profile of a simulation of the built-in simulator (see [Simulator::setProfiling]): how many times
+// each transition has been taken, how many times its guard has been evaluated and found false, and how long
+// (in simulated time units) each automaton stayed in each state.
+//
+// Transitions are listed in the order of [Automaton::transitions], the initial one excluded (as in
+// [FsmTable::transitions]), states in that of [Automaton::states], pseudo-states excluded.
+
+class SimProfile
+{
+public:
+  SimProfile() : duration(0) { };
+
+  struct TransitionStats {
+    QString label;
+    qint64 fired;
+    qint64 tried;      // Guard evaluations
+    qint64 failed;     // Evaluations giving false
+  };
+  struct StateStats {
+    QString name;
+    qint64 entered;
+    qint64 time;       // Total, in time units
+  };
+  struct Fsm {
+    QString name;
+    QList<StateStats> states;
+    QList<TransitionStats> transitions;
+  };
+
+  QList<Fsm> fsms;
+  qint64 duration;     // Of the profiled run
+
+  bool isEmpty() const { return fsms.isEmpty(); }
+  const Fsm* fsm(QString name) const; // NULL if not profiled
+  qint64 maxFired() const;            // Over all automata
+
+  static QString fileName(QString vcdFile); // <trace>_profile.csv
+  bool save(QString fname) const;           // As a CSV table, one row per state and transition
+};
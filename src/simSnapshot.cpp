@@ -0,0 +1,61 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "simSnapshot.h"
+#include <QFile>
+#include <QDataStream>
+
+const quint32 SimSnapshot::magic = 0x47534E50; // "GSNP"
+const quint32 SimSnapshot::version = 1;
+
+QString SimSnapshot::fileName(QString vcdFile, int time)
+{
+  QString base = vcdFile;
+  if ( base.endsWith(".gz") ) base.chop(3);
+  if ( base.endsWith(".vcd") ) base.chop(4);
+  return base + "_" + QString::number(time) + ".snap";
+}
+
+bool SimSnapshot::save(QString fname) const
+{
+  QFile file(fname);
+  if ( ! file.open(QIODevice::WriteOnly) ) return false;
+  QDataStream os(&file);
+  os << magic << version << qint32(time) << qint32(nbTransitions);
+  os << values << states;
+  return os.status() == QDataStream::Ok;
+}
+
+bool SimSnapshot::load(QString fname, QString& error)
+{
+  QFile file(fname);
+  if ( ! file.open(QIODevice::ReadOnly) ) {
+    error = "cannot open file " + fname;
+    return false;
+    }
+  QDataStream is(&file);
+  quint32 m, v;
+  qint32 t, n;
+  is >> m >> v;
+  if ( m != magic || v != version ) {
+    error = fname + " is not a simulation snapshot (or has been written by another version)";
+    return false;
+    }
+  is >> t >> n >> values >> states;
+  if ( is.status() != QDataStream::Ok ) {
+    error = fname + " is truncated";
+    return false;
+    }
+  time = t;
+  nbTransitions = n;
+  return true;
+}
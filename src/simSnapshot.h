@@ -0,0 +1,48 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QList>
+#include <QPair>
+
+// State of a simulation of the built-in simulator at the end of a given date, for resuming it later
+// (see [Simulator::resume]).
+//
+// Reactions are completed within a date, so there are no pending events between two dates, and the
+// position of the stimulus cursors is given by the date itself: on resumption, they are moved to the
+// first occurrence after it. Runs whose stimuli only differ after its date can therefore all be resumed
+// from the same snapshot.
+//
+// Values and states are designated by name (IOs and shared variables, "<fsm>.<var>" for local
+// variables), so that a snapshot can be restored into a modified model as long as these names still
+// exist. Items absent from the snapshot keep their initial value.
+
+class SimSnapshot
+{
+public:
+  SimSnapshot() : time(0), nbTransitions(0) { };
+
+  int time;
+  int nbTransitions;
+  QList<QPair<QString,int>> values;      // Globals and locals
+  QList<QPair<QString,QString>> states;  // FSM, current state
+
+  static QString fileName(QString vcdFile, int time); // <trace>_<time>.snap
+  bool save(QString fname) const;
+  bool load(QString fname, QString& error);
+
+private:
+  static const quint32 magic;
+  static const quint32 version;
+};
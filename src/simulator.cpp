@@ -0,0 +1,722 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "simulator.h"
+#include "model.h"
+#include "transition.h"
+#include "iov.h"
+#include "stimulus.h"
+#include "fsmTable.h"
+#include "clusterScheduler.h"
+#include "compiledModel.h"
+#include "vcdWriter.h"
+#include "globals.h"
+#include "compilerPaths.h"
+#include <QDebug>
+#include <queue>
+#include <tuple>
+#include <functional>
+#include <stdexcept>
+
+const int Simulator::maxMicroSteps = 1000; // For detecting instantaneous loops on shared events
+
+Simulator::Simulator(Model *model, bool synchronousActions)
+{
+  this->model = model;
+  this->synchronousActions = synchronousActions;
+  this->tables = NULL;
+  this->sharedTables = false;
+  this->native = NULL;
+  this->nbThreads = 1;
+  this->scheduler = NULL;
+  this->vcd = NULL;
+  this->logging = false;
+  this->log = NULL;
+  this->profiling = false;
+  this->profiled = false;
+  this->profDate = 0;
+  this->nbTransitions = 0;
+  this->endTime = 0;
+  this->snapshotInterval = 0;
+  this->stopTime = -1;
+  this->checkpointPeriod = 0;
+}
+
+Simulator::~Simulator()
+{
+  delete scheduler;
+  delete native;
+  if ( ! sharedTables ) delete tables;
+}
+
+QString Simulator::settings(QStringList simOpts, int& vcdIntSize, bool& vcdCompressed, QString& cxx)
+{
+  QString warning;
+  vcdIntSize = intOption(simOpts, "-vcd_int_size", 8);
+  vcdCompressed = simOpts.contains("-vcd_compress");
+  if ( vcdCompressed && ! VcdWriter::compressionAvailable() ) {
+    warning = "Compressed VCD traces are not supported by this build; writing an uncompressed trace";
+    vcdCompressed = false;
+    }
+  cxx = "";
+  if ( simOpts.contains("-compiled_sim") ) {
+    cxx = Globals::compilerPaths->getPath("CXXCOMPILER");
+    if ( cxx.isNull() || cxx.isEmpty() ) cxx = "c++"; // Last chance..
+    if ( simOpts.contains("-sim_log") ) {
+      QString w = "Simulation logs are not available in compiled mode; no log written";
+      warning = warning.isEmpty() ? w : warning + "\n" + w;
+      }
+    if ( simOpts.contains("-sim_profile") ) {
+      QString w = "Firing profiles are not available in compiled mode; no profile written";
+      warning = warning.isEmpty() ? w : warning + "\n" + w;
+      }
+    }
+  return warning;
+}
+
+int Simulator::intOption(QStringList opts, QString name, int def)
+{
+  foreach ( QString opt, opts )
+    if ( opt.startsWith(name + " ") ) return opt.section(' ', 1).toInt();
+  return def;
+}
+
+void Simulator::setCompiled(QString cacheDir, QString compiler)
+{
+  this->cacheDir = cacheDir;
+  this->compiler = compiler;
+}
+
+// Building
+
+void Simulator::setTables(ModelTables *tables)
+{
+  if ( ! sharedTables ) delete this->tables;
+  this->tables = tables;
+  this->sharedTables = true;
+}
+
+// Lowering reads the automata through their graphics scenes, so it must be done by the GUI thread.
+// Simulators running concurrently share tables built beforehand (see [setTables])
+
+bool Simulator::build()
+{
+  delete native;
+  native = NULL;
+  delete scheduler;
+  scheduler = NULL;
+  errors.clear();
+  ios = model->getIos();
+  if ( ! sharedTables ) {
+    delete tables;
+    tables = new ModelTables(model, synchronousActions);
+    if ( ! tables->build() ) {
+      errors = tables->getErrors();
+      return false;
+      }
+    }
+  if ( ! compiler.isEmpty() ) {
+    native = new CompiledModel(tables, synchronousActions);
+    if ( ! native->load(cacheDir, compiler) ) {
+      errors = native->getErrors();
+      return false;
+      }
+    }
+  else if ( nbThreads > 1 ) {
+    QList<QVector<int>> clusters = tables->clusters();
+    qDebug() << "Simulator:" << clusters.length() << "independent cluster(s) of automata";
+    if ( clusters.length() > 1 ) scheduler = new ClusterScheduler(clusters, nbThreads);
+    }
+  return true;
+}
+
+QList<QPair<QString,int>> Simulator::getFinalValues() const
+{
+  QList<QPair<QString,int>> r;
+  if ( ! tables ) return r;
+  foreach ( Iov *io, ios ) {
+    if ( io->kind == Iov::IoIn || io->type == Iov::TyEvent ) continue;
+    r.append(QPair<QString,int>(io->name, store.value(tables->syms.global(io->name))));
+    }
+  return r;
+}
+
+// Snapshots
+
+void Simulator::setSnapshots(int interval, int stopTime)
+{
+  this->snapshotInterval = interval;
+  this->stopTime = stopTime;
+}
+
+SimSnapshot Simulator::snapshot(int time) const
+{
+  const SymbolTable& syms = tables->syms;
+  SimSnapshot s;
+  s.time = time;
+  s.nbTransitions = nbTransitions;
+  foreach ( Iov *io, ios )
+    if ( io->type != Iov::TyEvent ) s.values.append(QPair<QString,int>(io->name, store.at(syms.global(io->name))));
+  foreach ( const FsmTable *fsm, tables->fsms ) {
+    foreach ( QString v, fsm->varNames )
+      s.values.append(QPair<QString,int>(fsm->name + "." + v, store.at(syms.lookup(fsm->fsm, v))));
+    s.states.append(QPair<QString,QString>(fsm->name, fsm->stateNames.at(current.at(fsm->fsm))));
+    }
+  return s;
+}
+
+void Simulator::setCheckpoints(int period)
+{
+  this->checkpointPeriod = period;
+}
+
+// Records the first date at which each FSM has been in each state
+
+void Simulator::visit(int time)
+{
+  for ( int i=0; i<current.length(); i++ ) {
+    int& d = firstVisits[i][current.at(i)];
+    if ( d < 0 ) d = time;
+    if ( profiled ) stateTimes[profStates.at(i) + current.at(i)] += time - profDate;
+    }
+  profDate = time;
+}
+
+// Profiling
+
+void Simulator::startProfile(int time)
+{
+  profTransitions.clear();
+  profStates.clear();
+  int nt = 0, ns = 0;
+  foreach ( const FsmTable *fsm, tables->fsms ) {
+    profTransitions.append(nt);
+    profStates.append(ns);
+    nt += fsm->transitions.length();
+    ns += fsm->nbStates;
+    }
+  fireCounts = QVector<qint64>(nt, 0);
+  guardTries = QVector<qint64>(nt, 0);
+  guardFailures = QVector<qint64>(nt, 0);
+  stateEntries = QVector<qint64>(ns, 0);
+  stateTimes = QVector<qint64>(ns, 0);
+  profDate = time;
+}
+
+void Simulator::countFirings(const QVector<const FsmTable::Entry*>& fired)
+{
+  for ( int i=0; i<fired.size(); i++ ) {
+    const FsmTable::Entry *e = fired.at(i);
+    if ( ! e ) continue;
+    fireCounts[profTransitions.at(i) + e->id]++;
+    stateEntries[profStates.at(i) + e->dst]++;
+    }
+}
+
+// Counters of a run started at date [start], ended at the last date visited
+
+SimProfile Simulator::makeProfile(int start) const
+{
+  SimProfile p;
+  p.duration = profDate - start;
+  foreach ( const FsmTable *fsm, tables->fsms ) {
+    SimProfile::Fsm f;
+    f.name = fsm->name;
+    for ( int k=0; k<fsm->nbStates; k++ ) {
+      int i = profStates.at(fsm->fsm) + k;
+      f.states.append(SimProfile::StateStats { fsm->stateNames.at(k), stateEntries.at(i), stateTimes.at(i) });
+      }
+    for ( int k=0; k<fsm->transitions.length(); k++ ) {
+      int i = profTransitions.at(fsm->fsm) + k;
+      f.transitions.append(SimProfile::TransitionStats { fsm->transitions.at(k)->toString(), fireCounts.at(i), guardTries.at(i), guardFailures.at(i) });
+      }
+    p.fsms.append(f);
+    }
+  return p;
+}
+
+QHash<QString,int> Simulator::getFirstVisits() const
+{
+  QHash<QString,int> r;
+  foreach ( const FsmTable *fsm, tables->fsms )
+    for ( int k=0; k<fsm->stateNames.length(); k++ ) {
+      int d = firstVisits.at(fsm->fsm).at(k);
+      if ( d >= 0 ) r.insert(fsm->name + "." + fsm->stateNames.at(k), d);
+      }
+  return r;
+}
+
+void Simulator::saveSnapshot(int time, QString vcdFile)
+{
+  QString fname = SimSnapshot::fileName(vcdFile, time);
+  if ( snapshot(time).save(fname) ) snapshots << fname;
+  else qDebug() << "Simulator: cannot write snapshot" << fname;
+}
+
+bool Simulator::restore(const SimSnapshot& s)
+{
+  const SymbolTable& syms = tables->syms;
+  QHash<QString,int> slots;
+  QHash<QString,const FsmTable*> fsms;
+  foreach ( Iov *io, ios )
+    if ( io->type != Iov::TyEvent ) slots.insert(io->name, syms.global(io->name));
+  foreach ( const FsmTable *fsm, tables->fsms ) {
+    foreach ( QString v, fsm->varNames ) slots.insert(fsm->name + "." + v, syms.lookup(fsm->fsm, v));
+    fsms.insert(fsm->name, fsm);
+    current[fsm->fsm] = fsm->initState;
+    }
+  foreach ( const auto& v, s.values ) {
+    int slot = slots.value(v.first, -1);
+    if ( slot < 0 ) errors << "snapshot: no variable named " + v.first + " in the model";
+    else store[slot] = v.second;
+    }
+  foreach ( const auto& st, s.states ) {
+    const FsmTable *fsm = fsms.value(st.first, NULL);
+    int k = fsm ? fsm->stateNames.indexOf(st.second) : -1;
+    if ( k < 0 ) errors << "snapshot: no state " + st.first + "." + st.second + " in the model";
+    else current[fsm->fsm] = k;
+    }
+  nbTransitions = s.nbTransitions;
+  return errors.isEmpty();
+}
+
+// Execution
+
+void Simulator::commit(const QVector<QPair<int,int>>& updates, VcdWriter& vcd)
+{
+  foreach ( const QPair<int,int>& u, updates ) {
+    if ( store.at(u.first) == u.second ) continue;
+    store[u.first] = u.second;
+    if ( vcdSlots.at(u.first) >= 0 ) vcd.change(vcdSlots.at(u.first), u.second);
+    }
+}
+
+// Compiled mode
+
+void Simulator::traceChange(void *sim, int slot, int value)
+{
+  Simulator *s = static_cast<Simulator*>(sim);
+  if ( s->vcdSlots.at(slot) >= 0 ) s->vcd->change(s->vcdSlots.at(slot), value);
+}
+
+void Simulator::traceEvent(void *sim, int event)
+{
+  Simulator *s = static_cast<Simulator*>(sim);
+  s->vcd->event(s->vcdEvents.at(event));
+}
+
+void Simulator::traceState(void *sim, int fsm, int state)
+{
+  Simulator *s = static_cast<Simulator*>(sim);
+  s->vcd->change(s->vcdStates.at(fsm), s->tables->fsms.at(fsm)->stateNames.at(state));
+}
+
+bool Simulator::nativeResult(int r, const int *info)
+{
+  switch ( r ) {
+  case CompiledModel::NonDeterministic: {
+    const FsmTable *fsm = tables->fsms.at(info[0]);
+    errors << fsm->name + ": non deterministic transitions " + fsm->transitions.at(info[1])->toString()
+                                                      + " and " + fsm->transitions.at(info[2])->toString();
+    return false;
+    }
+  case CompiledModel::TooManyMicroSteps:
+    errors << "too many micro-steps (instantaneous loop on shared events ?)";
+    return false;
+  case CompiledModel::DivisionByZero:
+    errors << "division by zero";
+    return false;
+  case CompiledModel::Overflow:
+    errors << "arithmetic overflow";
+    return false;
+  case CompiledModel::InvalidShift:
+    errors << "invalid shift count";
+    return false;
+  case CompiledModel::InvalidRange:
+    errors << "invalid bit range";
+    return false;
+  default:
+    nbTransitions += r;
+    return true;
+  }
+}
+
+bool Simulator::react(QVector<int> events, VcdWriter& vcd)
+{
+  if ( native ) {
+    GraspSimTrace trace = { this, traceChange, traceEvent, traceState };
+    int info[3];
+    return nativeResult(native->react(store.data(), current.data(), events.constData(), events.size(), &trace, info), info);
+    }
+  QVector<QPair<int,int>> updates;
+  QVector<int> emitted;
+  Bytecode::Context ctx = { store.data(), &updates, &emitted };
+  QVector<const FsmTable::Entry*> fired(tables->fsms.length());
+  QVector<QPair<int,int>> ends(tables->fsms.length()); // End of the updates and emitted events of each FSM
+  qint64 *tries = profiled ? guardTries.data() : NULL;
+  qint64 *failures = profiled ? guardFailures.data() : NULL;
+  for ( int step=0; ! events.isEmpty(); step++ ) {
+    if ( step >= maxMicroSteps ) {
+      errors << "too many micro-steps (instantaneous loop on shared events ?)";
+      return false;
+      }
+    updates.clear();
+    emitted.clear();
+    fired.fill(NULL);
+    if ( scheduler ) {
+      if ( ! parallelStep(events, fired, updates, emitted, ends, tries, failures) ) return false;
+      }
+    else
+      foreach ( const FsmTable *fsm, tables->fsms ) {
+        QString error;
+        int t = profiled ? profTransitions.at(fsm->fsm) : 0;
+        fired[fsm->fsm] = fire(fsm, events, ctx, error, tries ? tries + t : NULL, failures ? failures + t : NULL);
+        if ( ! error.isEmpty() ) {
+          errors << error;
+          return false;
+          }
+        ends[fsm->fsm] = QPair<int,int>(updates.size(), emitted.size());
+        }
+    if ( log ) logStep(fired, ends, updates, emitted);
+    if ( profiled ) countFirings(fired);
+    foreach ( const FsmTable *fsm, tables->fsms ) {
+      const FsmTable::Entry *e = fired.at(fsm->fsm);
+      if ( ! e ) continue;
+      current[fsm->fsm] = e->dst;
+      vcd.change(vcdStates.at(fsm->fsm), fsm->stateNames.at(e->dst));
+      nbTransitions++;
+      }
+    commit(updates, vcd);
+    QVector<int> next;
+    foreach ( int e, emitted ) {
+      if ( next.contains(e) ) continue;
+      vcd.event(vcdEvents.at(e));
+      if ( tables->sharedEvent.at(e) ) next.append(e);
+      }
+    events = next;
+    }
+  return true;
+}
+
+// Micro-step of automaton [fsm]: the transition enabled by one of the [events], if any, is taken (its
+// actions and the valuations of its target state are executed, the current state being left unchanged).
+// Returns NULL if there is none, or if there are several ones (then setting [error]).
+// When profiling, the guard evaluations and failures of each candidate are counted in [tries] and
+// [failures], indexed by [FsmTable::Entry::id]
+
+const FsmTable::Entry* Simulator::fire(const FsmTable *fsm, const QVector<int>& events, Bytecode::Context& ctx, QString& error,
+                                       qint64 *tries, qint64 *failures) const
+{
+  const Bytecode& code = tables->code;
+  int src = current.at(fsm->fsm);
+  const FsmTable::Entry *fired = NULL;
+  foreach ( int ev, events ) {
+    const FsmTable::Cell& cell = fsm->cell(src, ev);
+    for ( int i=cell.first; i<cell.first+cell.count; i++ ) {
+      const FsmTable::Entry& e = fsm->entries.at(i);
+      if ( tries ) tries[e.id]++;
+      if ( ! code.run(e.guard, ctx) ) {
+        if ( failures ) failures[e.id]++;
+        continue;
+        }
+      if ( fired ) {
+        error = fsm->name + ": non deterministic transitions " + fsm->transitions.at(fired->id)->toString()
+                                                       + " and " + fsm->transitions.at(e.id)->toString();
+        return NULL;
+        }
+      fired = &e;
+      }
+    }
+  if ( fired ) {
+    code.run(fired->action, ctx);
+    code.run(fsm->enter.at(fired->dst), ctx);
+    }
+  return fired;
+}
+
+// Parallel version of a micro-step. Each automaton records its updates and emitted events separately;
+// they are then merged by increasing rank, as if the automata had been evaluated in sequence. The first
+// error, in the same order, is reported. Profiling counters are indexed by transition, so that each one is
+// only updated by the worker evaluating its automaton
+
+bool Simulator::parallelStep(const QVector<int>& events, QVector<const FsmTable::Entry*>& fired, QVector<QPair<int,int>>& updates, QVector<int>& emitted,
+                             QVector<QPair<int,int>>& ends, qint64 *tries, qint64 *failures)
+{
+  int n = tables->fsms.length();
+  QVector<QVector<QPair<int,int>>> fsmUpdates(n);
+  QVector<QVector<int>> fsmEmitted(n);
+  QVector<QString> fsmErrors(n);
+  QVector<bool> thrown(n, false);
+  // Workers only use raw pointers, so that no container is detached concurrently
+  int *s = store.data();
+  const FsmTable::Entry **f = fired.data();
+  QVector<QPair<int,int>> *u = fsmUpdates.data();
+  QVector<int> *em = fsmEmitted.data();
+  QString *err = fsmErrors.data();
+  bool *th = thrown.data();
+  scheduler->run([&](const QVector<int>& cluster) {
+    for ( int i : cluster ) {
+      Bytecode::Context ctx = { s, &u[i], &em[i] };
+      try {
+        int t = tries ? profTransitions.at(i) : 0;
+        f[i] = fire(tables->fsms.at(i), events, ctx, err[i], tries ? tries + t : NULL, failures ? failures + t : NULL);
+        }
+      catch ( std::runtime_error& e ) {
+        err[i] = QString::fromStdString(e.what());
+        th[i] = true;
+        }
+      if ( ! err[i].isEmpty() ) break; // The next automata of the cluster are not evaluated, as in sequential mode
+      }
+    });
+  for ( int i=0; i<n; i++ ) {
+    if ( thrown.at(i) ) throw std::runtime_error(fsmErrors.at(i).toStdString());
+    if ( ! fsmErrors.at(i).isEmpty() ) {
+      errors << fsmErrors.at(i);
+      return false;
+      }
+    updates += fsmUpdates.at(i);
+    emitted += fsmEmitted.at(i);
+    ends[i] = QPair<int,int>(updates.size(), emitted.size());
+    }
+  return true;
+}
+
+// Logs the transitions taken during a micro-step, with the writes and events of each one ([ends] gives
+// the end of those of each FSM in [updates] and [emitted])
+
+void Simulator::logStep(const QVector<const FsmTable::Entry*>& fired, const QVector<QPair<int,int>>& ends,
+                        const QVector<QPair<int,int>>& updates, const QVector<int>& emitted)
+{
+  bool first = true;
+  int u = 0, e = 0;
+  for ( int i=0; i<fired.size(); i++ ) {
+    if ( fired.at(i) ) {
+      if ( first ) log->step();
+      first = false;
+      QVector<QPair<int,int>> writes;
+      QVector<int> events;
+      for ( int k=u; k<ends.at(i).first; k++ )
+        if ( logSlots.at(updates.at(k).first) >= 0 ) writes.append(QPair<int,int>(logSlots.at(updates.at(k).first), updates.at(k).second));
+      for ( int k=e; k<ends.at(i).second; k++ )
+        if ( logEvents.at(emitted.at(k)) >= 0 ) events.append(logEvents.at(emitted.at(k)));
+      log->fire(i, fired.at(i)->id, writes, events);
+      }
+    u = ends.at(i).first;
+    e = ends.at(i).second;
+    }
+}
+
+bool Simulator::run(QString vcdFile, int vcdIntSize, bool vcdCompressed)
+{
+  return simulate(NULL, vcdFile, vcdIntSize, vcdCompressed);
+}
+
+bool Simulator::resume(const SimSnapshot& snapshot, QString vcdFile, int vcdIntSize, bool vcdCompressed)
+{
+  return simulate(&snapshot, vcdFile, vcdIntSize, vcdCompressed);
+}
+
+bool Simulator::simulate(const SimSnapshot *from, QString vcdFile, int vcdIntSize, bool vcdCompressed)
+{
+  if ( ! build() ) return false;
+  nbTransitions = 0;
+  snapshots.clear();
+  checkpoints.clear();
+  firstVisits.clear();
+  foreach ( const FsmTable *fsm, tables->fsms ) firstVisits.append(QVector<int>(fsm->stateNames.length(), -1));
+  const SymbolTable& syms = tables->syms;
+  store = tables->initValues;
+  current = QVector<int>(tables->fsms.length(), -1);
+  if ( from && ! restore(*from) ) return false;
+  int now = from ? from->time : 0;
+  // Trace declarations
+  VcdWriter vcd(vcdIntSize, vcdCompressed);
+  QString top = model->getName().isEmpty() ? "main" : model->getName();
+  vcdSlots = QVector<int>(syms.getNbSlots(), -1);
+  vcdEvents = QVector<int>(syms.getNbEvents(), -1);
+  vcdStates = QVector<int>(tables->fsms.length(), -1);
+  QVector<int> index; // Slot or event of each IO
+  foreach ( Iov *io, ios ) {
+    VcdWriter::Kind k = io->type == Iov::TyEvent ? VcdWriter::Event : io->type == Iov::TyBool ? VcdWriter::Bool : VcdWriter::Int;
+    int id = vcd.declare(top, io->name, k);
+    if ( io->type == Iov::TyEvent ) {
+      index.append(syms.event(io->name));
+      vcdEvents[index.last()] = id;
+      }
+    else {
+      index.append(syms.global(io->name));
+      vcdSlots[index.last()] = id;
+      }
+    }
+  foreach ( FsmTable *fsm, tables->fsms ) vcdStates[fsm->fsm] = vcd.declare(fsm->name, "state", VcdWriter::String);
+  if ( ! vcd.open(vcdFile) ) {
+    errors << "cannot open file " + vcdFile;
+    return false;
+    }
+  this->vcd = &vcd;
+  TraceLog log;
+  bool logged = logging && ! native; // Transitions are not reported by compiled models
+  logFile = "";
+  profiled = profiling && ! native;  // Idem
+  profile = SimProfile();
+  profileFile = "";
+  if ( profiled ) startProfile(now);
+  if ( logged ) {
+    TraceLog::Header h;
+    h.top = top;
+    logSlots = QVector<int>(syms.getNbSlots(), -1);
+    logEvents = QVector<int>(syms.getNbEvents(), -1);
+    for ( int i=0; i<ios.length(); i++ ) {
+      h.ioNames << ios.at(i)->name;
+      h.ioKinds << ios.at(i)->kind;
+      h.ioTypes << ios.at(i)->type;
+      if ( ios.at(i)->type == Iov::TyEvent ) logEvents[index.at(i)] = i;
+      else logSlots[index.at(i)] = i;
+      }
+    foreach ( const FsmTable *fsm, tables->fsms ) {
+      TraceLog::Fsm f;
+      f.name = fsm->name;
+      f.states = fsm->stateNames;
+      foreach ( Transition *t, fsm->transitions ) {
+        f.transitions << QPair<int,int>(fsm->states.indexOf(t->getSrcState()), fsm->states.indexOf(t->getDstState()));
+        f.labels << t->toString();
+        }
+      h.fsms << f;
+      }
+    if ( ! log.open(TraceLog::fileName(vcdFile), h) ) {
+      errors << "cannot open file " + TraceLog::fileName(vcdFile);
+      this->vcd = NULL;
+      profiled = false;
+      return false;
+      }
+    this->log = &log;
+    }
+  // Stimuli, merged by increasing dates (ties are broken by IO rank)
+  typedef std::tuple<int,int,int> Occurrence; // date, IO rank, value
+  std::priority_queue<Occurrence, std::vector<Occurrence>, std::greater<Occurrence>> queue;
+  QList<StimulusCursor> cursors;
+  for ( int i=0; i<ios.length(); i++ ) {
+    auto s = stimuli.constFind(ios.at(i)->name);
+    cursors.append(StimulusCursor(s != stimuli.constEnd() ? s.value() : ios.at(i)->stim));
+    if ( from ) cursors[i].skip(from->time);
+    int t, v;
+    if ( ios.at(i)->kind == Iov::IoIn && cursors[i].next(t, v) ) queue.push(Occurrence(t, i, v));
+    }
+  bool ok = true, stopped = false;
+  try {
+    // Initialisation
+    vcd.setTime(now);
+    for ( int i=0; i<ios.length(); i++ )
+      if ( ios.at(i)->type != Iov::TyEvent ) vcd.change(vcdSlots.at(index.at(i)), store.at(index.at(i)));
+    if ( from ) {
+      foreach ( FsmTable *fsm, tables->fsms ) vcd.change(vcdStates.at(fsm->fsm), fsm->stateNames.at(current.at(fsm->fsm)));
+      }
+    else if ( native ) {
+      GraspSimTrace trace = { this, traceChange, traceEvent, traceState };
+      int info[3];
+      ok = nativeResult(native->init(store.data(), current.data(), &trace, info), info);
+      }
+    else {
+      QVector<QPair<int,int>> updates;
+      QVector<int> emitted;
+      Bytecode::Context ctx = { store.data(), &updates, &emitted };
+      foreach ( FsmTable *fsm, tables->fsms ) {
+        tables->code.run(fsm->initAction, ctx);
+        tables->code.run(fsm->enter.at(fsm->initState), ctx);
+        current[fsm->fsm] = fsm->initState;
+        vcd.change(vcdStates.at(fsm->fsm), fsm->stateNames.at(fsm->initState));
+        }
+      commit(updates, vcd);
+      }
+    if ( profiled && ! from )
+      for ( int i=0; i<current.length(); i++ ) stateEntries[profStates.at(i) + current.at(i)]++;
+    visit(now);
+    if ( logged ) {
+      QVector<int> values;
+      for ( int i=0; i<ios.length(); i++ )
+        if ( ios.at(i)->type != Iov::TyEvent ) values.append(store.at(index.at(i)));
+      log.setTime(now);
+      log.state(current, values);
+      }
+    // Main loop
+    int nbDates = 0;
+    while ( ok && ! queue.empty() ) {
+      int t = std::get<0>(queue.top());
+      if ( t < now ) {
+        errors << "stimulus dates must be increasing (input " + ios.at(std::get<1>(queue.top()))->name + ", t=" + QString::number(t) + ")";
+        ok = false;
+        break;
+        }
+      if ( stopTime >= 0 && t > stopTime ) {
+        stopped = true;
+        break;
+        }
+      if ( snapshotInterval > 0 && t / snapshotInterval > now / snapshotInterval ) saveSnapshot(now, vcdFile);
+      if ( checkpointPeriod > 0 && t > now && ++nbDates % checkpointPeriod == 0 ) checkpoints.append(snapshot(now));
+      now = t;
+      vcd.setTime(t);
+      if ( logged ) log.setTime(t);
+      QVector<int> events;
+      while ( ! queue.empty() && std::get<0>(queue.top()) == t ) {
+        Occurrence o = queue.top();
+        queue.pop();
+        int i = std::get<1>(o);
+        int k = index.at(i);
+        if ( ios.at(i)->type == Iov::TyEvent ) {
+          if ( ! events.contains(k) ) events.append(k);
+          vcd.event(vcdEvents.at(k));
+          if ( logged ) log.event(i);
+          }
+        else if ( store.at(k) != std::get<2>(o) ) {
+          store[k] = std::get<2>(o);
+          vcd.change(vcdSlots.at(k), std::get<2>(o));
+          if ( logged ) log.input(i, std::get<2>(o));
+          }
+        int tn, vn;
+        if ( cursors[i].next(tn, vn) ) queue.push(Occurrence(tn, i, vn));
+        }
+      ok = react(events, vcd);
+      visit(t);
+      }
+    }
+  catch ( std::runtime_error& e ) {
+    errors << QString::fromStdString(e.what());
+    ok = false;
+    }
+  if ( ! ok ) errors.last() = "t=" + QString::number(now) + ": " + errors.last();
+  if ( stopped ) saveSnapshot(now, vcdFile);
+  if ( ! vcd.close() ) {
+    errors << "cannot write file " + vcdFile;
+    ok = false;
+    }
+  this->vcd = NULL;
+  if ( logged ) {
+    if ( log.close() ) logFile = TraceLog::fileName(vcdFile);
+    else {
+      errors << "cannot write file " + TraceLog::fileName(vcdFile);
+      ok = false;
+      }
+    this->log = NULL;
+    }
+  if ( profiled ) {
+    profile = makeProfile(from ? from->time : 0);
+    if ( profile.save(SimProfile::fileName(vcdFile)) ) profileFile = SimProfile::fileName(vcdFile);
+    else {
+      errors << "cannot write file " + SimProfile::fileName(vcdFile);
+      ok = false;
+      }
+    profiled = false;
+    }
+  endTime = now;
+  qDebug() << "Simulator::run:" << nbTransitions << "transitions, end at t=" << now;
+  return ok;
+}
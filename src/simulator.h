@@ -0,0 +1,164 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QVector>
+#include <QPair>
+#include <QHash>
+#include "stimulus.h"
+#include "simSnapshot.h"
+#include "simProfile.h"
+#include "fsmTable.h"
+#include "traceLog.h"
+
+class Model;
+class Iov;
+class VcdWriter;
+class CompiledModel;
+class ClusterScheduler;
+
+// Built-in discrete-event simulator, executing a [Model] directly (no export, no call to the compiler).
+// The automata are first lowered to flat transition tables and bytecode (see [ModelTables]).
+// In compiled mode (see [setCompiled]), reactions are delegated to a native version of the model
+// (see [CompiledModel]); the stimuli and the trace are handled the same way.
+//
+// Semantics (following that of the RFSM simulator)
+// - at each date, the values of the inputs given by the stimuli are updated, then the FSMs are triggered
+//   by the input events occuring at this date
+// - a reaction is a sequence of micro-steps. At each micro-step, each FSM triggered by one of the current
+//   events takes at most one transition (an error is reported if several transitions are enabled). All FSMs
+//   see the same values; updates of outputs and shared variables take effect at the end of the micro-step.
+//   Shared events emitted during a micro-step trigger the next one
+// - actions of a transition are executed sequentially (or synchronously, when [synchronousActions] is set)
+// - entering a state sets the outputs listed in its valuations
+// The simulation stops when all stimuli are exhausted.
+//
+// With [setThreads], the automata are partitioned into clusters sharing no variable or event (see
+// [ModelTables::clusters]), and the clusters are evaluated in parallel at each micro-step. Automata of a
+// cluster are still evaluated in order, and the results of a micro-step are merged by automaton rank, so
+// that the trace is the same as in sequential mode.
+//
+// With [setLog], a binary log of the simulation is also written next to the trace (see [TraceLog]).
+// With [setProfiling], transitions taken, guard evaluations and time spent in each state are counted (see
+// [SimProfile]); the profile is written next to the trace.
+
+class Simulator
+{
+public:
+  Simulator(Model *model, bool synchronousActions = false);
+  ~Simulator();
+
+  // Settings given by the options of the "sim" category. [cxx] is empty if not in compiled mode.
+  // Returns a warning, or "" if all the options can be honoured
+  static QString settings(QStringList simOpts, int& vcdIntSize, bool& vcdCompressed, QString& cxx);
+  static int intOption(QStringList opts, QString name, int def); // Value of option "[name] n", [def] if absent
+
+  void setCompiled(QString cacheDir, QString compiler);
+  void setThreads(int nbThreads) { this->nbThreads = nbThreads; } // Not in compiled mode. Default: 1
+  void setLog(bool logging) { this->logging = logging; }
+  bool isLogging() const { return logging; }
+  QString getLogFile() const { return logFile; } // Written by the last run, if any
+  void setProfiling(bool profiling) { this->profiling = profiling; } // Not in compiled mode
+  bool isProfiling() const { return profiling; }
+  const SimProfile& getProfile() const { return profile; } // Of the last run (empty if not profiled)
+  QString getProfileFile() const { return profileFile; }   // Idem
+  void setStimuli(const QHash<QString,Stimulus>& stimuli) { this->stimuli = stimuli; } // Overrides that of the named inputs
+  void setTables(ModelTables *tables); // Shares tables lowered by another simulator (not owned)
+  bool build(); // Lowers (and compiles) the model. Called by [run]
+  ModelTables* getTables() const { return tables; }
+  // Snapshots are written every [interval] time units (0: never) next to the trace (see [SimSnapshot]).
+  // The simulation stops after date [stopTime] (-1: never); a snapshot is then written
+  void setSnapshots(int interval, int stopTime = -1);
+  bool run(QString vcdFile, int vcdIntSize = 8, bool vcdCompressed = false);
+  bool resume(const SimSnapshot& snapshot, QString vcdFile, int vcdIntSize = 8, bool vcdCompressed = false);
+  QStringList getSnapshots() const { return snapshots; } // Written by the last run
+  // Snapshots kept in memory by the last run, every [period] dates (0: never)
+  void setCheckpoints(int period);
+  const QList<SimSnapshot>& getCheckpoints() const { return checkpoints; }
+  QHash<QString,int> getFirstVisits() const; // "<fsm>.<state>" -> first date at which the FSM was in this state
+  QStringList getErrors() { return errors; }
+  int getNbTransitions() const { return nbTransitions; }
+  int getEndTime() const { return endTime; }
+  QList<QPair<QString,int>> getFinalValues() const; // Non-event outputs and shared variables, after [run]
+
+private:
+  Model *model;
+  bool synchronousActions;
+  ModelTables *tables;
+  bool sharedTables;
+  CompiledModel *native;   // In compiled mode
+  QString cacheDir;        // Idem
+  QString compiler;        // Idem
+  int nbThreads;
+  ClusterScheduler *scheduler; // When evaluating clusters of automata in parallel
+  VcdWriter *vcd;          // During [run]
+  bool logging;
+  TraceLog *log;           // During [run], when logging
+  QString logFile;
+  QVector<int> logSlots;   // IO index of each slot (-1 if not an IO)
+  QVector<int> logEvents;  // IO index of each event (-1 if not an IO)
+  bool profiling;
+  bool profiled;           // During [run], when profiling
+  QVector<int> profTransitions; // Index of the first transition of each FSM in the counters below
+  QVector<int> profStates;      // Idem for states
+  QVector<qint64> fireCounts;   // Per transition
+  QVector<qint64> guardTries;   // Idem
+  QVector<qint64> guardFailures;// Idem
+  QVector<qint64> stateEntries; // Per state
+  QVector<qint64> stateTimes;   // Idem
+  int profDate;                 // Date up to which [stateTimes] are counted
+  SimProfile profile;
+  QString profileFile;
+  QList<Iov*> ios;
+  QHash<QString,Stimulus> stimuli;
+  QVector<int> store;      // Current values of all variables, indexed by slot
+  QVector<int> current;    // Current state of each FSM
+  QVector<int> vcdSlots;   // Signal index in the VCD trace of each slot (-1 if not traced)
+  QVector<int> vcdEvents;  // Signal index in the VCD trace of each event
+  QVector<int> vcdStates;  // Signal index in the VCD trace of the state of each FSM
+  QStringList errors;
+  int nbTransitions;
+  int endTime;
+  int snapshotInterval;
+  int stopTime;
+  QStringList snapshots;
+  int checkpointPeriod;
+  QList<SimSnapshot> checkpoints;
+  QVector<QVector<int>> firstVisits; // For each FSM and state, -1 if not visited
+
+  static const int maxMicroSteps;
+
+  bool simulate(const SimSnapshot *from, QString vcdFile, int vcdIntSize, bool vcdCompressed);
+  SimSnapshot snapshot(int time) const;
+  void saveSnapshot(int time, QString vcdFile);
+  bool restore(const SimSnapshot& s);
+  void visit(int time);
+  bool react(QVector<int> events, VcdWriter& vcd);
+  const FsmTable::Entry* fire(const FsmTable *fsm, const QVector<int>& events, Bytecode::Context& ctx, QString& error,
+                              qint64 *tries = NULL, qint64 *failures = NULL) const;
+  bool parallelStep(const QVector<int>& events, QVector<const FsmTable::Entry*>& fired, QVector<QPair<int,int>>& updates, QVector<int>& emitted,
+                    QVector<QPair<int,int>>& ends, qint64 *tries, qint64 *failures);
+  void logStep(const QVector<const FsmTable::Entry*>& fired, const QVector<QPair<int,int>>& ends,
+               const QVector<QPair<int,int>>& updates, const QVector<int>& emitted);
+  void commit(const QVector<QPair<int,int>>& updates, VcdWriter& vcd);
+  void startProfile(int time);
+  void countFirings(const QVector<const FsmTable::Entry*>& fired);
+  SimProfile makeProfile(int start) const;
+  bool nativeResult(int r, const int *info);
+  static void traceChange(void *sim, int slot, int value);
+  static void traceEvent(void *sim, int event);
+  static void traceState(void *sim, int fsm, int state);
+};
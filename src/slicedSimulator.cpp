@@ -0,0 +1,337 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "slicedSimulator.h"
+#include "model.h"
+#include "iov.h"
+#include "transition.h"
+#include "fsmTable.h"
+#include <QtAlgorithms>
+#include <QDebug>
+#include <stdexcept>
+
+const int SlicedSimulator::maxMicroSteps = 1000; // As for [Simulator]
+
+SlicedSimulator::SlicedSimulator(ModelTables *tables)
+{
+  this->tables = tables;
+  this->alive = 0;
+}
+
+// All values must be booleans, so that each one fits in a bit: inputs are booleans or events, and the
+// code only involves boolean constants and operators (comparisons of booleans included)
+
+bool SlicedSimulator::supports(const ModelTables *tables, QString& why)
+{
+  foreach ( const Iov *io, tables->model->getIos() )
+    if ( io->kind == Iov::IoIn && io->type == Iov::TyInt ) {
+      why = "input " + io->name + " is not a boolean or an event";
+      return false;
+      }
+  const QVector<qint32>& c = tables->code.code;
+  for ( int pc=0; pc<c.size(); ) {
+    switch ( c.at(pc) ) {
+    case Bytecode::PUSH:
+      if ( c.at(pc+1) != 0 && c.at(pc+1) != 1 ) {
+        why = "the model uses integer constants (" + QString::number(c.at(pc+1)) + ")";
+        return false;
+        }
+      pc += 2;
+      break;
+    case Bytecode::LOAD:
+    case Bytecode::STORE:
+    case Bytecode::EMIT:
+    case Bytecode::JZ:
+    case Bytecode::JMP:
+      pc += 2;
+      break;
+    case Bytecode::STOREG:
+      pc += 3;
+      break;
+    case Bytecode::LNOT: case Bytecode::TOBOOL:
+    case Bytecode::EQ: case Bytecode::NE: case Bytecode::LT: case Bytecode::GT: case Bytecode::LE: case Bytecode::GE:
+    case Bytecode::BAND: case Bytecode::BOR: case Bytecode::BXOR:
+    case Bytecode::RET:
+      pc++;
+      break;
+    default:
+      why = "the model uses integer operators";
+      return false;
+    }
+  }
+  return true;
+}
+
+// Execution of a code block for the lanes in [active]. Returns the lanes for which the block returns a
+// non-zero value. [init] gives the initial stack (when called for the taken branch of a jump)
+
+SlicedSimulator::Word SlicedSimulator::exec(int pc, Word active, const Word *init, int sp)
+{
+  Word stack[Bytecode::maxStack];
+  for ( int i=0; i<sp; i++ ) stack[i] = init[i];
+  Word r = 0;
+  const qint32 *c = tables->code.code.constData();
+  while ( true ) {
+    switch ( c[pc++] ) {
+    case Bytecode::PUSH: stack[sp++] = c[pc++] ? ~Word(0) : 0; break;
+    case Bytecode::LOAD: stack[sp++] = store.at(c[pc++]); break;
+    case Bytecode::STORE: {
+      Word& s = store[c[pc++]];
+      s = (s & ~active) | (stack[--sp] & active);
+      break;
+      }
+    case Bytecode::STOREG: {
+      Word v = stack[--sp];
+      Update u = { c[pc], v, active };
+      updates.append(u);
+      Word& s = store[c[pc+1]];
+      s = (s & ~active) | (v & active);
+      pc += 2;
+      break;
+      }
+    case Bytecode::EMIT: emitted[c[pc++]] |= active; break;
+    case Bytecode::JZ: {
+      Word v = stack[--sp];
+      Word taken = active & ~v;
+      int target = c[pc++];
+      if ( taken == active ) pc = target;
+      else if ( taken ) {
+        // Lanes diverge: those taking the jump run their path first
+        r |= exec(target, taken, stack, sp);
+        active &= v;
+        }
+      break;
+      }
+    case Bytecode::JMP: pc = c[pc]; break;
+    case Bytecode::LNOT: stack[sp-1] = ~stack[sp-1]; break;
+    case Bytecode::TOBOOL: break;
+    case Bytecode::EQ: sp--; stack[sp-1] = ~(stack[sp-1] ^ stack[sp]); break;
+    case Bytecode::NE: sp--; stack[sp-1] ^= stack[sp]; break;
+    case Bytecode::LT: sp--; stack[sp-1] = ~stack[sp-1] & stack[sp]; break;
+    case Bytecode::GT: sp--; stack[sp-1] &= ~stack[sp]; break;
+    case Bytecode::LE: sp--; stack[sp-1] = ~stack[sp-1] | stack[sp]; break;
+    case Bytecode::GE: sp--; stack[sp-1] |= ~stack[sp]; break;
+    case Bytecode::BAND: sp--; stack[sp-1] &= stack[sp]; break;
+    case Bytecode::BOR: sp--; stack[sp-1] |= stack[sp]; break;
+    case Bytecode::BXOR: sp--; stack[sp-1] ^= stack[sp]; break;
+    case Bytecode::RET: return r | (sp > 0 ? stack[sp-1] & active : active);
+    default:
+      throw std::runtime_error("instruction not supported in bit-sliced mode");
+    }
+  }
+}
+
+void SlicedSimulator::commit()
+{
+  foreach ( const Update& u, updates ) {
+    Word& s = store[u.slot];
+    s = (s & ~u.lanes) | (u.value & u.lanes);
+    }
+}
+
+// Stops the lanes in [lanes], recording [msg] for each of them (only the first error of a lane is kept)
+
+void SlicedSimulator::fail(Word lanes, QString msg, const QVector<int>& now)
+{
+  lanes &= alive;
+  alive &= ~lanes;
+  for ( ; lanes; lanes &= lanes-1 ) {
+    int l = qCountTrailingZeroBits(lanes);
+    laneErrors[l] << "t=" + QString::number(now.at(l)) + ": " + msg;
+    }
+}
+
+// Reaction of all lanes to the events of their current date ([events] gives the lanes in which
+// each event occurs). See [Simulator::react]
+
+void SlicedSimulator::react(QVector<Word> events, const QVector<int>& now)
+{
+  struct Move {
+    const FsmTable::Entry *entry;
+    int src;
+    Word lanes;
+  };
+  for ( int step=0; ; step++ ) {
+    Word pending = 0;
+    QVector<int> triggers; // Events occuring in at least one lane
+    for ( int e=0; e<events.size(); e++ ) {
+      events[e] &= alive;
+      if ( ! events.at(e) ) continue;
+      pending |= events.at(e);
+      triggers.append(e);
+      }
+    if ( ! pending ) return;
+    if ( step >= maxMicroSteps ) {
+      fail(pending, "too many micro-steps (instantaneous loop on shared events ?)", now);
+      return;
+      }
+    updates.clear();
+    emitted.fill(0);
+    foreach ( const FsmTable *fsm, tables->fsms ) {
+      QVector<Move> moves;
+      Word firing = 0; // Lanes in which a transition of this FSM is enabled
+      for ( int s=0; s<fsm->nbStates; s++ ) {
+        Word m = inState.at(fsm->fsm).at(s) & pending;
+        if ( ! m ) continue;
+        foreach ( int ev, triggers ) {
+          Word em = m & events.at(ev);
+          if ( ! em ) continue;
+          const FsmTable::Cell& cell = fsm->cell(s, ev);
+          for ( int i=cell.first; i<cell.first+cell.count; i++ ) {
+            const FsmTable::Entry& e = fsm->entries.at(i);
+            Word g = exec(e.guard, em);
+            Word clash = g & firing;
+            if ( clash ) {
+              foreach ( const Move& mv, moves )
+                if ( mv.lanes & clash )
+                  fail(mv.lanes & clash, fsm->name + ": non deterministic transitions " + fsm->transitions.at(mv.entry->id)->toString()
+                                                                       + " and " + fsm->transitions.at(e.id)->toString(), now);
+              g &= ~clash;
+              }
+            if ( ! g ) continue;
+            firing |= g;
+            Move mv = { &e, s, g };
+            moves.append(mv);
+            }
+          }
+        }
+      foreach ( const Move& mv, moves ) {
+        Word f = mv.lanes & alive;
+        if ( ! f ) continue;
+        exec(mv.entry->action, f);
+        exec(fsm->enter.at(mv.entry->dst), f);
+        QVector<Word>& st = inState[fsm->fsm];
+        st[mv.src] &= ~f;
+        st[mv.entry->dst] |= f;
+        for ( ; f; f &= f-1 ) nbTransitions[qCountTrailingZeroBits(f)]++;
+        }
+      }
+    commit();
+    for ( int e=0; e<events.size(); e++ ) events[e] = tables->sharedEvent.at(e) ? emitted.at(e) : 0;
+    }
+}
+
+bool SlicedSimulator::run(const QList<QHash<QString,Stimulus>>& stimuli)
+{
+  errors.clear();
+  int n = stimuli.length();
+  if ( n > nbLanes ) {
+    errors << "at most " + QString::number(nbLanes) + " simulations can be run at once";
+    return false;
+    }
+  const SymbolTable& syms = tables->syms;
+  ios = tables->model->getIos();
+  Word lanes = n == nbLanes ? ~Word(0) : (Word(1) << n) - 1;
+  store = QVector<Word>(syms.getNbSlots(), 0);
+  for ( int i=0; i<store.size(); i++ )
+    if ( tables->initValues.value(i) ) store[i] = lanes;
+  inState.clear();
+  foreach ( const FsmTable *fsm, tables->fsms ) inState.append(QVector<Word>(fsm->nbStates, 0));
+  emitted = QVector<Word>(syms.getNbEvents(), 0);
+  alive = lanes;
+  laneErrors = QVector<QStringList>(n);
+  nbTransitions = QVector<int>(n, 0);
+  endTime = QVector<int>(n, 0);
+  // Stimuli, one cursor per lane and input (lane-major)
+  QList<int> inputs;   // IO rank
+  QVector<int> index;  // Slot or event of each input
+  for ( int i=0; i<ios.length(); i++ ) {
+    if ( ios.at(i)->kind != Iov::IoIn ) continue;
+    inputs.append(i);
+    index.append(ios.at(i)->type == Iov::TyEvent ? syms.event(ios.at(i)->name) : syms.global(ios.at(i)->name));
+    }
+  int m = inputs.length();
+  QList<Stimulus> stims;
+  for ( int l=0; l<n; l++ )
+    foreach ( int i, inputs ) {
+      auto s = stimuli.at(l).constFind(ios.at(i)->name);
+      stims.append(s != stimuli.at(l).constEnd() ? s.value() : ios.at(i)->stim);
+      }
+  QList<StimulusCursor> cursors;
+  for ( int k=0; k<stims.length(); k++ ) cursors.append(StimulusCursor(stims.at(k)));
+  QVector<int> nextTime(n*m, -1), nextValue(n*m, 0); // -1 when exhausted
+  for ( int k=0; k<n*m; k++ )
+    if ( ! cursors[k].next(nextTime[k], nextValue[k]) ) nextTime[k] = -1;
+  QVector<int> now(n, 0);
+  QVector<Word> events(syms.getNbEvents());
+  try {
+    // Initialisation
+    updates.clear();
+    foreach ( const FsmTable *fsm, tables->fsms ) {
+      exec(fsm->initAction, lanes);
+      exec(fsm->enter.at(fsm->initState), lanes);
+      inState[fsm->fsm][fsm->initState] = lanes;
+      }
+    commit();
+    // Main loop. Each iteration handles the next date of each lane
+    while ( true ) {
+      events.fill(0);
+      Word active = 0;
+      for ( int l=0; l<n; l++ ) {
+        Word bit = Word(1) << l;
+        if ( ! (alive & bit) ) continue;
+        int t = -1, first = -1;
+        for ( int j=0; j<m; j++ ) {
+          int tj = nextTime.at(l*m+j);
+          if ( tj >= 0 && (t < 0 || tj < t) ) { t = tj; first = j; }
+          }
+        if ( t < 0 ) continue; // Exhausted
+        if ( t < now.at(l) ) {
+          fail(bit, "stimulus dates must be increasing (input " + ios.at(inputs.at(first))->name + ", t=" + QString::number(t) + ")", now);
+          continue;
+          }
+        now[l] = t;
+        active |= bit;
+        for ( int j=0; j<m; j++ ) {
+          int k = l*m+j;
+          while ( nextTime.at(k) == t ) {
+            int v = nextValue.at(k);
+            Word& w = ios.at(inputs.at(j))->type == Iov::TyEvent ? events[index.at(j)] : store[index.at(j)];
+            if ( v == 1 || ios.at(inputs.at(j))->type == Iov::TyEvent ) w |= bit;
+            else if ( v == 0 ) w &= ~bit;
+            else fail(bit, "non boolean value " + QString::number(v) + " for input " + ios.at(inputs.at(j))->name, now);
+            if ( ! cursors[k].next(nextTime[k], nextValue[k]) ) nextTime[k] = -1;
+            }
+          }
+        }
+      if ( ! active ) break;
+      react(events, now);
+      }
+    }
+  catch ( std::runtime_error& e ) {
+    errors << QString::fromStdString(e.what());
+    return false;
+    }
+  endTime = now;
+  int total = 0;
+  foreach ( int k, nbTransitions ) total += k;
+  qDebug() << "SlicedSimulator::run:" << n << "lanes," << total << "transitions";
+  return true;
+}
+
+QList<QPair<QString,int>> SlicedSimulator::getFinalValues(int lane) const
+{
+  QList<QPair<QString,int>> r;
+  foreach ( Iov *io, ios ) {
+    if ( io->kind == Iov::IoIn || io->type == Iov::TyEvent ) continue;
+    r.append(QPair<QString,int>(io->name, int((store.value(tables->syms.global(io->name)) >> lane) & 1)));
+    }
+  return r;
+}
+
+int SlicedSimulator::getState(int fsm, int lane) const
+{
+  const QVector<Word>& st = inState.at(fsm);
+  for ( int s=0; s<st.size(); s++ )
+    if ( (st.at(s) >> lane) & 1 ) return s;
+  return -1;
+}
@@ -0,0 +1,88 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QVector>
+#include <QPair>
+#include <QHash>
+#include "stimulus.h"
+
+class Iov;
+class ModelTables;
+
+// Bit-sliced version of the built-in simulator, running [nbLanes] independent simulations of a model at once.
+//
+// Each variable is held in a machine word whose bit k gives its value in simulation (lane) k, and each
+// state of each FSM by the set of lanes currently in this state. Guards, actions and valuations are
+// executed by interpreting the bytecode of [ModelTables] with bitwise operations on these words; a
+// conditional jump taken by some lanes only splits the set of active lanes, each part running its own
+// path. This only applies to models whose values are all booleans (see [supports]).
+//
+// The automata have no notion of time, so lanes are aligned on the rank of their dates rather than on
+// the dates themselves: the n-th reaction of all lanes is computed at the same time. Apart from this,
+// the semantics is that of [Simulator], each lane stopping at its first error. No trace is written.
+
+class SlicedSimulator
+{
+public:
+  typedef quint64 Word;
+  static const int nbLanes = 64;
+
+  SlicedSimulator(ModelTables *tables); // Already built (not owned)
+
+  // Returns false, with the reason in [why], if the model cannot be simulated in this mode
+  static bool supports(const ModelTables *tables, QString& why);
+
+  // One simulation per element of [stimuli] (at most [nbLanes]), each overriding the stimuli of the
+  // named inputs. Returns false if the simulation could not be run at all; errors occuring in a lane only
+  // stop this lane (see [getErrors(int)])
+  bool run(const QList<QHash<QString,Stimulus>>& stimuli);
+  QStringList getErrors() const { return errors; }
+
+  // Results of lane [lane] after [run]
+  bool isOk(int lane) const { return laneErrors.at(lane).isEmpty(); }
+  QStringList getErrors(int lane) const { return laneErrors.at(lane); }
+  int getNbTransitions(int lane) const { return nbTransitions.at(lane); }
+  int getEndTime(int lane) const { return endTime.at(lane); }
+  QList<QPair<QString,int>> getFinalValues(int lane) const; // Non-event outputs and shared variables
+  int getState(int fsm, int lane) const; // Current state of FSM [fsm]
+
+private:
+  struct Update {
+    qint32 slot;
+    Word value;
+    Word lanes;
+  };
+
+  ModelTables *tables;
+  QList<Iov*> ios;
+  QStringList errors;
+  QVector<Word> store;             // Indexed by slot
+  QVector<QVector<Word>> inState;  // Lanes in each state of each FSM
+  QVector<Update> updates;         // During a micro-step
+  QVector<Word> emitted;           // Idem, indexed by event
+  Word alive;                      // Lanes still running (not failed)
+  QVector<QStringList> laneErrors;
+  QVector<int> nbTransitions;
+  QVector<int> endTime;
+
+  static const int maxMicroSteps;
+
+  Word exec(int pc, Word active, const Word *init = NULL, int sp = 0);
+  void commit();
+  void react(QVector<Word> events, const QVector<int>& now);
+  void fail(Word lanes, QString msg, const QVector<int>& now);
+};
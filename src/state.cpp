@@ -12,6 +12,7 @@
 
 #include "state.h"
 #include "transition.h"
+#include "globals.h"
 
 #include <QGraphicsScene>
 #include <QGraphicsSceneMouseEvent>
@@ -24,6 +25,7 @@ QColor State::boxBackground = Qt::white;
 QColor State::selectedColor = Qt::darkCyan;
 QColor State::unSelectedColor = Qt::black;
 QString State::initPseudoId = "_init";
+QColor State::heatColor = QColor(230, 60, 0);
 
 void State::init(QString id, QStringList attrs, QSize sz)
 {
@@ -38,7 +40,9 @@ void State::init(QString id, QStringList attrs, QSize sz)
     setFlag(QGraphicsItem::ItemIsSelectable, true);
     setFlag(QGraphicsItem::ItemSendsGeometryChanges, true);
     this->id = id;
+    touch();
     this->attrs = attrs;
+    this->heat = -1;
 }
 
 State::State(QString id, QStringList attrs, QGraphicsItem *parent)
@@ -71,6 +75,26 @@ State::State(QPointF pos, QGraphicsItem *parent)
   setPos(pos);
 }
 
+void State::touch()
+{
+  revision = Globals::newRevision();
+}
+
+void State::setHeat(double heat, QString info)
+{
+  this->heat = heat;
+  setToolTip(info);
+  update();
+}
+
+QColor State::heated(QColor c, double heat)
+{
+  double h = qBound(0.0, heat, 1.0);
+  return QColor::fromRgbF(c.redF() + h * (heatColor.redF() - c.redF()),
+                          c.greenF() + h * (heatColor.greenF() - c.greenF()),
+                          c.blueF() + h * (heatColor.blueF() - c.blueF()));
+}
+
 void State::removeTransition(Transition *transition)
 {
     int index = transitions.indexOf(transition);
@@ -108,7 +132,7 @@ void State::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *
     }
   else {
     painter->setPen(QPen(isSelected() ? selectedColor : unSelectedColor, 1));
-    painter->setBrush(boxBackground);
+    painter->setBrush(heat < 0 ? boxBackground : heated(boxBackground, heat));
     // painter->drawPolygon(myPolygon);
     // painter->setRenderHint(QPainter::Antialiasing);
     QPainterPath path;
@@ -46,19 +46,24 @@ public:
     void addTransition(Transition *transition);
     int type() const override { return Type;}
     QString getId() const { return id; }
-    void setId(QString id) { this->id = id; }
+    void setId(QString id) { if ( id != this->id ) { this->id = id; touch(); } }
     QStringList getAttrs() const { return attrs; }
-    void setAttrs(QStringList attrs) { this->attrs = attrs; }
+    void setAttrs(QStringList attrs) { if ( attrs != this->attrs ) { this->attrs = attrs; touch(); } }
+    quint64 getRevision() const { return revision; } // Changed by each modification of the id or valuations
     QList<Transition *> getTransitionsTo(State *dstState);
     QList<Transition *> getTransitionsFrom(State *srcState);
     QList<Transition *> getTransitionsOut();
     QList<Transition *> getTransitionsIn();
     Location locateEvent(QGraphicsSceneMouseEvent* event);
     bool isPseudo() const { return isPseudoState; };
+    void setHeat(double heat, QString info = QString()); // Heatmap of a simulation profile, in [0,1] (-1: none), with its tooltip
+    double getHeat() const { return heat; }
+    static QColor heated(QColor c, double heat); // [c] shaded towards [heatColor]
 
     static QSize boxSize;
     static QSize dskSize;
     static QString initPseudoId;
+    static QColor heatColor;
 
     friend QDebug operator<<(QDebug d, const State& s);
 
@@ -78,5 +83,9 @@ private:
     QPolygonF myPolygon;
     QList<Transition *> transitions;
     bool isPseudoState;
+    quint64 revision;
+    double heat;
+
+    void touch();
 };
 
@@ -15,14 +15,40 @@
 #include <QSpinBox>
 #include <QVBoxLayout>
 #include <QPushButton>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QDir>
 
 #include "stimuli.h"
+#include "stimulusReader.h"
+
+// Parameters of the generators, in the order of their textual form, with default values
+
+static QList<QPair<QString,int>> generatorParams(Stimulus::Kind kind, bool isBool)
+{
+  typedef QPair<QString,int> P;
+  switch ( kind ) {
+  case Stimulus::Random: return { P("Seed", 0), P("Min gap", 1), P("Max gap", 10), P("Start Time", 0), P("End Time", 1000) };
+  case Stimulus::Poisson: return { P("Seed", 0), P("Mean gap", 10), P("Start Time", 0), P("End Time", 1000) };
+  case Stimulus::Bursty: return { P("Period", 100), P("Burst length", 5), P("Gap", 1), P("Start Time", 0), P("End Time", 1000) };
+  case Stimulus::Counter: return { P("Period", 10), P("Start Time", 0), P("End Time", 1000), P("Initial value", 0), P("Step", 1), P("Modulo", isBool ? 2 : 0) };
+  case Stimulus::RandomValues: return { P("Seed", 0), P("Period", 10), P("Start Time", 0), P("End Time", 1000), P("Min", 0), P("Max", isBool ? 1 : 100) };
+  case Stimulus::Repeat: return { P("Period", 100), P("Count", 10) };
+  default: return {};
+  }
+}
 
 Stimuli::Stimuli(Stimulus::Kind kind, Iov* inp, QWidget *parent)
     : QDialog(parent)
 {
   selectedInp = inp;
   selectedKind = kind;
+  fileEdit = signalEdit = NULL;
+  previewFrom = NULL;
+  preview = NULL;
+  lastPreviewDate = -1;
   QRect r = parent->geometry();
   setGeometry(QRect(r.x()+r.width()/2,r.y()+r.height()/2,250,40));
   centralWidget = new QWidget(parent);
@@ -95,6 +121,71 @@ Stimuli::Stimuli(Stimulus::Kind kind, Iov* inp, QWidget *parent)
     for (int i=0; i<vcs.length(); i++ )
       _addValueChangesRow(vcs[i]);
     break;
+  case Stimulus::File: {
+    File_stim f = selectedInp->stim.kind == Stimulus::File ? selectedInp->stim.desc.file : File_stim();
+    rowLayout = new QHBoxLayout(form);
+    rowLayout->addWidget(new QLabel("File"));
+    fileEdit = new QLineEdit(f.fileName);
+    fileEdit->setPlaceholderText("<.csv or .vcd file>");
+    rowLayout->addWidget(fileEdit);
+    QPushButton *browseButton = new QPushButton("Browse...", form);
+    rowLayout->addWidget(browseButton);
+    connect(browseButton, &QPushButton::clicked, this, &Stimuli::browseFile);
+    rows.append(rowLayout);
+    formLayout->addLayout(rowLayout);
+    rowLayout = new QHBoxLayout(form);
+    rowLayout->addWidget(new QLabel("Signal"));
+    signalEdit = new QLineEdit(f.signal);
+    signalEdit->setPlaceholderText("<CSV column or VCD scope.signal>");
+    rowLayout->addWidget(signalEdit);
+    rows.append(rowLayout);
+    formLayout->addLayout(rowLayout);
+    // Preview, only reading the displayed occurrences
+    rowLayout = new QHBoxLayout(form);
+    rowLayout->addWidget(new QLabel("From date"));
+    previewFrom = new QSpinBox;
+    previewFrom->setRange(0, maxParam);
+    rowLayout->addWidget(previewFrom);
+    QPushButton *previewButton = new QPushButton("Preview", form);
+    rowLayout->addWidget(previewButton);
+    connect(previewButton, &QPushButton::clicked, this, &Stimuli::updatePreview);
+    QPushButton *nextButton = new QPushButton("Next", form);
+    rowLayout->addWidget(nextButton);
+    connect(nextButton, &QPushButton::clicked, this, &Stimuli::nextPreviewPage);
+    rows.append(rowLayout);
+    formLayout->addLayout(rowLayout);
+    preview = new QListWidget(form);
+    formLayout->addWidget(preview);
+    if ( ! f.fileName.isEmpty() ) updatePreview();
+    break;
+    }
+  default: {
+    // Generators. Existing values are read back from the textual form
+    QList<QPair<QString,int>> params = generatorParams(selectedKind, inp->type == Iov::TyBool);
+    QStringList values = selectedInp->stim.kind == selectedKind ? selectedInp->stim.toString().split(" ").mid(1) : QStringList();
+    for ( int i=0; i<params.length(); i++ )
+      addPeriodicRow(params.at(i).first, i < values.length() ? values.at(i).toInt() : params.at(i).second, 1, -maxParam, maxParam);
+    if ( selectedKind != Stimulus::Repeat ) break;
+    // Pattern of a [Repeat], edited like sporadic dates or value changes
+    rowLayout = new QHBoxLayout(form);
+    rowLayout->setObjectName("rowLayout");
+    addButton = new QPushButton("Add", form);
+    rowLayout->addWidget(addButton);
+    if ( inp->type == Iov::TyEvent )
+      connect(addButton, &QPushButton::clicked, this, &Stimuli::addSporadicRow);
+    else
+      connect(addButton, &QPushButton::clicked, this, &Stimuli::addValueChangesRow);
+    mButtonToLayoutMap.insert(addButton, rowLayout);
+    rows.append(rowLayout);
+    formLayout->addLayout(rowLayout);
+    if ( selectedInp->stim.kind == Stimulus::Repeat ) {
+      foreach ( const auto& p, selectedInp->stim.desc.repeat.pattern ) {
+        if ( inp->type == Iov::TyEvent ) _addSporadicRow(p.first);
+        else _addValueChangesRow(p);
+        }
+      }
+    break;
+    }
   }
 
   QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
@@ -174,8 +265,60 @@ void Stimuli::_addValueChangesRow(QPair<int,int> vc) {
 
 void Stimuli::addValueChangesRow() { _addValueChangesRow(QPair<int,int>(0,0)); }
 
+void Stimuli::browseFile()
+{
+  QString fname = QFileDialog::getOpenFileName(this, "Select stimulus file", Stimulus::baseDir, "Traces (*.csv *.vcd);;All files (*)");
+  if ( fname.isEmpty() ) return;
+  fileEdit->setText(Stimulus::baseDir.isEmpty() ? fname : QDir(Stimulus::baseDir).relativeFilePath(fname));
+  previewFrom->setValue(0);
+  if ( ! signalEdit->text().trimmed().isEmpty() ) updatePreview();
+}
+
+Stimulus Stimuli::fileStimulus()
+{
+  return Stimulus(File_stim(fileEdit->text().trimmed(), signalEdit->text().trimmed(), selectedInp->type == Iov::TyEvent));
+}
+
+void Stimuli::updatePreview()
+{
+  preview->clear();
+  Stimulus st = fileStimulus();
+  StimulusReader reader(st.filePath(), st.desc.file.signal, st.desc.file.events);
+  if ( ! reader.isOpen() ) {
+    preview->addItem(reader.getError());
+    return;
+    }
+  reader.seek(previewFrom->value() - 1);
+  int t, v;
+  lastPreviewDate = -1;
+  for ( int i=0; i<previewRows && reader.next(t, v); i++ ) {
+    preview->addItem(st.desc.file.events ? "t=" + QString::number(t) : "t=" + QString::number(t) + " : " + QString::number(v));
+    lastPreviewDate = t;
+    }
+  if ( lastPreviewDate < 0 ) preview->addItem("No occurrence after this date");
+}
+
+void Stimuli::nextPreviewPage()
+{
+  if ( lastPreviewDate < 0 ) return;
+  previewFrom->setValue(lastPreviewDate + 1);
+  updatePreview();
+}
+
 void Stimuli::acceptChanges()
 {
+  if ( selectedKind == Stimulus::File ) {
+    Stimulus stim = fileStimulus();
+    QString err = Stimulus::check(stim.toString(), selectedInp->type == Iov::TyEvent);
+    if ( ! err.isEmpty() ) {
+      QMessageBox::warning(this, "", err);
+      return;
+      }
+    selectedInp->stim = stim;
+    clearForm();
+    QDialog::accept();
+    return;
+    }
   QList<int> values;
   for ( int i = 0; i < formLayout->count(); ++i ) {
     QLayout* layout = formLayout->itemAt(i)->layout();
@@ -185,7 +328,7 @@ void Stimuli::acceptChanges()
         if ( spinBox ) values.append(spinBox->value());
         }
     }
-  Stimulus stim(selectedKind, values);
+  Stimulus stim(selectedKind, values, selectedInp->type != Iov::TyEvent);
   selectedInp->stim = stim;
   clearForm();
   QDialog::accept();
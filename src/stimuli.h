@@ -22,6 +22,9 @@ class QFrame;
 class QPushButton;
 class QSpacerItem;
 class QComboBox;
+class QLineEdit;
+class QSpinBox;
+class QListWidget;
 
 class Stimuli: public QDialog {
     Q_OBJECT
@@ -32,6 +35,8 @@ public:
 
 private:
   const int maxTime = 1000;
+  const int maxParam = 1000000000; // For generators
+  const int previewRows = 100;      // For file-backed stimuli
 
   QHash<QPushButton*, QHBoxLayout*> mButtonToLayoutMap;
   QList<QHBoxLayout*> rows;
@@ -46,6 +51,13 @@ private:
   QVBoxLayout *verticalLayout_2;
   QSpacerItem *verticalSpacer;
   QFrame *line;
+  QLineEdit *fileEdit;
+  QLineEdit *signalEdit;
+  QSpinBox *previewFrom;
+  QListWidget *preview;
+  int lastPreviewDate;
+
+  Stimulus fileStimulus();
 
 protected:
   void addPeriodicRow(QString name, int val, int step, int lo, int hi);
@@ -57,6 +69,9 @@ private slots:
   void _addValueChangesRow(QPair<int,int> vc);
   void addValueChangesRow();
   void deleteDynamicRow();
+  void browseFile();
+  void updatePreview();
+  void nextPreviewPage();
   void acceptChanges();
   void cancelChanges();
 };
@@ -11,9 +11,20 @@
 /***********************************************************************/
 
 #include "stimulus.h"
+#include "stimulusReader.h"
+#include <QFileInfo>
+#include <QDir>
 #include <QtDebug>
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
 
-Stimulus::Stimulus(Kind kind, QList<int> params)
+static const QStringList kindNames =
+  { "None", "Periodic", "Sporadic", "ValueChanges", "Random", "Poisson", "Bursty", "Counter", "RandomValues", "Repeat", "File" };
+
+QString Stimulus::baseDir;
+
+Stimulus::Stimulus(Kind kind, QList<int> params, bool valued)
 {
   this->kind = kind;
   switch ( kind ) {
@@ -25,7 +36,7 @@ Stimulus::Stimulus(Kind kind, QList<int> params)
   case Sporadic:
     desc.sporadic = Sporadic_stim(params);
     break;
-  case ValueChanges:
+  case ValueChanges: {
     QList<QPair<int,int>> vcs;
     while ( params.length() >= 2 ) {
       int t = params.takeFirst();
@@ -34,6 +45,52 @@ Stimulus::Stimulus(Kind kind, QList<int> params)
       }
     desc.valueChanges = ValueChanges_stim(vcs);
     break;
+    }
+  case Random:
+    desc.random.seed = params.value(0);
+    desc.random.min_gap = params.value(1);
+    desc.random.max_gap = params.value(2);
+    desc.random.start_time = params.value(3);
+    desc.random.end_time = params.value(4);
+    break;
+  case Poisson:
+    desc.poisson.seed = params.value(0);
+    desc.poisson.mean_gap = params.value(1);
+    desc.poisson.start_time = params.value(2);
+    desc.poisson.end_time = params.value(3);
+    break;
+  case Bursty:
+    desc.bursty.period = params.value(0);
+    desc.bursty.length = params.value(1);
+    desc.bursty.gap = params.value(2);
+    desc.bursty.start_time = params.value(3);
+    desc.bursty.end_time = params.value(4);
+    break;
+  case Counter:
+    desc.counter.period = params.value(0);
+    desc.counter.start_time = params.value(1);
+    desc.counter.end_time = params.value(2);
+    desc.counter.init = params.value(3);
+    desc.counter.step = params.value(4);
+    desc.counter.modulo = params.value(5);
+    break;
+  case RandomValues:
+    desc.randomValues.seed = params.value(0);
+    desc.randomValues.period = params.value(1);
+    desc.randomValues.start_time = params.value(2);
+    desc.randomValues.end_time = params.value(3);
+    desc.randomValues.min = params.value(4);
+    desc.randomValues.max = params.value(5);
+    break;
+  case Repeat:
+    desc.repeat.period = params.value(0);
+    desc.repeat.count = params.value(1);
+    desc.repeat.valued = valued;
+    for ( int i=2; i<params.length(); i += valued ? 2 : 1 )
+      desc.repeat.pattern.append(QPair<int,int>(params.at(i), valued ? params.value(i+1) : 1));
+    break;
+  case File: // See [Stimulus(File_stim)]
+    break;
   }
 }
 
@@ -64,10 +121,317 @@ Stimulus::Stimulus(QString txt)
     for ( int i=1; i<l.length(); i+=2 )
       desc.valueChanges.vcs.append(QPair<int,int>(l.at(i).trimmed().toInt(),l.at(i+1).trimmed().toInt()));
     }
+  else if ( l.at(0).trimmed() == "File" ) {
+    // File events|values <signal> <file name, possibly with spaces>
+    Q_ASSERT(l.length() >= 4 );
+    kind = File;
+    desc.file = File_stim(QStringList(l.mid(3)).join(" "), l.at(2), l.at(1) == "events");
+    }
+  else if ( kindNames.indexOf(l.at(0).trimmed()) > ValueChanges ) {
+    // Generators: a few integer parameters (and date:value pairs for a valued [Repeat] pattern)
+    QList<int> params;
+    bool valued = false;
+    for ( int i=1; i<l.length(); i++ ) {
+      QString p = l.at(i).trimmed();
+      if ( p.contains(':') ) {
+        valued = true;
+        params << p.section(':', 0, 0).toInt() << p.section(':', 1).toInt();
+        }
+      else
+        params << p.toInt();
+      }
+    *this = Stimulus(Kind(kindNames.indexOf(l.at(0).trimmed())), params, valued);
+    }
   else
     Q_ASSERT(false);
 }
 
+Stimulus::Stimulus(File_stim file)
+{
+  kind = File;
+  desc.file = file;
+}
+
+QString Stimulus::filePath() const
+{
+  return QDir(baseDir).absoluteFilePath(desc.file.fileName);
+}
+
+bool Stimulus::hasValues() const
+{
+  switch ( kind ) {
+  case ValueChanges:
+  case Counter:
+  case RandomValues:
+    return true;
+  case Repeat:
+    return desc.repeat.valued;
+  case File:
+    return ! desc.file.events;
+  default:
+    return false;
+  }
+}
+
+QString Stimulus::check(QString s, bool forEvent)
+{
+  QStringList l = s.simplified().split(" ");
+  int kind = kindNames.indexOf(l.takeFirst());
+  if ( kind < 0 ) return "unknown stimulus kind in \"" + s + "\"";
+  if ( kind == File ) {
+    if ( l.length() < 3 || (l.at(0) != "events" && l.at(0) != "values") ) return "\"File events|values <signal> <file>\" expected in \"" + s + "\"";
+    if ( (l.at(0) == "events") != forEvent ) return "stimulus \"" + s + "\" does not apply to " + (forEvent ? "an event" : "a valued") + " input";
+    Stimulus st(s);
+    StimulusReader reader(st.filePath(), st.desc.file.signal, forEvent);
+    return reader.getError();
+    }
+  QList<int> p;
+  int nbPairs = 0;
+  foreach ( QString a, l ) {
+    bool ok1, ok2 = true;
+    p << a.section(':', 0, 0).toInt(&ok1);
+    if ( a.contains(':') ) {
+      p << a.section(':', 1).toInt(&ok2);
+      nbPairs++;
+      }
+    if ( ! ok1 || ! ok2 || (a.contains(':') && kind != Repeat) ) return "invalid stimulus parameter \"" + a + "\"";
+    }
+  static const QList<int> arity = { 0, 3, -1, -1, 5, 4, 5, 6, 6, -1 };
+  static const QList<bool> events = { true, true, true, false, true, true, true, false, false, true };
+  bool valued = kind == Repeat ? nbPairs > 0 : ! events.at(kind);
+  if ( kind != None && valued == forEvent ) return "stimulus \"" + s + "\" does not apply to " + (forEvent ? "an event" : "a valued") + " input";
+  if ( arity.at(kind) >= 0 && p.length() != arity.at(kind) ) return "wrong number of parameters in \"" + s + "\"";
+  switch ( kind ) {
+  case ValueChanges:
+    if ( p.length() % 2 != 0 ) return "unpaired date in \"" + s + "\"";
+    break;
+  case Random:
+    if ( p.at(1) < 1 || p.at(2) < p.at(1) ) return "gaps must satisfy 1 <= min <= max in \"" + s + "\"";
+    break;
+  case Poisson:
+    if ( p.at(1) < 1 ) return "mean gap must be at least 1 in \"" + s + "\"";
+    break;
+  case Bursty:
+    if ( p.at(0) < 1 || p.at(1) < 1 || p.at(2) < 1 || qint64(p.at(1)-1) * p.at(2) >= p.at(0) )
+      return "bursts must fit in their period in \"" + s + "\"";
+    break;
+  case Counter:
+    if ( p.at(0) < 1 || p.at(5) < 0 ) return "invalid period or modulo in \"" + s + "\"";
+    break;
+  case RandomValues:
+    if ( p.at(1) < 1 || p.at(5) < p.at(4) ) return "invalid period or range in \"" + s + "\"";
+    break;
+  case Repeat: {
+    if ( p.length() < 2 || p.at(0) < 1 || p.at(1) < 0 ) return "invalid period or count in \"" + s + "\"";
+    if ( valued && nbPairs * 2 != p.length() - 2 ) return "all the dates of a valued pattern need a value in \"" + s + "\"";
+    int prev = -1;
+    for ( int i=2; i<p.length(); i += valued ? 2 : 1 ) {
+      if ( p.at(i) <= prev || p.at(i) >= p.at(0) ) return "pattern dates must be increasing and less than the period in \"" + s + "\"";
+      prev = p.at(i);
+      }
+    break;
+    }
+  default:
+    break;
+  }
+  return "";
+}
+
+StimulusCursor::StimulusCursor(const Stimulus& stim) : stim(&stim)
+{
+  rewind();
+}
+
+void StimulusCursor::rewind()
+{
+  index = 0;
+  last = -1;
+  int seed = 0;
+  switch ( stim->kind ) {
+  case Stimulus::Random: seed = stim->desc.random.seed; break;
+  case Stimulus::Poisson: seed = stim->desc.poisson.seed; break;
+  case Stimulus::RandomValues: seed = stim->desc.randomValues.seed; break;
+  default: break;
+  }
+  rng = quint64(seed) * 0x9E3779B97F4A7C15ULL + 0x2545F4914F6CDD1DULL; // Never 0
+}
+
+// xorshift64*, so that random stimuli do not depend on the platform
+
+int StimulusCursor::random(int lo, int hi)
+{
+  rng ^= rng >> 12;
+  rng ^= rng << 25;
+  rng ^= rng >> 27;
+  quint64 r = (rng * 2685821657736338717ULL) >> 11;
+  return lo + int(r % quint64(qint64(hi) - lo + 1));
+}
+
+StimulusReader* StimulusCursor::fileReader()
+{
+  if ( ! reader ) reader.reset(new StimulusReader(stim->filePath(), stim->desc.file.signal, stim->desc.file.events));
+  if ( ! reader->isOpen() ) qDebug() << "StimulusCursor:" << reader->getError();
+  return reader.data();
+}
+
+bool StimulusCursor::next(int& time, int& value)
+{
+  switch ( stim->kind ) {
+  case Stimulus::None:
+    return false;
+  case Stimulus::File:
+    return fileReader()->next(time, value);
+  case Stimulus::Periodic: {
+    const Periodic_stim& p = stim->desc.periodic;
+    if ( p.period <= 0 && index > 0 ) return false;
+    time = p.start_time + index * p.period;
+    if ( time > p.end_time ) return false;
+    value = 1;
+    break;
+    }
+  case Stimulus::Sporadic:
+    if ( index >= stim->desc.sporadic.dates.length() ) return false;
+    time = stim->desc.sporadic.dates.at(index);
+    value = 1;
+    break;
+  case Stimulus::ValueChanges:
+    if ( index >= stim->desc.valueChanges.vcs.length() ) return false;
+    time = stim->desc.valueChanges.vcs.at(index).first;
+    value = stim->desc.valueChanges.vcs.at(index).second;
+    break;
+  case Stimulus::Random: {
+    const Random_stim& r = stim->desc.random;
+    qint64 t = index == 0 ? r.start_time : qint64(last) + random(qMax(1, r.min_gap), qMax(1, qMax(r.min_gap, r.max_gap)));
+    if ( t > r.end_time ) return false;
+    time = last = int(t);
+    value = 1;
+    break;
+    }
+  case Stimulus::Poisson: {
+    const Poisson_stim& p = stim->desc.poisson;
+    double u = random(0, (1 << 30) - 1) / double(1 << 30);
+    qint64 t = qint64(index == 0 ? p.start_time : last) + qMax(qint64(1), qint64(std::llround(-qMax(1, p.mean_gap) * std::log(1.0 - u))));
+    if ( t > p.end_time ) return false;
+    time = last = int(t);
+    value = 1;
+    break;
+    }
+  case Stimulus::Bursty: {
+    const Bursty_stim& b = stim->desc.bursty;
+    int length = qMax(1, b.length);
+    qint64 t = b.start_time + qint64(index / length) * b.period + qint64(index % length) * b.gap;
+    if ( t > b.end_time || (b.period <= 0 && index >= length) ) return false;
+    time = int(t);
+    value = 1;
+    break;
+    }
+  case Stimulus::Counter: {
+    const Counter_stim& c = stim->desc.counter;
+    qint64 t = c.start_time + qint64(index) * c.period;
+    if ( t > c.end_time || (c.period <= 0 && index > 0) ) return false;
+    qint64 v = c.init + qint64(index) * c.step;
+    if ( c.modulo > 0 ) v = ((v % c.modulo) + c.modulo) % c.modulo;
+    time = int(t);
+    value = int(v);
+    break;
+    }
+  case Stimulus::RandomValues: {
+    const RandomValues_stim& r = stim->desc.randomValues;
+    qint64 t = r.start_time + qint64(index) * r.period;
+    if ( t > r.end_time || (r.period <= 0 && index > 0) ) return false;
+    time = int(t);
+    value = random(r.min, qMax(r.min, r.max));
+    break;
+    }
+  case Stimulus::Repeat: {
+    const Repeat_stim& r = stim->desc.repeat;
+    int n = r.pattern.length();
+    if ( n == 0 || index / n >= r.count ) return false;
+    time = int(qint64(index / n) * r.period + r.pattern.at(index % n).first);
+    value = r.pattern.at(index % n).second;
+    break;
+    }
+  }
+  index++;
+  return true;
+}
+
+void StimulusCursor::skip(int time)
+{
+  switch ( stim->kind ) {
+  case Stimulus::File:
+    fileReader()->seek(time);
+    break;
+  case Stimulus::None:
+    break;
+  case Stimulus::Periodic: {
+    const Periodic_stim& p = stim->desc.periodic;
+    if ( time < p.start_time ) index = 0;
+    else if ( p.period <= 0 ) index = 1;
+    else index = (time - p.start_time) / p.period + 1;
+    break;
+    }
+  case Stimulus::Sporadic: {
+    const QList<int>& dates = stim->desc.sporadic.dates;
+    index = std::upper_bound(dates.begin(), dates.end(), time) - dates.begin();
+    break;
+    }
+  case Stimulus::ValueChanges: {
+    const QList<QPair<int,int>>& vcs = stim->desc.valueChanges.vcs;
+    index = std::upper_bound(vcs.begin(), vcs.end(), time,
+                             [](int t, const QPair<int,int>& vc) { return t < vc.first; }) - vcs.begin();
+    break;
+    }
+  case Stimulus::Bursty: {
+    const Bursty_stim& b = stim->desc.bursty;
+    int length = qMax(1, b.length);
+    if ( time < b.start_time ) index = 0;
+    else if ( b.period <= 0 || b.gap <= 0 ) index = length;
+    else {
+      qint64 k = (qint64(time) - b.start_time) / b.period;
+      qint64 o = (qint64(time) - b.start_time) % b.period;
+      index = int(k * length + qMin(qint64(length), o / b.gap + 1));
+      }
+    break;
+    }
+  case Stimulus::Counter: {
+    const Counter_stim& c = stim->desc.counter;
+    if ( time < c.start_time ) index = 0;
+    else if ( c.period <= 0 ) index = 1;
+    else index = (time - c.start_time) / c.period + 1;
+    break;
+    }
+  case Stimulus::Repeat: {
+    const Repeat_stim& r = stim->desc.repeat;
+    int n = r.pattern.length();
+    if ( time < 0 || n == 0 ) index = 0;
+    else if ( r.period <= 0 ) index = n * r.count;
+    else {
+      qint64 k = qMin(qint64(time / r.period), qint64(r.count));
+      int o = time - int(k * r.period);
+      int j = k < r.count ? std::upper_bound(r.pattern.begin(), r.pattern.end(), o,
+                                             [](int t, const QPair<int,int>& p) { return t < p.first; }) - r.pattern.begin() : 0;
+      index = int(k * n + j);
+      }
+    break;
+    }
+  default: {
+    // Random generators: the occurrences before [time] must be drawn again
+    rewind();
+    int t, v;
+    while ( true ) {
+      StimulusCursor saved = *this;
+      if ( ! next(t, v) ) break;
+      if ( t > time ) {
+        *this = saved;
+        break;
+        }
+      }
+    break;
+    }
+  }
+}
+
 QString Stimulus::toString() const
 {
   QString r;
@@ -91,6 +455,39 @@ QString Stimulus::toString() const
       r += " " + QString::number(vc.second);
       }
     break;
+  case Random:
+    r = "Random";
+    foreach ( int p, QList<int>({ desc.random.seed, desc.random.min_gap, desc.random.max_gap, desc.random.start_time, desc.random.end_time }) )
+      r += " " + QString::number(p);
+    break;
+  case Poisson:
+    r = "Poisson";
+    foreach ( int p, QList<int>({ desc.poisson.seed, desc.poisson.mean_gap, desc.poisson.start_time, desc.poisson.end_time }) )
+      r += " " + QString::number(p);
+    break;
+  case Bursty:
+    r = "Bursty";
+    foreach ( int p, QList<int>({ desc.bursty.period, desc.bursty.length, desc.bursty.gap, desc.bursty.start_time, desc.bursty.end_time }) )
+      r += " " + QString::number(p);
+    break;
+  case Counter:
+    r = "Counter";
+    foreach ( int p, QList<int>({ desc.counter.period, desc.counter.start_time, desc.counter.end_time, desc.counter.init, desc.counter.step, desc.counter.modulo }) )
+      r += " " + QString::number(p);
+    break;
+  case RandomValues:
+    r = "RandomValues";
+    foreach ( int p, QList<int>({ desc.randomValues.seed, desc.randomValues.period, desc.randomValues.start_time, desc.randomValues.end_time, desc.randomValues.min, desc.randomValues.max }) )
+      r += " " + QString::number(p);
+    break;
+  case Repeat:
+    r = "Repeat " + QString::number(desc.repeat.period) + " " + QString::number(desc.repeat.count);
+    for ( const QPair<int,int>& p: desc.repeat.pattern )
+      r += " " + QString::number(p.first) + (desc.repeat.valued ? ":" + QString::number(p.second) : "");
+    break;
+  case File:
+    r = "File " + QString(desc.file.events ? "events" : "values") + " " + desc.file.signal + " " + desc.file.fileName;
+    break;
   }
   return r;
 }
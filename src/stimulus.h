@@ -13,6 +13,9 @@
 #pragma once
 
 #include <QList>
+#include <QPair>
+#include <QString>
+#include <QSharedPointer>
 
 struct Periodic_stim
 {
@@ -37,22 +40,133 @@ struct ValueChanges_stim
   QList<QPair<int,int>> vcs;
 };
 
+// Generators. Their occurrences are computed when enumerated (see [StimulusCursor]) and only their
+// parameters are stored. Random generators are reproducible (same seed, same occurrences)
+
+struct Random_stim  // Events separated by random gaps in [min_gap,max_gap]
+{
+  Random_stim() : seed(0), min_gap(1), max_gap(1), start_time(0), end_time(0) { };
+  int seed;
+  int min_gap;
+  int max_gap;
+  int start_time;
+  int end_time;
+};
+
+struct Poisson_stim  // Events separated by exponentially distributed gaps (at least 1)
+{
+  Poisson_stim() : seed(0), mean_gap(1), start_time(0), end_time(0) { };
+  int seed;
+  int mean_gap;
+  int start_time;
+  int end_time;
+};
+
+struct Bursty_stim  // Every [period], a burst of [length] events separated by [gap]
+{
+  Bursty_stim() : period(0), length(1), gap(1), start_time(0), end_time(0) { };
+  int period;
+  int length;
+  int gap;
+  int start_time;
+  int end_time;
+};
+
+struct Counter_stim  // Every [period], a value change to [init], [init]+[step], ... (modulo [modulo] if >0)
+{
+  Counter_stim() : period(0), start_time(0), end_time(0), init(0), step(1), modulo(0) { };
+  int period;
+  int start_time;
+  int end_time;
+  int init;
+  int step;
+  int modulo;
+};
+
+struct RandomValues_stim  // Every [period], a value change to a random value in [min,max]
+{
+  RandomValues_stim() : seed(0), period(0), start_time(0), end_time(0), min(0), max(1) { };
+  int seed;
+  int period;
+  int start_time;
+  int end_time;
+  int min;
+  int max;
+};
+
+struct Repeat_stim  // [count] repetitions of a pattern of dates (relative to the start of each repetition), every [period]
+{
+  Repeat_stim() : period(0), count(0), valued(false) { };
+  int period;
+  int count;
+  bool valued;  // Pattern of value changes (date:value) instead of events
+  QList<QPair<int,int>> pattern;
+};
+
+struct File_stim  // Occurrences read from a CSV or VCD file (see [StimulusReader])
+{
+  File_stim() : events(true) { };
+  File_stim(QString f, QString s, bool e) : fileName(f), signal(s), events(e) { };
+  QString fileName; // Relative to [Stimulus::baseDir]
+  QString signal;   // CSV column or VCD signal path
+  bool events;      // Only non-zero values are kept, as events
+};
+
+class StimulusReader;
+
 class Stimulus
 {
 public:
-  enum Kind { None=0, Periodic, Sporadic, ValueChanges };
+  enum Kind { None=0, Periodic, Sporadic, ValueChanges, Random, Poisson, Bursty, Counter, RandomValues, Repeat, File };
   Kind kind;
   struct Desc {  // TO FIX: this should really be a _union_ 
       Periodic_stim periodic;
       Sporadic_stim sporadic;  
       ValueChanges_stim valueChanges;
+      Random_stim random;
+      Poisson_stim poisson;
+      Bursty_stim bursty;
+      Counter_stim counter;
+      RandomValues_stim randomValues;
+      Repeat_stim repeat;
+      File_stim file;
       };
   Desc desc;
 
-  Stimulus(Kind kind, QList<int> params=QList<int>());
+  Stimulus(Kind kind, QList<int> params=QList<int>(), bool valued=false); // [valued] is only used for [Repeat]
   Stimulus(QString s);
+  Stimulus(File_stim file);
   ~Stimulus() {};
 
   QString toString() const ;
+  bool hasValues() const; // Value changes (for int and bool inputs) rather than events
+  static bool isGenerator(Kind kind) { return kind >= Random && kind <= Repeat; }
+  static QString baseDir; // Directory of the model, for relative file names
+  QString filePath() const; // For [File]
+  // Checks the textual form of a stimulus for an event (or valued) input. Returns an error message, or ""
+  static QString check(QString s, bool forEvent);
+};
+
+// Enumerates the occurrences of a stimulus, by increasing dates, without expanding it.
+// For events, the associated value is always 1. File-backed stimuli are read when enumerated; the
+// copies of a cursor share the same reader
+
+class StimulusCursor
+{
+public:
+  StimulusCursor(const Stimulus& stim);
+  bool next(int& time, int& value); // Returns false when exhausted
+  void skip(int time);               // Moves to the first occurrence after [time]
+
+private:
+  const Stimulus *stim;
+  int index;    // Rank of the next occurrence
+  int last;     // Date of the previous occurrence (random generators)
+  quint64 rng;  // State of the random generators
+  QSharedPointer<StimulusReader> reader; // For file-backed stimuli, opened on first use
+
+  int random(int lo, int hi); // Uniform in [lo,hi]
+  StimulusReader* fileReader();
+  void rewind();
 };
 
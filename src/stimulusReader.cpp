@@ -0,0 +1,223 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+
+#include "stimulusReader.h"
+#include "vcdIndex.h"
+
+const qint64 StimulusReader::linearSeek = 1 << 16;
+
+StimulusReader::StimulusReader(QString fileName, QString signal, bool events)
+  : events(events), bodyStart(0), column(-1), now(0), nextToken(0), inComment(false),
+    hasPending(false), pendingTime(0), pendingVal(0)
+{
+  format = fileName.endsWith(".vcd", Qt::CaseInsensitive) ? Vcd : Csv;
+  file.setFileName(fileName);
+  if ( ! file.open(QIODevice::ReadOnly) ) {
+    error = "cannot open file " + fileName;
+    return;
+    }
+  if ( format == Vcd ? openVcd(signal) : openCsv(signal) ) reset(bodyStart);
+}
+
+bool StimulusReader::openCsv(QString signal)
+{
+  QList<QByteArray> names = file.readLine().trimmed().split(',');
+  for ( int i=1; i<names.length(); i++ ) {
+    QByteArray n = names.at(i).trimmed();
+    if ( n.startsWith('"') && n.endsWith('"') ) n = n.mid(1, n.length()-2);
+    if ( QString::fromUtf8(n) == signal ) column = i;
+    }
+  if ( column < 0 ) {
+    error = "no column named " + signal + " in file " + file.fileName();
+    return false;
+    }
+  bodyStart = file.pos();
+  return true;
+}
+
+bool StimulusReader::openVcd(QString signal)
+{
+  VcdIndex index; // Only for reading the declarations
+  if ( ! index.open(file.fileName()) ) {
+    error = index.getError();
+    return false;
+    }
+  int k = index.find(signal);
+  if ( k < 0 || index.getSignals().at(k).kind == VcdIndex::String ) {
+    error = (k < 0 ? "no signal " : "string signal ") + signal + " in file " + file.fileName();
+    return false;
+    }
+  code = index.getSignals().at(k).code;
+  bodyStart = index.getBodyStart();
+  return true;
+}
+
+void StimulusReader::reset(qint64 pos)
+{
+  file.seek(pos);
+  now = 0;
+  tokens.clear();
+  nextToken = 0;
+  pendingValue.clear();
+  inComment = false;
+  hasPending = false;
+}
+
+// Values, as written in a CSV cell or a VCD value change. Returns false for unknown values
+
+bool StimulusReader::parseValue(const QByteArray& text, int& value) const
+{
+  bool ok;
+  if ( format == Csv ) {
+    value = int(text.toLongLong(&ok));
+    if ( ! ok ) value = int(text.toDouble(&ok));
+    return ok;
+    }
+  switch ( text.at(0) ) {
+  case '0': value = 0; return true;
+  case '1': value = 1; return true;
+  case 'b': case 'B': {
+    quint64 v = 0;
+    for ( int i=1; i<text.length(); i++ ) {
+      if ( text.at(i) != '0' && text.at(i) != '1' ) return false;
+      v = (v << 1) | (text.at(i) == '1');
+      }
+    value = int(v);
+    return true;
+    }
+  case 'r': case 'R':
+    value = int(text.mid(1).toDouble(&ok));
+    return ok;
+  default:
+    return false; // x, z
+  }
+}
+
+bool StimulusReader::readOccurrence(int& time, int& value)
+{
+  while ( true ) {
+    if ( format == Csv ) {
+      QByteArray line = file.readLine();
+      if ( line.isEmpty() ) return false;
+      QList<QByteArray> cells = line.trimmed().split(',');
+      bool ok;
+      qint64 t = cells.at(0).trimmed().toLongLong(&ok);
+      if ( ! ok || column >= cells.length() ) continue;
+      QByteArray cell = cells.at(column).trimmed();
+      if ( cell.isEmpty() || ! parseValue(cell, value) ) continue;
+      now = t;
+      }
+    else {
+      if ( nextToken >= tokens.length() ) {
+        QByteArray line = file.readLine();
+        if ( line.isEmpty() ) return false;
+        tokens = line.simplified().split(' ');
+        nextToken = 0;
+        }
+      QByteArray tok = tokens.at(nextToken++);
+      if ( tok.isEmpty() ) continue;
+      if ( inComment ) {
+        inComment = tok != "$end";
+        continue;
+        }
+      QByteArray id, text;
+      switch ( tok.at(0) ) {
+      case '$':
+        inComment = tok == "$comment";
+        continue;
+      case '#':
+        now = tok.mid(1).toLongLong();
+        continue;
+      case 'b': case 'B': case 'r': case 'R': case 's': case 'S':
+        pendingValue = tok;
+        continue;
+      default:
+        if ( ! pendingValue.isEmpty() ) {
+          id = tok;
+          text = pendingValue;
+          pendingValue.clear();
+          }
+        else {
+          id = tok.mid(1);
+          text = tok.left(1);
+          }
+      }
+      if ( id != code || ! parseValue(text, value) ) continue;
+      }
+    if ( events ) {
+      if ( value == 0 ) continue;
+      value = 1;
+      }
+    time = int(now);
+    return true;
+    }
+}
+
+bool StimulusReader::next(int& time, int& value)
+{
+  if ( ! isOpen() ) return false;
+  if ( hasPending ) {
+    hasPending = false;
+    time = pendingTime;
+    value = pendingVal;
+    return true;
+    }
+  return readOccurrence(time, value);
+}
+
+// Offset of the first line starting after [pos] which gives a date (CSV row or VCD "#<date>"), and this date
+
+qint64 StimulusReader::dateAfter(qint64 pos, qint64& start)
+{
+  file.seek(pos);
+  if ( pos > bodyStart ) file.readLine(); // Partial line
+  while ( true ) {
+    start = file.pos();
+    QByteArray line = file.readLine();
+    if ( line.isEmpty() ) return -1;
+    bool ok;
+    qint64 t = format == Csv ? line.left(line.indexOf(',')).trimmed().toLongLong(&ok) : 0;
+    if ( format == Vcd ) {
+      ok = line.startsWith('#');
+      if ( ok ) t = line.mid(1).trimmed().toLongLong(&ok);
+      }
+    if ( ok ) return t;
+    }
+}
+
+void StimulusReader::seek(int time)
+{
+  if ( ! isOpen() ) return;
+  // Last date line at or before [time], by dichotomy
+  qint64 lo = bodyStart, hi = file.size(), from = bodyStart;
+  while ( hi - lo > linearSeek ) {
+    qint64 mid = lo + (hi - lo) / 2, start;
+    qint64 t = dateAfter(mid, start);
+    if ( t >= 0 && t <= time ) {
+      lo = mid;
+      from = start;
+      }
+    else
+      hi = mid;
+    }
+  // Then sequentially
+  reset(from);
+  int t, v;
+  while ( readOccurrence(t, v) ) {
+    if ( t <= time ) continue;
+    hasPending = true;
+    pendingTime = t;
+    pendingVal = v;
+    break;
+    }
+}
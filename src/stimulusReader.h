@@ -0,0 +1,70 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+
+// Streaming reader of the occurrences of a signal recorded in a CSV or VCD file (see [Stimulus::File]).
+//
+// CSV files start with a header line giving the column names, the first column holding the dates.
+// Each row gives the value of the signal at its date (empty cells are ignored).
+// In VCD files, the signal is designated by its path ("scope.name") and each change gives an
+// occurrence. For event inputs, only the occurrences with a non-zero value are kept (occurrences of
+// event variables, rising edges of scalar signals, ..) and their value is 1. Unknown values are
+// ignored. Dates must be increasing.
+//
+// The file is read line by line, so that the memory used does not depend on its length. [seek]
+// locates a date by dichotomy on file offsets, without reading what precedes it.
+
+class StimulusReader
+{
+public:
+  StimulusReader(QString fileName, QString signal, bool events);
+
+  bool isOpen() const { return error.isEmpty(); }
+  QString getError() const { return error; }
+
+  bool next(int& time, int& value); // Returns false at the end of the file
+  void seek(int time);               // Moves to the first occurrence after [time]
+
+private:
+  enum Format { Csv, Vcd };
+  QFile file;
+  Format format;
+  bool events;
+  QString error;
+  qint64 bodyStart;   // Offset of the first row (CSV) or value change (VCD)
+  int column;         // CSV
+  QByteArray code;    // VCD identifier of the signal
+  qint64 now;         // Current date
+  QList<QByteArray> tokens; // VCD line being read
+  int nextToken;
+  QByteArray pendingValue; // VCD vector or real value, waiting for its identifier
+  bool inComment;
+  bool hasPending;    // An occurrence has been read ahead by [seek]
+  int pendingTime;
+  int pendingVal;
+
+  static const qint64 linearSeek; // Below this distance, [seek] reads the file
+
+  bool openCsv(QString signal);
+  bool openVcd(QString signal);
+  void reset(qint64 pos);
+  bool readOccurrence(int& time, int& value);
+  bool parseValue(const QByteArray& text, int& value) const;
+  qint64 dateAfter(qint64 pos, qint64& start); // First date starting after [pos] (and its offset), -1 if none
+};
@@ -0,0 +1,306 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "sweepRunner.h"
+#include "simulator.h"
+#include "slicedSimulator.h"
+#include "stimulus.h"
+#include "model.h"
+#include "iov.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QThread>
+#include <QVector>
+#include <QHash>
+#include <QRegularExpression>
+#include <QAtomicInt>
+#include <QDebug>
+#include "qt_compat.h"
+
+const int SweepRunner::maxRuns = 10000;
+
+SweepRunner::SweepRunner(Model *model, bool synchronousActions, int size)
+{
+  this->model = model;
+  this->synchronousActions = synchronousActions;
+  this->size = size > 0 ? size : qMax(1, QThread::idealThreadCount());
+  this->vcdIntSize = 8;
+  this->vcdCompressed = false;
+  this->sliced = false;
+}
+
+void SweepRunner::setCompiled(QString cacheDir, QString compiler)
+{
+  this->cacheDir = cacheDir;
+  this->compiler = compiler;
+}
+
+void SweepRunner::setTrace(int vcdIntSize, bool vcdCompressed)
+{
+  this->vcdIntSize = vcdIntSize;
+  this->vcdCompressed = vcdCompressed;
+}
+
+// Sweep files
+
+// Expands the lists of alternatives occuring in [text]. Returns an error message, or "" if OK
+
+QString SweepRunner::expand(QString text, QStringList& stims)
+{
+  static const QRegularExpression re_tok("\\{[^}]*\\}|\\S+");
+  QList<QStringList> tokens; // Alternatives for each token
+  QRegularExpressionMatchIterator it = re_tok.globalMatch(text);
+  while ( it.hasNext() ) {
+    QString t = it.next().captured(0);
+    if ( ! t.startsWith('{') ) {
+      tokens.append(QStringList(t));
+      continue;
+      }
+    QStringList alts;
+    foreach ( QString item, t.mid(1, t.length()-2).split(',') ) {
+      QString range = item.section(':', 0, 0).trimmed();
+      QString step = item.section(':', 1).trimmed();
+      bool ok1, ok2 = true, ok3 = true;
+      int lo = range.section("..", 0, 0).toInt(&ok1);
+      int hi = lo, s = 1;
+      if ( range.contains("..") ) hi = range.section("..", 1).toInt(&ok2);
+      if ( ! step.isEmpty() ) s = step.toInt(&ok3);
+      if ( ! ok1 || ! ok2 || ! ok3 || s <= 0 || hi < lo ) return "invalid list of values " + t;
+      for ( qint64 v=lo; v<=hi; v+=s ) {
+        if ( alts.length() >= maxRuns ) return "too many values in " + t;
+        alts.append(QString::number(v));
+        }
+      }
+    tokens.append(alts);
+    }
+  if ( tokens.isEmpty() ) return "empty stimulus";
+  QStringList r = { "" };
+  foreach ( const QStringList& alts, tokens ) {
+    if ( qint64(r.length()) * alts.length() > maxRuns ) return "too many variants";
+    QStringList next;
+    foreach ( QString prefix, r )
+      foreach ( QString a, alts ) next.append(prefix.isEmpty() ? a : prefix + " " + a);
+    r = next;
+    }
+  stims.append(r);
+  return "";
+}
+
+// Checks a stimulus before building it (the [Stimulus] constructor assumes a well-formed description)
+
+QString SweepRunner::check(const Iov *io, QString stim)
+{
+  QString err = Stimulus::check(stim, io->type == Iov::TyEvent);
+  return err.isEmpty() ? "" : err + " (input " + io->name + ")";
+}
+
+bool SweepRunner::parse(QString fname, QList<Run>& runs)
+{
+  QFile file(fname);
+  if ( ! file.open(QIODevice::ReadOnly | QIODevice::Text) ) {
+    errors << "cannot open file " + fname;
+    return false;
+    }
+  QList<QPair<QString,QStringList>> lines; // Input, alternatives
+  QTextStream is(&file);
+  bool ok = true;
+  for ( int n=1; ! is.atEnd(); n++ ) {
+    QString line = is.readLine().trimmed();
+    if ( line.isEmpty() || line.startsWith('#') ) continue;
+    QString where = QFileInfo(fname).fileName() + ", line " + QString::number(n) + ": ";
+    int k = line.indexOf(':');
+    QString name = line.left(k).trimmed();
+    const Iov *io = NULL;
+    foreach ( const Iov *i, model->getIos() )
+      if ( i->name == name && i->kind == Iov::IoIn ) io = i;
+    if ( k < 0 || ! io ) {
+      errors << where + (k < 0 ? "\":\" expected" : "no input named \"" + name + "\"");
+      ok = false;
+      continue;
+      }
+    QStringList alts;
+    foreach ( QString s, line.mid(k+1).split('|') ) {
+      QStringList stims;
+      QString err = expand(s.simplified(), stims);
+      foreach ( QString stim, stims ) {
+        if ( ! err.isEmpty() ) break;
+        err = check(io, stim);
+        }
+      if ( ! err.isEmpty() ) {
+        errors << where + err;
+        ok = false;
+        break;
+        }
+      alts.append(stims);
+      }
+    lines.append(QPair<QString,QStringList>(name, alts));
+    }
+  if ( ! ok ) return false;
+  // Cartesian product, the last line varying first
+  qint64 nb = 1;
+  foreach ( const auto& l, lines ) {
+    nb *= l.second.length(); // At most maxRuns * INT_MAX: no overflow
+    if ( nb > maxRuns - runs.length() ) {
+      errors << fname + ": too many variants (max " + QString::number(maxRuns) + ")";
+      return false;
+      }
+    }
+  QString base = QFileInfo(fname).completeBaseName();
+  for ( int i=0; i<nb; i++ ) {
+    Run r;
+    r.name = nb == 1 ? base : base + "_" + QString::number(i+1);
+    int k = i;
+    for ( int j=lines.length()-1; j>=0; j-- ) {
+      const QStringList& alts = lines.at(j).second;
+      r.stimuli.prepend(QPair<QString,QString>(lines.at(j).first, alts.at(k % alts.length())));
+      k /= alts.length();
+      }
+    runs.append(r);
+    }
+  return true;
+}
+
+// Execution
+
+namespace {
+  class SweepWorker : public QThread {
+  public:
+    SweepWorker(std::function<void()> body) : body(body) { }
+  protected:
+    void run() override { body(); }
+  private:
+    std::function<void()> body;
+  };
+}
+
+void SweepRunner::runOne(Run& r, QString dir, ModelTables *tables)
+{
+  Simulator sim(model, synchronousActions);
+  sim.setTables(tables);
+  if ( ! compiler.isEmpty() ) sim.setCompiled(cacheDir, compiler);
+  QHash<QString,Stimulus> stimuli;
+  foreach ( const auto& s, r.stimuli ) stimuli.insert(s.first, Stimulus(s.second));
+  sim.setStimuli(stimuli);
+  QString top = model->getName().isEmpty() ? "main" : model->getName();
+  r.vcdFile = dir + "/" + top + "_" + r.name + (vcdCompressed ? ".vcd.gz" : ".vcd");
+  r.ok = sim.run(r.vcdFile, vcdIntSize, vcdCompressed);
+  r.done = true;
+  r.errors = sim.getErrors();
+  r.nbTransitions = sim.getNbTransitions();
+  r.endTime = sim.getEndTime();
+  r.finalValues = sim.getFinalValues();
+}
+
+void SweepRunner::runSliced(const QVector<Run*>& group, ModelTables *tables)
+{
+  SlicedSimulator sim(tables);
+  QList<QHash<QString,Stimulus>> stimuli;
+  foreach ( const Run *r, group ) {
+    QHash<QString,Stimulus> s;
+    foreach ( const auto& st, r->stimuli ) s.insert(st.first, Stimulus(st.second));
+    stimuli.append(s);
+    }
+  bool ok = sim.run(stimuli);
+  for ( int l=0; l<group.size(); l++ ) {
+    Run& r = *group.at(l);
+    r.done = true;
+    if ( ! ok ) {
+      r.errors = sim.getErrors();
+      continue;
+      }
+    r.ok = sim.isOk(l);
+    r.errors = sim.getErrors(l);
+    r.nbTransitions = sim.getNbTransitions(l);
+    r.endTime = sim.getEndTime(l);
+    r.finalValues = sim.getFinalValues(l);
+    }
+}
+
+// Returns false if the model could not be simulated or if the sweep has been aborted.
+// Errors occuring in individual runs are stored in these runs
+
+bool SweepRunner::run(QList<Run>& runs, QString dir, std::function<bool(int)> progress)
+{
+  errors.clear();
+  warning = "";
+  // The model is lowered (and compiled) once, by the calling thread. Runs share the tables and the cached library
+  Simulator sim(model, synchronousActions);
+  if ( ! compiler.isEmpty() ) sim.setCompiled(cacheDir, compiler);
+  if ( ! sim.build() ) {
+    errors = sim.getErrors();
+    return false;
+    }
+  QVector<Run*> all; // Runs are accessed concurrently (no detach)
+  for ( Run& r : runs ) all.append(&r);
+  // In bit-sliced mode, each job is a group of runs simulated at once
+  int groupSize = 1;
+  if ( sliced ) {
+    QString why;
+    if ( SlicedSimulator::supports(sim.getTables(), why) ) groupSize = SlicedSimulator::nbLanes;
+    else warning = "bit-sliced simulation not available (" + why + "); runs are simulated one at a time";
+    }
+  QVector<QVector<Run*>> jobs;
+  for ( int i=0; i<all.size(); i+=groupSize ) jobs.append(all.mid(i, groupSize));
+  QAtomicInt next(0), done(0), abort(0);
+  auto body = [&]() {
+    int i;
+    while ( (i = next.fetchAndAddOrdered(1)) < jobs.size() ) {
+      if ( abort.loadAcquire() ) return;
+      const QVector<Run*>& job = jobs.at(i);
+      if ( groupSize > 1 ) runSliced(job, sim.getTables());
+      else runOne(*job.first(), dir, sim.getTables());
+      done.fetchAndAddOrdered(job.size());
+      }
+  };
+  QList<SweepWorker*> workers;
+  for ( int k=0; k<qMin(size, jobs.size()); k++ ) {
+    workers.append(new SweepWorker(body));
+    workers.last()->start();
+    }
+  qDebug() << "SweepRunner::run:" << all.size() << "runs," << jobs.size() << "jobs," << workers.length() << "workers";
+  foreach ( SweepWorker *w, workers )
+    while ( ! w->wait(100) )
+      if ( progress && ! progress(done.loadAcquire()) ) abort.storeRelease(1); // Started runs are completed
+  qDeleteAll(workers);
+  return ! abort.loadAcquire();
+}
+
+// Summary, as a CSV table with one row per run
+
+bool SweepRunner::writeSummary(QString fname, const QList<Run>& runs)
+{
+  QFile file(fname);
+  if ( ! file.open(QIODevice::WriteOnly | QIODevice::Text) ) {
+    errors << "cannot write file " + fname;
+    return false;
+    }
+  QTextStream os(&file);
+  QStringList header = { "run", "status", "transitions", "end time" };
+  QList<QPair<QString,int>> values;
+  foreach ( const Run& r, runs )
+    if ( r.ok || ! r.finalValues.isEmpty() ) { values = r.finalValues; break; }
+  for ( const auto& v : values ) header << v.first;
+  header << "stimuli" << "errors";
+  os << header.join(",") << QT_ENDL;
+  foreach ( const Run& r, runs ) {
+    QStringList row = { r.name, r.ok ? "ok" : r.done ? "error" : "not run",
+                        QString::number(r.nbTransitions), QString::number(r.endTime) };
+    for ( int i=0; i<values.length(); i++ )
+      row << (i < r.finalValues.length() ? QString::number(r.finalValues.at(i).second) : "");
+    QStringList stims;
+    for ( const auto& s : r.stimuli ) stims << s.first + ": " + s.second;
+    row << "\"" + stims.join("; ") + "\"" << "\"" + r.errors.join("; ").replace('"', '\'') + "\"";
+    os << row.join(",") << QT_ENDL;
+    }
+  return true;
+}
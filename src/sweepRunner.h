@@ -0,0 +1,93 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QPair>
+#include <QVector>
+#include <functional>
+
+class Model;
+class Iov;
+class ModelTables;
+
+// Runs a set of simulations of a model with the built-in simulator, each with its own variant of the
+// input stimuli. At most [size] runs are executed at the same time (by default, the number of cores).
+// Each run writes its own VCD trace; transition counts and final values of outputs and shared
+// variables are stored in the runs, and can be written as a summary table (see [writeSummary]).
+//
+// Variants are described by sweep files. Each line of a sweep file gives the stimuli of an input
+//   <input> : <stimulus> | ... | <stimulus>
+// where <stimulus> has the textual form of a [Stimulus] (ex: "Periodic 10 0 100"). An integer parameter
+// can be replaced by a list of alternatives, written "{a,b,c}", "{lo..hi}" or "{lo..hi:step}".
+// A file describes the cartesian product of the alternatives of its lines (a single variant if there is
+// none). Inputs which are not mentioned keep the stimulus given in the model. Lines starting with '#'
+// are comments.
+//
+// In bit-sliced mode (see [setSliced]), runs are grouped by [SlicedSimulator::nbLanes] and each group is
+// simulated at once by a [SlicedSimulator], without writing traces. This only applies to models with
+// boolean values; other models are simulated one run at a time (see [getWarning]).
+
+class SweepRunner
+{
+public:
+  struct Run {
+    Run() : ok(false), done(false), nbTransitions(0), endTime(0) { };
+    QString name;
+    QList<QPair<QString,QString>> stimuli;   // Input, stimulus
+    // Results
+    bool ok;
+    bool done;  // Simulated (possibly with errors)
+    QStringList errors;
+    int nbTransitions;
+    int endTime;
+    QList<QPair<QString,int>> finalValues;
+    QString vcdFile;  // Empty in bit-sliced mode
+  };
+
+  SweepRunner(Model *model, bool synchronousActions = false, int size = 0);
+
+  void setCompiled(QString cacheDir, QString compiler);
+  void setTrace(int vcdIntSize, bool vcdCompressed);
+  void setSliced(bool sliced) { this->sliced = sliced; }
+  int getSize() const { return size; }
+
+  bool parse(QString fname, QList<Run>& runs); // Appends the variants described in file [fname]
+  // [progress] is called periodically by the calling thread with the number of completed runs;
+  // the sweep is aborted when it returns false
+  bool run(QList<Run>& runs, QString dir, std::function<bool(int)> progress = nullptr);
+  bool writeSummary(QString fname, const QList<Run>& runs);
+  QStringList getErrors() const { return errors; }
+  QString getWarning() const { return warning; } // Set by [run] when the bit-sliced mode could not be used
+
+  static const int maxRuns;
+
+private:
+  Model *model;
+  bool synchronousActions;
+  int size;
+  QString cacheDir;        // In compiled mode
+  QString compiler;        // Idem
+  int vcdIntSize;
+  bool vcdCompressed;
+  bool sliced;
+  QStringList errors;
+  QString warning;
+
+  QString expand(QString text, QStringList& stims);
+  QString check(const Iov *io, QString stim);
+  void runOne(Run& r, QString dir, ModelTables *tables);
+  void runSliced(const QVector<Run*>& group, ModelTables *tables);
+};
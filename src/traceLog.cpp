@@ -0,0 +1,211 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "traceLog.h"
+#include <QThread>
+#include <QDataStream>
+#include <string.h>
+
+const quint32 TraceLog::magic = 0x474C4F47; // "GLOG"
+const quint32 TraceLog::version = 1;
+const int TraceLog::ringSize = 1 << 20;    // Must be a power of 2
+
+namespace {
+  class TraceLogWriter : public QThread {
+  public:
+    TraceLogWriter(std::function<void()> body) : body(body) { }
+  protected:
+    void run() override { body(); }
+  private:
+    std::function<void()> body;
+  };
+}
+
+QDataStream& operator<<(QDataStream& os, const TraceLog::Fsm& f)
+{
+  return os << f.name << f.states << f.transitions << f.labels;
+}
+
+QDataStream& operator>>(QDataStream& is, TraceLog::Fsm& f)
+{
+  return is >> f.name >> f.states >> f.transitions >> f.labels;
+}
+
+TraceLog::TraceLog()
+{
+  writer = NULL;
+  buf = NULL;
+  ok = true;
+  time = 0;
+}
+
+TraceLog::~TraceLog()
+{
+  close();
+}
+
+QString TraceLog::fileName(QString vcdFile)
+{
+  QString base = vcdFile;
+  if ( base.endsWith(".gz") ) base.chop(3);
+  if ( base.endsWith(".vcd") ) base.chop(4);
+  return base + ".glog";
+}
+
+bool TraceLog::open(QString fname, const Header& header)
+{
+  file.setFileName(fname);
+  if ( ! file.open(QIODevice::WriteOnly) ) return false;
+  QDataStream os(&file);
+  os << magic << version << header.top << header.ioNames << header.ioKinds << header.ioTypes << header.fsms;
+  if ( os.status() != QDataStream::Ok ) return false;
+  ring = QByteArray(ringSize, 0);
+  buf = ring.data();
+  head.storeRelease(0);
+  tail.storeRelease(0);
+  closing.storeRelease(0);
+  ok = true;
+  time = 0;
+  writer = new TraceLogWriter([this]() { drain(); });
+  writer->start();
+  return true;
+}
+
+// Encoding
+
+void TraceLog::put(quint64 n)
+{
+  while ( n >= 0x80 ) {
+    record.append(char((n & 0x7f) | 0x80));
+    n >>= 7;
+    }
+  record.append(char(n));
+}
+
+void TraceLog::putValue(int v)
+{
+  put((quint32(v) << 1) ^ quint32(v >> 31));
+}
+
+// Single producer, single consumer: only the producer moves [head] and only the writer moves [tail].
+// When the ring is full, the producer waits for the writer
+
+void TraceLog::flush()
+{
+  const char *data = record.constData();
+  quint32 n = record.size();
+  while ( n > 0 ) {
+    quint32 h = head.loadAcquire();
+    quint32 room = ringSize - (h - tail.loadAcquire());
+    if ( room == 0 ) {
+      QThread::yieldCurrentThread();
+      continue;
+      }
+    quint32 k = qMin(qMin(n, room), quint32(ringSize) - (h & (ringSize-1)));
+    memcpy(buf + (h & (ringSize-1)), data, k);
+    head.storeRelease(h + k);
+    data += k;
+    n -= k;
+    }
+  record.clear();
+}
+
+void TraceLog::drain()
+{
+  while ( true ) {
+    quint32 t = tail.loadAcquire();
+    quint32 h = head.loadAcquire();
+    if ( h == t ) {
+      if ( closing.loadAcquire() && head.loadAcquire() == t ) return;
+      QThread::usleep(200);
+      continue;
+      }
+    quint32 k = qMin(h - t, quint32(ringSize) - (t & (ringSize-1)));
+    if ( file.write(buf + (t & (ringSize-1)), k) != k ) ok = false;
+    tail.storeRelease(t + k);
+    }
+}
+
+// Records
+
+void TraceLog::setTime(qint64 t)
+{
+  if ( ! writer || t == time ) return;
+  tag(Time);
+  put(t - time);
+  flush();
+  time = t;
+}
+
+void TraceLog::state(const QVector<int>& states, const QVector<int>& values)
+{
+  if ( ! writer ) return;
+  tag(State);
+  foreach ( int s, states ) put(s);
+  foreach ( int v, values ) putValue(v);
+  flush();
+}
+
+void TraceLog::input(int io, int value)
+{
+  if ( ! writer ) return;
+  tag(Input);
+  put(io);
+  putValue(value);
+  flush();
+}
+
+void TraceLog::event(int io)
+{
+  if ( ! writer ) return;
+  tag(Event);
+  put(io);
+  flush();
+}
+
+void TraceLog::step()
+{
+  if ( ! writer ) return;
+  tag(Step);
+  flush();
+}
+
+void TraceLog::fire(int fsm, int transition, const QVector<QPair<int,int>>& writes, const QVector<int>& events)
+{
+  if ( ! writer ) return;
+  tag(Fire);
+  put(fsm);
+  put(transition);
+  put(writes.size());
+  for ( const auto& w : writes ) {
+    put(w.first);
+    putValue(w.second);
+    }
+  put(events.size());
+  foreach ( int e, events ) put(e);
+  flush();
+}
+
+bool TraceLog::close()
+{
+  if ( ! writer ) return ok;
+  tag(End);
+  flush();
+  closing.storeRelease(1);
+  writer->wait();
+  delete writer;
+  writer = NULL;
+  file.close();
+  ring.clear();
+  buf = NULL;
+  return ok;
+}
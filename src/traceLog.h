@@ -0,0 +1,101 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QVector>
+#include <QPair>
+#include <QByteArray>
+#include <QFile>
+#include <QAtomicInteger>
+
+class QThread;
+class QDataStream;
+
+// Compact binary log of a simulation of the built-in simulator (<trace>.glog), from which the trace can be
+// replayed without re-running the model (see [TraceReplay]).
+//
+// The file starts with a header describing the IOs and automata, followed by a sequence of records, each one
+// given by a tag byte and its arguments, as unsigned (or, for values, zigzag-encoded signed) LEB128 integers:
+//   Time dt        the next records occur [dt] time units after the previous ones
+//   State s* v*    current state of each FSM and value of each non-event IO (at the start of the log)
+//   Input io v     change of the value of input [io]
+//   Event io       occurrence of input event [io]
+//   Step           start of a micro-step
+//   Fire f t n (io v)^n m io^m
+//                  FSM [f] takes its transition [t], its actions writing [v] to output or shared variable
+//                  [io] and emitting event [io]
+//   End
+// Records are encoded by the simulation thread into a lock-free ring buffer, written to the file by a
+// separate thread.
+
+class TraceLog
+{
+public:
+  enum Tag { Time=0, State, Input, Event, Step, Fire, End };
+
+  struct Fsm {
+    QString name;
+    QStringList states;
+    QList<QPair<int,int>> transitions; // Source and target states, indexed by [FsmTable::Entry::id]
+    QStringList labels;                // Of the transitions
+  };
+  struct Header {
+    QString top;
+    QStringList ioNames;
+    QList<int> ioKinds; // Iov::IoKind
+    QList<int> ioTypes; // Iov::IoType
+    QList<Fsm> fsms;
+    int nbSignals() const { return ioNames.length() + fsms.length(); } // See [TraceReplay::replay]
+  };
+
+  TraceLog();
+  ~TraceLog();
+
+  static QString fileName(QString vcdFile); // <trace>.glog
+  static const quint32 magic;
+  static const quint32 version;
+  static const int ringSize;
+
+  bool open(QString fname, const Header& header);
+  void setTime(qint64 t);
+  void state(const QVector<int>& states, const QVector<int>& values);
+  void input(int io, int value);
+  void event(int io);
+  void step();
+  void fire(int fsm, int transition, const QVector<QPair<int,int>>& writes, const QVector<int>& events);
+  bool close(); // false if the log could not be completely written
+
+private:
+  QFile file;
+  QThread *writer;
+  QByteArray ring;
+  char *buf;                        // Data of [ring]
+  QAtomicInteger<quint32> head;     // Bytes produced (modulo 2^32)
+  QAtomicInteger<quint32> tail;     // Bytes written to the file
+  QAtomicInteger<int> closing;
+  bool ok;                          // Written by the writer thread, read after it has finished
+  qint64 time;
+  QByteArray record;                // Being encoded
+
+  void tag(Tag t) { record.append(char(t)); }
+  void put(quint64 n);              // Unsigned
+  void putValue(int v);             // Signed
+  void flush();                     // Copies [record] to the ring
+  void drain();                     // Body of the writer thread
+};
+
+QDataStream& operator<<(QDataStream& os, const TraceLog::Fsm& f);
+QDataStream& operator>>(QDataStream& is, TraceLog::Fsm& f);
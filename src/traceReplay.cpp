@@ -0,0 +1,242 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "traceReplay.h"
+#include "vcdWriter.h"
+#include "iov.h"
+#include <QDataStream>
+#include <QVector>
+
+bool TraceReplay::open(QString fname)
+{
+  this->fname = fname;
+  QFile f(fname);
+  if ( ! f.open(QIODevice::ReadOnly) ) {
+    error = "cannot open file " + fname;
+    return false;
+    }
+  QDataStream is(&f);
+  quint32 m, v;
+  is >> m >> v;
+  if ( m != TraceLog::magic || v != TraceLog::version ) {
+    error = fname + " is not a simulation log (or has been written by another version)";
+    return false;
+    }
+  header = TraceLog::Header();
+  is >> header.top >> header.ioNames >> header.ioKinds >> header.ioTypes >> header.fsms;
+  if ( is.status() != QDataStream::Ok || header.ioKinds.length() != header.ioNames.length()
+       || header.ioTypes.length() != header.ioNames.length() ) {
+    error = fname + " has an invalid header";
+    return false;
+    }
+  bodyStart = f.pos();
+  return true;
+}
+
+int TraceReplay::signalOf(QString name) const
+{
+  int i = header.ioNames.indexOf(name);
+  if ( i >= 0 ) return i;
+  for ( int k=0; k<header.fsms.length(); k++ )
+    if ( header.fsms.at(k).name == name ) return header.ioNames.length() + k;
+  return -1;
+}
+
+// Decoding
+
+bool TraceReplay::byte(quint8& b)
+{
+  if ( pos >= chunk.size() ) {
+    chunk = file.read(1 << 16);
+    pos = 0;
+    if ( chunk.isEmpty() ) return false;
+    }
+  b = quint8(chunk.at(pos++));
+  return true;
+}
+
+bool TraceReplay::get(quint64& n)
+{
+  n = 0;
+  for ( int shift=0; shift<64; shift+=7 ) {
+    quint8 b;
+    if ( ! byte(b) ) return false;
+    n |= quint64(b & 0x7f) << shift;
+    if ( ! (b & 0x80) ) return true;
+    }
+  return false;
+}
+
+bool TraceReplay::getInt(int& n)
+{
+  quint64 k;
+  if ( ! get(k) || k > 0x7fffffff ) return false;
+  n = int(k);
+  return true;
+}
+
+bool TraceReplay::getValue(int& v)
+{
+  quint64 k;
+  if ( ! get(k) || k > 0xffffffff ) return false;
+  quint32 u = quint32(k);
+  v = int((u >> 1) ^ (0u - (u & 1)));
+  return true;
+}
+
+// The firings of a micro-step are buffered, then replayed as the simulator traces them: state changes
+// first, then the writes which actually change a value, then the emitted events
+
+bool TraceReplay::replay(std::function<void(qint64,int,int)> change, std::function<void(qint64,int,int)> fire)
+{
+  struct Firing {
+    int fsm;
+    int transition;
+    QVector<QPair<int,int>> writes;
+    QVector<int> events;
+  };
+  file.setFileName(fname);
+  if ( ! file.open(QIODevice::ReadOnly) || ! file.seek(bodyStart) ) {
+    error = "cannot open file " + fname;
+    return false;
+    }
+  chunk.clear();
+  pos = 0;
+  int nbIos = header.ioNames.length();
+  int nbFsms = header.fsms.length();
+  QVector<int> values(nbIos, 0);
+  QVector<int> states(nbFsms, 0);
+  QList<Firing> firings; // Of the current micro-step
+  qint64 time = 0;
+  auto endStep = [&]() {
+    foreach ( const Firing& f, firings ) {
+      states[f.fsm] = header.fsms.at(f.fsm).transitions.at(f.transition).second;
+      change(time, nbIos + f.fsm, states.at(f.fsm));
+      if ( fire ) fire(time, f.fsm, f.transition);
+      }
+    foreach ( const Firing& f, firings )
+      for ( const auto& w : f.writes ) {
+        if ( values.at(w.first) == w.second ) continue;
+        values[w.first] = w.second;
+        change(time, w.first, w.second);
+        }
+    foreach ( const Firing& f, firings )
+      foreach ( int e, f.events ) change(time, e, 1);
+    firings.clear();
+  };
+  bool ok = true, ended = false;
+  quint8 tag;
+  while ( ok && ! ended && byte(tag) ) {
+    if ( tag != TraceLog::Fire ) endStep();
+    switch ( tag ) {
+    case TraceLog::Time: {
+      quint64 dt;
+      ok = get(dt);
+      time += dt;
+      break;
+      }
+    case TraceLog::State:
+      for ( int k=0; ok && k<nbFsms; k++ )
+        ok = getInt(states[k]) && states.at(k) < header.fsms.at(k).states.length();
+      for ( int i=0; ok && i<nbIos; i++ )
+        if ( header.ioTypes.at(i) != Iov::TyEvent && (ok = getValue(values[i])) ) change(time, i, values.at(i));
+      for ( int k=0; ok && k<nbFsms; k++ ) change(time, nbIos + k, states.at(k));
+      break;
+    case TraceLog::Input: {
+      int io, v;
+      ok = getInt(io) && io < nbIos && getValue(v);
+      if ( ok ) {
+        values[io] = v;
+        change(time, io, v);
+        }
+      break;
+      }
+    case TraceLog::Event: {
+      int io;
+      ok = getInt(io) && io < nbIos;
+      if ( ok ) change(time, io, 1);
+      break;
+      }
+    case TraceLog::Step:
+      break;
+    case TraceLog::Fire: {
+      Firing f;
+      int n;
+      ok = getInt(f.fsm) && f.fsm < nbFsms && getInt(f.transition) && f.transition < header.fsms.at(f.fsm).transitions.length();
+      if ( ok ) ok = getInt(n);
+      for ( int i=0; ok && i<n; i++ ) {
+        int io, v;
+        ok = getInt(io) && io < nbIos && getValue(v);
+        f.writes.append(QPair<int,int>(io, v));
+        }
+      if ( ok ) ok = getInt(n);
+      for ( int i=0; ok && i<n; i++ ) {
+        int io;
+        ok = getInt(io) && io < nbIos;
+        f.events.append(io);
+        }
+      firings.append(f);
+      break;
+      }
+    case TraceLog::End:
+      ended = true;
+      break;
+    default:
+      ok = false;
+    }
+  }
+  file.close();
+  if ( ! ok ) error = fname + " is corrupted";
+  else if ( ! ended ) error = fname + " is truncated";
+  return ok && ended;
+}
+
+// Rebuilding the VCD trace, with the same declarations as [Simulator::run]
+
+bool TraceReplay::toVcd(QString vcdFile, int vcdIntSize, bool vcdCompressed)
+{
+  VcdWriter vcd(vcdIntSize, vcdCompressed);
+  QVector<int> ids;
+  for ( int i=0; i<header.ioNames.length(); i++ ) {
+    int t = header.ioTypes.at(i);
+    ids.append(vcd.declare(header.top, header.ioNames.at(i), t == Iov::TyEvent ? VcdWriter::Event : t == Iov::TyBool ? VcdWriter::Bool : VcdWriter::Int));
+    }
+  foreach ( const TraceLog::Fsm& f, header.fsms ) ids.append(vcd.declare(f.name, "state", VcdWriter::String));
+  if ( ! vcd.open(vcdFile) ) {
+    error = "cannot open file " + vcdFile;
+    return false;
+    }
+  int nbIos = header.ioNames.length();
+  bool ok = replay([&](qint64 t, int s, int v) {
+    vcd.setTime(t);
+    if ( s >= nbIos ) vcd.change(ids.at(s), header.fsms.at(s-nbIos).states.at(v));
+    else if ( header.ioTypes.at(s) == Iov::TyEvent ) vcd.event(ids.at(s));
+    else vcd.change(ids.at(s), v);
+    });
+  if ( ! vcd.close() && ok ) {
+    error = "cannot write file " + vcdFile;
+    return false;
+    }
+  return ok;
+}
+
+QList<QPair<qint64,int>> TraceReplay::changes(int signal)
+{
+  QList<QPair<qint64,int>> r;
+  bool isEvent = signal < header.ioNames.length() && header.ioTypes.at(signal) == Iov::TyEvent;
+  replay([&](qint64 t, int s, int v) {
+    if ( s != signal ) return;
+    if ( ! isEvent && ! r.isEmpty() && r.last().second == v ) return;
+    r.append(QPair<qint64,int>(t, v));
+    });
+  return r;
+}
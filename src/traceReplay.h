@@ -0,0 +1,59 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QList>
+#include <QPair>
+#include <QByteArray>
+#include <QFile>
+#include <functional>
+#include "traceLog.h"
+
+// Replay of a simulation log written by the built-in simulator (see [TraceLog]).
+//
+// Signals are numbered as follows: 0..n-1 for the n IOs, in the order of the header, then n+k for the
+// state of FSM k (the value being the index of the state). Changes are replayed in the order in which the
+// simulator produced them, so that [toVcd] rebuilds the trace it wrote.
+
+class TraceReplay
+{
+public:
+  TraceReplay() { };
+
+  bool open(QString fname); // Reads the header
+  QString getError() const { return error; }
+  const TraceLog::Header& getHeader() const { return header; }
+  int signalOf(QString name) const; // IO name or FSM name (state). -1 if not found
+
+  // Replays the whole log. [change] is called with the date, signal and value of each change (value 1 for
+  // events), [fire] with the date, FSM and transition of each transition taken
+  bool replay(std::function<void(qint64,int,int)> change, std::function<void(qint64,int,int)> fire = nullptr);
+
+  bool toVcd(QString vcdFile, int vcdIntSize = 8, bool vcdCompressed = false);
+  QList<QPair<qint64,int>> changes(int signal); // Successive (date, value) of a signal
+
+private:
+  QString fname;
+  QString error;
+  TraceLog::Header header;
+  qint64 bodyStart;
+  QFile file;
+  QByteArray chunk;   // Read ahead
+  int pos;            // In [chunk]
+
+  bool byte(quint8& b);
+  bool get(quint64& n);
+  bool getInt(int& n);
+  bool getValue(int& v);
+};
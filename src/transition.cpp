@@ -12,6 +12,7 @@
 
 #include "transition.h"
 #include "misc.h"
+#include "globals.h"
 #include <math.h>
 #include <QPen>
 #include <QPainter>
@@ -40,6 +41,8 @@ Transition::Transition(State *_srcState,
     event = _event;
     guards = _guards;
     actions = _actions;
+    touch();
+    heat = -1;
     label = new QGraphicsSimpleTextItem(getLabel(), this);
     label->setFlag(QGraphicsItem::ItemIsSelectable, false);
     setFlag(QGraphicsItem::ItemIsSelectable, true);
@@ -50,6 +53,11 @@ Transition::~Transition()
 {
 }
 
+void Transition::touch()
+{
+  revision = Globals::newRevision();
+}
+
 QString Transition::getLabel()
 {
   QString r = event;
@@ -63,6 +71,16 @@ bool Transition::isInitial()
   return srcState ? srcState->isPseudo() : false;
 }
 
+void Transition::setHeat(double heat, QString info)
+{
+  this->heat = heat;
+  QPen p = pen();
+  p.setWidthF(heat > 0 ? 2 + 4*heat : 2); // Setting the pen also updates the bounding rectangle
+  setPen(p);
+  setToolTip(info);
+  update();
+}
+
 // QRectF Transition::boundingRect() const
 // {
 //     qreal extra = (pen().width() + 20) / 2.0;
@@ -110,10 +128,11 @@ void Transition::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWid
     // qDebug() << "------------- Transition::paint";
     // qDebug() << "Drawing transition between state " << mySrcState->getId() << " and " << myDstState->getId();
 
+    QColor color = isSelected() ? selectedColor : heat < 0 ? unSelectedColor : State::heated(unSelectedColor, heat);
     QPen myPen = pen();
-    myPen.setColor(isSelected() ? selectedColor : unSelectedColor);
+    myPen.setColor(color);
     painter->setPen(myPen);
-    painter->setBrush(isSelected() ? selectedColor : unSelectedColor);
+    painter->setBrush(color);
 
     QPolygonF points; // Drawing points
     double angle=0.0; // Of the last segment; for drawing the arrow head
@@ -46,11 +46,14 @@ public:
     QString getLabel();
     void setSrcState(State *s) { srcState = s; }
     void setDstState(State *s) { dstState = s; }
-    void setEvent(QString s) { event = s; }
-    void setGuards(QStringList ss) { guards = ss; }
-    void setActions(QStringList ss) { actions = ss; }
+    void setEvent(QString s) { if ( s != event ) { event = s; touch(); } }
+    void setGuards(QStringList ss) { if ( ss != guards ) { guards = ss; touch(); } }
+    void setActions(QStringList ss) { if ( ss != actions ) { actions = ss; touch(); } }
+    quint64 getRevision() const { return revision; } // Changed by each modification of the label
     State::Location getLocation() const { return location; }
     bool isInitial();
+    void setHeat(double heat, QString info = QString()); // See [State::setHeat]. Also widens the line
+    double getHeat() const { return heat; }
 
     void updatePosition();
 
@@ -74,5 +77,9 @@ private:
     QPolygonF arrowHead;
     QGraphicsSimpleTextItem *label;
     State::Location location;
+    quint64 revision;
+    double heat;
+
+    void touch();
 };
 
@@ -17,6 +17,9 @@
 #include <QLabel>
 #include <QComboBox>
 #include <QMessageBox>
+#include <QLineEdit>
+#include <QTimer>
+#include <QSet>
 
 #include "globals.h"
 #include "transition.h"
@@ -26,6 +29,9 @@
 #include "transitionActions.h"
 #include "compiler.h"
 #include "fragmentChecker.h"
+#include "fragmentValidator.h"
+
+const int TransitionProperties::validationDelay = 400; // ms
 
 TransitionProperties::TransitionProperties(
   Transition *transition, Automaton *automaton, bool isInitial, QWidget *parent)
@@ -129,6 +135,66 @@ TransitionProperties::TransitionProperties(
 
   this->transition = transition;
   this->automaton = automaton;
+
+  validator = new FragmentValidator(automaton, this);
+  validation_timer = new QTimer(this);
+  validation_timer->setSingleShot(true);
+  validation_timer->setInterval(validationDelay);
+  connect(validation_timer, &QTimer::timeout, this, &TransitionProperties::validate);
+  connect(validator, &FragmentValidator::verdictReady, this, &TransitionProperties::showVerdicts);
+  connect(guards_panel, &DynamicPanel::modified, this, &TransitionProperties::scheduleValidation);
+  connect(actions_panel, &DynamicPanel::modified, this, &TransitionProperties::scheduleValidation);
+  validate();
+}
+
+void TransitionProperties::scheduleValidation()
+{
+  validation_timer->start(); // Restarted at each keystroke
+}
+
+void TransitionProperties::validate()
+{
+  QSet<QString> current;
+  if ( ! transition->isInitial() ) {
+    foreach ( QString guard, guards_panel->retrieve() ) {
+      if ( guard.isEmpty() ) continue;
+      current.insert(FragmentValidator::keyOf("guard", guard));
+      validator->validate("guard", guard);
+      }
+    }
+  foreach ( QString action, actions_panel->retrieve() ) {
+    if ( action.isEmpty() ) continue;
+    current.insert(FragmentValidator::keyOf("action", action));
+    validator->validate("action", action);
+    }
+  validator->cancelAllBut(current);
+  showVerdicts();
+}
+
+void TransitionProperties::showVerdicts()
+{
+  QList<QPair<QString,DynamicPanel*>> panels = { { "guard", guards_panel }, { "action", actions_panel } };
+  for ( const auto& p : panels ) {
+    foreach ( QLineEdit *field, p.second->lineEdits() ) {
+      bool ok;
+      QStringList errors;
+      if ( validator->verdict(p.first, field->text().trimmed(), ok, errors) && ! ok ) 
+        DynamicPanel::markField(field, errors.isEmpty() ? QStringList("rejected by compiler") : errors);
+      else
+        DynamicPanel::markField(field, QStringList()); // Valid or not yet known
+      }
+    }
+}
+
+// Use the verdict computed while editing if available, otherwise check synchronously
+
+bool TransitionProperties::check_fragment(FragmentChecker& checker, QString kind, QString text, QStringList& errors)
+{
+  bool ok;
+  if ( validator->verdict(kind, text, ok, errors) ) return ok;
+  ok = kind == "guard" ? checker.check_guard(text) : checker.check_action(text);
+  errors = checker.getErrors();
+  return ok;
 }
 
 void TransitionProperties::accept()
@@ -157,8 +223,8 @@ void TransitionProperties::accept()
   if ( ! isInitial ) {
     guards = guards_panel->retrieve();
     foreach ( QString guard, guards) {
-      if ( ! checker.check_guard(guard) ) {
-        QStringList errors = checker.getErrors();
+      QStringList errors;
+      if ( ! check_fragment(checker, "guard", guard, errors) ) {
         QMessageBox::warning(this, "", "Illegal guard: \"" + guard + "\"\n" + errors.join("\n"));
         guards_ok = false;
         }
@@ -175,8 +241,8 @@ void TransitionProperties::accept()
   actions = actions_panel->retrieve();
   foreach ( QString action, actions) {
     // First check action is well-formed and typed
-    if ( ! checker.check_action(action) ) {
-      QStringList errors = checker.getErrors();
+    QStringList errors;
+    if ( ! check_fragment(checker, "action", action, errors) ) {
       QMessageBox::warning(this, "", "Illegal action: \"" + action + "\"\n" + errors.join("\n"));
       actions_ok = false;
       continue;
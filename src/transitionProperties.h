@@ -20,6 +20,9 @@ class Automaton;
 class QComboBox;
 class TransitionGuards;
 class TransitionActions;
+class FragmentValidator;
+class FragmentChecker;
+class QTimer;
 
 class TransitionProperties : public QDialog
 {
@@ -38,8 +41,17 @@ private:
   QComboBox* event_field;
   TransitionGuards *guards_panel;
   TransitionActions *actions_panel;
+
+  // Guards and actions are validated in the background while being edited
+  FragmentValidator *validator;
+  QTimer *validation_timer;
+  static const int validationDelay;
+  bool check_fragment(FragmentChecker& checker, QString kind, QString text, QStringList& errors);
     
 protected slots:
   void accept();
   void cancel();
+  void scheduleValidation();
+  void validate();
+  void showVerdicts();
 };
@@ -0,0 +1,115 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "vcdCheckpoints.h"
+#include <QFileInfo>
+#include <QDateTime>
+#include <algorithm>
+
+const int VcdCheckpoints::interval = 1 << 20;
+const quint32 VcdCheckpoints::magic = 0x56434458; // "VCDX"
+const quint32 VcdCheckpoints::version = 1;
+
+// File layout (QDataStream encoding)
+//   magic, version, nbSignals, interval : quint32
+//   VCD file size, VCD file modification date (ms since epoch) : qint64
+//   number of checkpoints : quint32
+//   checkpoints : time, offset : qint64, values : nbSignals x quint64
+
+static const qint64 sizePos = 16; // Position of the VCD file size in the header
+
+QString VcdCheckpoints::fileOf(QString vcdFile)
+{
+  QFileInfo f(vcdFile);
+  return f.path() + "/" + f.completeBaseName() + ".vcdx";
+}
+
+bool VcdCheckpoints::load(QString vcdFile, int nbSignals)
+{
+  checkpoints.clear();
+  QFile f(fileOf(vcdFile));
+  if ( ! f.open(QIODevice::ReadOnly) ) return false;
+  QFileInfo vcd(vcdFile);
+  QDataStream is(&f);
+  quint32 m, v, n, iv, nb;
+  qint64 size, mtime;
+  is >> m >> v >> n >> iv >> size >> mtime >> nb;
+  if ( is.status() != QDataStream::Ok || m != magic || v != version || int(n) != nbSignals
+       || size != vcd.size() || mtime != vcd.lastModified().toMSecsSinceEpoch() )
+    return false;
+  checkpoints.reserve(nb);
+  for ( quint32 i=0; i<nb; i++ ) {
+    Checkpoint c;
+    is >> c.time >> c.offset;
+    c.values.resize(nbSignals);
+    for ( int k=0; k<nbSignals; k++ ) is >> c.values[k];
+    checkpoints.append(c);
+    }
+  if ( is.status() != QDataStream::Ok ) {
+    checkpoints.clear();
+    return false;
+    }
+  return true;
+}
+
+const VcdCheckpoints::Checkpoint* VcdCheckpoints::before(qint64 t) const
+{
+  auto i = std::upper_bound(checkpoints.constBegin(), checkpoints.constEnd(), t,
+                            [](qint64 t, const Checkpoint& c) { return t < c.time; });
+  return i == checkpoints.constBegin() ? NULL : &*(i-1);
+}
+
+bool VcdCheckpoints::save(QString vcdFile, int nbSignals)
+{
+  if ( ! create(vcdFile, nbSignals) ) return false;
+  foreach ( const Checkpoint& c, checkpoints ) append(c.time, c.offset, c.values);
+  return finish();
+}
+
+bool VcdCheckpoints::create(QString vcdFile, int nbSignals)
+{
+  this->vcdFile = vcdFile;
+  file.setFileName(fileOf(vcdFile));
+  if ( ! file.open(QIODevice::WriteOnly | QIODevice::Truncate) ) return false;
+  os.setDevice(&file);
+  count = 0;
+  os << magic << version << quint32(nbSignals) << quint32(interval);
+  os << qint64(-1) << qint64(-1) << count; // Patched by [finish]
+  return true;
+}
+
+void VcdCheckpoints::append(qint64 time, qint64 offset, const QVector<quint64>& values)
+{
+  os << time << offset;
+  foreach ( quint64 v, values ) os << v;
+  count++;
+}
+
+bool VcdCheckpoints::finish()
+{
+  if ( ! file.isOpen() ) return false;
+  // The VCD file must have been closed
+  QFileInfo vcd(vcdFile);
+  file.seek(sizePos);
+  os << qint64(vcd.size()) << qint64(vcd.lastModified().toMSecsSinceEpoch()) << count;
+  bool ok = os.status() == QDataStream::Ok;
+  os.setDevice(NULL);
+  file.close();
+  return ok;
+}
+
+void VcdCheckpoints::discard()
+{
+  if ( ! file.isOpen() ) return;
+  os.setDevice(NULL);
+  file.remove();
+}
@@ -0,0 +1,69 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <QFile>
+#include <QDataStream>
+
+// Sidecar time index (.vcdx file) of a VCD trace, for random access.
+//
+// A checkpoint is recorded about every [interval] bytes of trace. It gives a date, the offset in
+// the VCD file of the line starting this date ("#<date>") and the values of all signals just
+// before this date (in the order of their declaration in the VCD header, see [VcdIndex] for the
+// encoding of values). Seeking to a given date then only requires scanning the trace from the
+// last checkpoint before it.
+//
+// The file records the size and modification date of the VCD file, so that stale indexes are
+// detected. It can be written incrementally (see [create], [append] and [finish]), so that the
+// memory used by the VCD writer does not depend on the length of the trace.
+
+class VcdCheckpoints
+{
+public:
+  struct Checkpoint {
+    qint64 time;
+    qint64 offset;
+    QVector<quint64> values;
+  };
+
+  static const int interval;
+
+  static QString fileOf(QString vcdFile);
+
+  // Reading
+  bool load(QString vcdFile, int nbSignals); // false if there's no index or if it is stale
+  const Checkpoint* before(qint64 t) const;  // Last checkpoint at or before [t] (NULL if none)
+  bool isEmpty() const { return checkpoints.isEmpty(); }
+  const QVector<Checkpoint>& all() const { return checkpoints; }
+
+  // Writing, either all at once ...
+  void add(const Checkpoint& c) { checkpoints.append(c); }
+  bool save(QString vcdFile, int nbSignals);
+  // ... or incrementally
+  bool create(QString vcdFile, int nbSignals);
+  void append(qint64 time, qint64 offset, const QVector<quint64>& values);
+  bool finish();
+  void discard(); // Removes the index being written (the trace could not be completed)
+
+private:
+  QVector<Checkpoint> checkpoints;
+  QString vcdFile;
+  QFile file;
+  QDataStream os;
+  quint32 count;
+
+  static const quint32 magic;
+  static const quint32 version;
+};
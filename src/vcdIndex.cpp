@@ -0,0 +1,303 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "vcdIndex.h"
+#include <QStringList>
+#include <algorithm>
+
+const quint64 VcdIndex::unknown = ~quint64(0);
+
+VcdIndex::VcdIndex()
+{
+  data = NULL;
+  size = 0;
+  bodyStart = 0;
+  endTime = 0;
+  hasSidecar = false;
+  windowed = false;
+  window1 = window2 = pending1 = pending2 = -1;
+}
+
+VcdIndex::~VcdIndex()
+{
+  if ( data ) file.unmap(const_cast<uchar*>(data));
+  file.close();
+}
+
+qint64 VcdIndex::token(qint64 pos, qint64& start) const
+{
+  while ( pos < size && data[pos] <= ' ' ) pos++;
+  start = pos;
+  while ( pos < size && data[pos] > ' ' ) pos++;
+  return pos;
+}
+
+// Declarations
+
+bool VcdIndex::open(QString fname)
+{
+  file.setFileName(fname);
+  if ( ! file.open(QIODevice::ReadOnly) ) {
+    error = "cannot open file " + fname;
+    return false;
+    }
+  size = file.size();
+  data = size > 0 ? file.map(0, size) : NULL;
+  if ( ! data ) {
+    error = "cannot map file " + fname;
+    return false;
+    }
+  QStringList scopes;
+  qint64 pos = 0, start;
+  while ( true ) {
+    pos = token(pos, start);
+    if ( start >= size ) {
+      error = "no $enddefinitions in file " + fname;
+      return false;
+      }
+    QByteArray kw = text(start, pos);
+    QList<QByteArray> args; // Up to the next $end
+    if ( kw.startsWith('$') ) {
+      while ( true ) {
+        pos = token(pos, start);
+        if ( start >= size ) break;
+        QByteArray a = text(start, pos);
+        if ( a == "$end" ) break;
+        args.append(a);
+        }
+      }
+    if ( (kw == "$scope" && args.length() < 2) || (kw == "$upscope" && scopes.isEmpty()) ) {
+      error = "malformed scope declarations in file " + fname;
+      return false;
+      }
+    if ( kw == "$scope" )
+      scopes.append(QString::fromUtf8(args.at(1)));
+    else if ( kw == "$upscope" )
+      scopes.removeLast();
+    else if ( kw == "$timescale" )
+      timescale = QString::fromUtf8(args.join(""));
+    else if ( kw == "$var" && args.length() >= 4 ) {
+      Signal s;
+      QByteArray type = args.at(0);
+      s.width = args.at(1).toInt();
+      s.code = args.at(2);
+      s.name = QString::fromUtf8(args.at(3));
+      s.scope = scopes.join(".");
+      if ( type == "event" ) s.kind = Event;
+      else if ( type == "string" ) s.kind = String;
+      else if ( type == "real" || type == "realtime" ) s.kind = Real;
+      else s.kind = s.width > 1 ? Vector : Scalar;
+      codes[s.code].append(signals_.size());
+      signals_.append(s);
+      }
+    else if ( kw == "$enddefinitions" ) {
+      bodyStart = pos;
+      hasSidecar = checkpoints.load(fname, signals_.size());
+      return true;
+      }
+    }
+}
+
+int VcdIndex::find(QString path) const
+{
+  for ( int i=0; i<signals_.size(); i++ )
+    if ( signals_.at(i).scope + "." + signals_.at(i).name == path ) return i;
+  return -1;
+}
+
+// Value changes
+
+template<class T, class C> bool VcdIndex::scan(qint64 pos, T onTime, C onChange, QAtomicInt *abort, QAtomicInt *progress) const
+{
+  static const qint64 chunk = 1 << 20; // For progress reporting
+  qint64 start, next = pos + chunk;
+  while ( true ) {
+    pos = token(pos, start);
+    if ( start >= size ) break;
+    if ( pos >= next ) {
+      if ( abort && abort->loadAcquire() ) return false;
+      if ( progress ) progress->storeRelease(int(pos * 1000 / size));
+      next = pos + chunk;
+      }
+    uchar c = data[start];
+    switch ( c ) {
+    case '#': {
+      qint64 t = 0;
+      for ( qint64 i=start+1; i<pos; i++ ) t = t * 10 + (data[i] - '0');
+      if ( ! onTime(t, start) ) return true;
+      break;
+      }
+    case '$':
+      if ( text(start, pos) == "$comment" ) { // Skipped up to $end
+        do pos = token(pos, start); while ( start < size && text(start, pos) != "$end" );
+        }
+      break; // Other keywords ($dumpvars, $end, ...) are ignored
+    case 'b': case 'B': {
+      quint64 v = 0;
+      for ( qint64 i=start+1; i<pos; i++ ) {
+        if ( data[i] != '0' && data[i] != '1' ) { v = unknown; break; }
+        v = (v << 1) | (data[i] - '0');
+        }
+      pos = token(pos, start);
+      onChange(text(start, pos), v);
+      break;
+      }
+    case 'r': case 'R':
+    case 's': case 'S': {
+      quint64 v = quint64(start+1);
+      pos = token(pos, start);
+      onChange(text(start, pos), v);
+      break;
+      }
+    case '0': case '1':
+      onChange(text(start+1, pos), quint64(c - '0'));
+      break;
+    case 'x': case 'X': case 'z': case 'Z':
+      onChange(text(start+1, pos), unknown);
+      break;
+    default:
+      break;
+    }
+    }
+  return true;
+}
+
+bool VcdIndex::build(QAtomicInt *abort, QAtomicInt *progress)
+{
+  if ( hasSidecar && ! checkpoints.isEmpty() ) {
+    // Windowed index: only the end date is needed here
+    qint64 t = checkpoints.all().last().time;
+    scan(checkpoints.all().last().offset, [&](qint64 date, qint64) { t = date; return true; }, [](const QByteArray&, quint64) { });
+    endTime = t;
+    windowed = true;
+    if ( progress ) progress->storeRelease(1000);
+    return true;
+    }
+  // Checkpoints are recorded during the scan if they could not be read from the sidecar file
+  bool recording = ! hasSidecar;
+  QVector<quint64> current(signals_.size(), unknown);
+  qint64 t = 0, last = bodyStart;
+  auto onTime = [&](qint64 date, qint64 offset) {
+    if ( recording && offset - last >= VcdCheckpoints::interval ) {
+      checkpoints.add({ date, offset, current });
+      last = offset;
+      }
+    t = date;
+    return true;
+  };
+  auto onChange = [&](const QByteArray& code, quint64 value) {
+    auto i = codes.constFind(code);
+    if ( i == codes.constEnd() ) return;
+    foreach ( int k, i.value() ) {
+      Signal& s = signals_[k];
+      current[k] = value;
+      if ( ! s.times.isEmpty() && s.times.last() == t ) s.values.last() = value; // Last value at a given date wins
+      else {
+        s.times.append(t);
+        s.values.append(value);
+        }
+      }
+  };
+  if ( ! scan(bodyStart, onTime, onChange, abort, progress) ) return false;
+  endTime = t;
+  for ( const Signal& s : signals_ )
+    if ( ! s.times.isEmpty() && s.times.last() > endTime ) endTime = s.times.last();
+  if ( recording ) hasSidecar = checkpoints.save(file.fileName(), signals_.size()); // Failure is not an error (read-only directory, ...)
+  if ( progress ) progress->storeRelease(1000);
+  return true;
+}
+
+// Windowed index, using the checkpoints
+
+bool VcdIndex::loadWindow(qint64 t1, qint64 t2, QAtomicInt *abort)
+{
+  int n = signals_.size();
+  pendingTimes = QVector<QVector<qint64>>(n);
+  pendingValues = QVector<QVector<quint64>>(n);
+  const VcdCheckpoints::Checkpoint *c = checkpoints.before(t1);
+  qint64 t = 0;
+  if ( c ) {
+    // Values just before the date of the checkpoint (events have no lasting value)
+    t = c->time;
+    for ( int k=0; k<n; k++ ) {
+      if ( signals_.at(k).kind == Event || c->values.at(k) == unknown ) continue;
+      pendingTimes[k].append(c->time - 1);
+      pendingValues[k].append(c->values.at(k));
+      }
+    }
+  auto onTime = [&](qint64 date, qint64) {
+    t = date;
+    return date <= t2;
+  };
+  auto onChange = [&](const QByteArray& code, quint64 value) {
+    auto i = codes.constFind(code);
+    if ( i == codes.constEnd() ) return;
+    foreach ( int k, i.value() ) {
+      QVector<qint64>& times = pendingTimes[k];
+      if ( ! times.isEmpty() && times.last() == t ) pendingValues[k].last() = value;
+      else {
+        times.append(t);
+        pendingValues[k].append(value);
+        }
+      }
+  };
+  if ( ! scan(c ? c->offset : bodyStart, onTime, onChange, abort) ) return false;
+  pending1 = t1;
+  pending2 = t2;
+  return true;
+}
+
+void VcdIndex::commitWindow()
+{
+  for ( int k=0; k<signals_.size() && k<pendingTimes.size(); k++ ) {
+    signals_[k].times.swap(pendingTimes[k]);
+    signals_[k].values.swap(pendingValues[k]);
+    }
+  pendingTimes.clear();
+  pendingValues.clear();
+  window1 = pending1;
+  window2 = pending2;
+}
+
+qint64 VcdIndex::dateAfter(qint64 bytes) const
+{
+  foreach ( const VcdCheckpoints::Checkpoint& c, checkpoints.all() )
+    if ( c.offset - bodyStart >= bytes ) return c.time;
+  return endTime;
+}
+
+// Queries
+
+int VcdIndex::changeAt(const Signal& s, qint64 t) const
+{
+  auto i = std::upper_bound(s.times.constBegin(), s.times.constEnd(), t);
+  return int(i - s.times.constBegin()) - 1;
+}
+
+QString VcdIndex::valueText(const Signal& s, int i) const
+{
+  if ( i < 0 || i >= s.values.size() ) return "";
+  quint64 v = s.values.at(i);
+  switch ( s.kind ) {
+  case String:
+  case Real: {
+    qint64 start = qint64(v), end = start;
+    while ( end < size && data[end] > ' ' ) end++;
+    return QString::fromUtf8(text(start, end));
+    }
+  default:
+    if ( v == unknown ) return "x";
+    if ( s.kind == Vector && s.width < 64 && (v >> (s.width-1)) & 1 ) // Signed
+      return QString::number(qint64(v) - (qint64(1) << s.width));
+    return QString::number(v);
+  }
+}
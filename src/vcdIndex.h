@@ -0,0 +1,95 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QList>
+#include <QFile>
+#include <QAtomicInt>
+#include "vcdCheckpoints.h"
+
+// Per-signal time index of a VCD file, used by the waveform viewer.
+//
+// The file is memory-mapped. [open] reads the declarations, [build] scans the value changes and
+// records, for each signal, the dates and values of its changes. [build] can be run in a
+// background thread; it then reports its progress (per mille) and can be aborted.
+// For string and real signals, the recorded value is the offset of its text in the file.
+//
+// When an up-to-date sidecar index (see [VcdCheckpoints]) with at least one checkpoint exists, the
+// index is windowed: [build] only reads the end date (from the last checkpoint), and the changes are
+// recorded for a time window at a time, by [loadWindow], which scans from the closest checkpoint
+// before it. Otherwise the sidecar index is written by [build].
+
+class VcdIndex
+{
+public:
+  enum Kind { Scalar, Vector, Event, String, Real };
+  struct Signal {
+    QString scope;            // Dot-separated path
+    QString name;
+    QByteArray code;
+    Kind kind;
+    int width;
+    QVector<qint64> times;    // Dates of the changes, increasing
+    QVector<quint64> values;  // Corresponding values
+  };
+  static const quint64 unknown; // For x and z values
+
+  VcdIndex();
+  ~VcdIndex();
+
+  bool open(QString fname);
+  bool build(QAtomicInt *abort = NULL, QAtomicInt *progress = NULL);
+  QString getError() const { return error; }
+
+  const QVector<Signal>& getSignals() const { return signals_; }
+  int find(QString path) const; // "scope.name". -1 if not found
+  qint64 getEndTime() const { return endTime; }
+  qint64 getBodyStart() const { return bodyStart; } // Offset of the value changes
+  QString getTimescale() const { return timescale; }
+
+  int changeAt(const Signal& s, qint64 t) const;       // Index of the last change at or before [t] (-1 if none)
+  QString valueText(const Signal& s, int i) const;     // Text of the [i]th value, for display
+
+  // Windowed index
+  bool isWindowed() const { return windowed; }
+  bool covers(qint64 t1, qint64 t2) const { return ! windowed || (t1 >= window1 && t2 <= window2); }
+  bool loadWindow(qint64 t1, qint64 t2, QAtomicInt *abort = NULL); // Can run in a background thread
+  void commitWindow(); // Makes the window read by [loadWindow] the current one (in the thread reading the signals)
+  qint64 dateAfter(qint64 bytes) const; // Date of the first checkpoint beyond [bytes] bytes of changes (end date if none)
+
+private:
+  QFile file;
+  const uchar *data;
+  qint64 size;
+  qint64 bodyStart;
+  QVector<Signal> signals_;
+  QHash<QByteArray,QList<int>> codes; // Several variables may share a code
+  qint64 endTime;
+  QString timescale;
+  QString error;
+  VcdCheckpoints checkpoints;
+  bool hasSidecar; // Checkpoints read from an up-to-date sidecar file
+  bool windowed;
+  qint64 window1, window2; // Current window (changes of the signals)
+  qint64 pending1, pending2; // Window read by [loadWindow]
+  QVector<QVector<qint64>> pendingTimes;
+  QVector<QVector<quint64>> pendingValues;
+
+  qint64 token(qint64 pos, qint64& start) const; // Returns the end of the token starting at or after [pos]
+  QByteArray text(qint64 start, qint64 end) const { return QByteArray((const char*)data + start, int(end - start)); }
+  template<class T, class C> bool scan(qint64 pos, T onTime, C onChange, QAtomicInt *abort = NULL, QAtomicInt *progress = NULL) const;
+};
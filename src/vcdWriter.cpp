@@ -0,0 +1,284 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "vcdWriter.h"
+#include "vcdIndex.h"
+#include "globals.h"
+#include <QDateTime>
+#include <QMap>
+
+const int VcdWriter::bufferSize = 1 << 20;
+
+VcdWriter::VcdWriter(int intSize, bool compressed)
+{
+  this->intSize = intSize < 1 ? 1 : intSize > 32 ? 32 : intSize;
+  this->compressed = compressed && compressionAvailable();
+  this->time = 0;
+  this->written = 0;
+  this->failed = false;
+  this->indexed = false;
+  this->lastCheckpoint = 0;
+#ifdef USE_ZLIB
+  this->gz = NULL;
+#endif
+}
+
+bool VcdWriter::compressionAvailable()
+{
+#ifdef USE_ZLIB
+  return true;
+#else
+  return false;
+#endif
+}
+
+QString VcdWriter::codeOf(int index)
+{
+  // Identifier codes are built from the printable ASCII characters ('!' to '~')
+  QString code;
+  do {
+    code += QChar('!' + index % 94);
+    index /= 94;
+    } while ( index > 0 );
+  return code;
+}
+
+int VcdWriter::declare(QString scope, QString name, Kind kind)
+{
+  Signal s;
+  s.scope = scope;
+  s.name = name;
+  s.kind = kind;
+  s.code = codeOf(signals_.size()).toLatin1();
+  s.dirty = false;
+  s.written = false;
+  s.value = 0;
+  s.pending = 0;
+  s.offset = 0;
+  signals_.append(s);
+  return signals_.size()-1;
+}
+
+// Output
+
+void VcdWriter::write(const QByteArray& data)
+{
+  buffer.append(data);
+  if ( buffer.size() >= bufferSize ) flushBuffer();
+}
+
+void VcdWriter::flushBuffer()
+{
+  if ( buffer.isEmpty() ) return;
+#ifdef USE_ZLIB
+  if ( gz && gzwrite(gz, buffer.constData(), buffer.size()) != buffer.size() ) failed = true;
+#endif
+  if ( file.isOpen() && file.write(buffer) != buffer.size() ) failed = true;
+  written += buffer.size();
+  buffer.clear(); // Keeps the allocated capacity
+}
+
+bool VcdWriter::open(QString fname)
+{
+#ifdef USE_ZLIB
+  if ( compressed ) {
+    gz = gzopen(fname.toLocal8Bit().constData(), "wb6");
+    if ( ! gz ) return false;
+    }
+#endif
+  if ( ! compressed ) {
+    file.setFileName(fname);
+    if ( ! file.open(QIODevice::WriteOnly | QIODevice::Truncate) ) return false;
+    }
+  buffer.clear();
+  buffer.reserve(bufferSize + 4096);
+  written = 0;
+  failed = false;
+  order.clear();
+  QString h;
+  h += "$date\n   " + QDateTime::currentDateTime().toString() + "\n$end\n";
+  h += "$version\n   Grasp " + Globals::version + " (native simulator)\n$end\n";
+  h += "$timescale 1ns $end\n";
+  QMap<QString,QList<int>> scopes; // Sorted by scope name
+  for ( int i=0; i<signals_.size(); i++ ) scopes[signals_[i].scope].append(i);
+  for ( auto it = scopes.constBegin(); it != scopes.constEnd(); ++it ) {
+    h += "$scope module " + it.key() + " $end\n";
+    for ( int i : it.value() ) {
+      const Signal& s = signals_.at(i);
+      order.append(i);
+      switch ( s.kind ) {
+      case Event: h += "$var event 1 "; break;
+      case Int: h += "$var wire " + QString::number(intSize) + " "; break;
+      case Bool: h += "$var wire 1 "; break;
+      case String: h += "$var string 1 "; break;
+      }
+      h += QString::fromLatin1(s.code) + " " + s.name + " $end\n";
+      }
+    h += "$upscope $end\n";
+    }
+  h += "$enddefinitions $end\n";
+  write(h.toUtf8());
+  time = 0;
+  dirty.clear();
+  indexed = ! compressed && checkpoints.create(fname, order.size()); // The trace is still written without index
+  lastCheckpoint = written + buffer.size();
+  return true;
+}
+
+// Value changes are recorded and only written when the date changes
+
+void VcdWriter::mark(Signal& s, int index)
+{
+  if ( s.dirty ) return;
+  s.dirty = true;
+  dirty.append(index);
+}
+
+void VcdWriter::setTime(qint64 t)
+{
+  if ( t == time ) return;
+  flushChanges();
+  time = t;
+}
+
+void VcdWriter::change(int signal, int value)
+{
+  Signal& s = signals_[signal];
+  s.pending = value;
+  mark(s, signal);
+}
+
+void VcdWriter::change(int signal, QString value)
+{
+  Signal& s = signals_[signal];
+  s.spending = value.toUtf8();
+  mark(s, signal);
+}
+
+void VcdWriter::event(int signal)
+{
+  mark(signals_[signal], signal);
+}
+
+void VcdWriter::writeBinary(int value)
+{
+  // Truncated to [intSize] bits. Leading zeros can be omitted (VCD left-extends vectors with 0)
+  char bits[40];
+  int n = 0;
+  quint32 v = intSize < 32 ? quint32(value) & ((1u << intSize) - 1) : quint32(value);
+  bits[n++] = 'b';
+  int i = intSize-1;
+  while ( i > 0 && ! ((v >> i) & 1) ) i--;
+  for ( ; i>=0; i-- ) bits[n++] = (v >> i) & 1 ? '1' : '0';
+  bits[n++] = ' ';
+  buffer.append(bits, n);
+}
+
+QVector<quint64> VcdWriter::currentValues() const
+{
+  // Encoded as by [VcdIndex]
+  QVector<quint64> values;
+  foreach ( int i, order ) {
+    const Signal& s = signals_.at(i);
+    quint64 v = VcdIndex::unknown;
+    if ( s.written ) {
+      switch ( s.kind ) {
+      case Event: v = 1; break;
+      case Bool: v = s.value ? 1 : 0; break;
+      case Int: v = intSize < 32 ? quint32(s.value) & ((1u << intSize) - 1) : quint32(s.value); break;
+      case String: v = s.offset; break;
+      }
+      }
+    values.append(v);
+    }
+  return values;
+}
+
+void VcdWriter::flushChanges()
+{
+  bool timeWritten = false;
+  bool checkpoint = indexed && ! dirty.isEmpty() && written + buffer.size() - lastCheckpoint >= VcdCheckpoints::interval;
+  QVector<quint64> values;
+  if ( checkpoint ) values = currentValues(); // Before the changes at this date
+  foreach ( int i, dirty ) {
+    Signal& s = signals_[i];
+    s.dirty = false;
+    switch ( s.kind ) {
+    case Event:
+      break;
+    case String:
+      if ( s.written && s.spending == s.svalue ) continue;
+      s.svalue = s.spending;
+      break;
+    default:
+      if ( s.written && s.pending == s.value ) continue;
+      s.value = s.pending;
+      break;
+    }
+    s.written = true;
+    if ( ! timeWritten ) {
+      if ( checkpoint ) {
+        lastCheckpoint = written + buffer.size();
+        checkpoints.append(time, lastCheckpoint, values);
+        }
+      buffer.append('#');
+      buffer.append(QByteArray::number(time));
+      buffer.append('\n');
+      timeWritten = true;
+      }
+    switch ( s.kind ) {
+    case Event: buffer.append('1'); break;
+    case Bool: buffer.append(s.value ? '1' : '0'); break;
+    case Int: writeBinary(s.value); break;
+    case String:
+      buffer.append('s');
+      s.offset = written + buffer.size();
+      buffer.append(s.svalue);
+      buffer.append(' ');
+      break;
+    }
+    buffer.append(s.code);
+    buffer.append('\n');
+    }
+  dirty.clear();
+  if ( buffer.size() >= bufferSize ) flushBuffer();
+}
+
+bool VcdWriter::close()
+{
+#ifdef USE_ZLIB
+  if ( ! file.isOpen() && ! gz ) return ! failed;
+#else
+  if ( ! file.isOpen() ) return ! failed;
+#endif
+  flushChanges();
+  flushBuffer();
+#ifdef USE_ZLIB
+  if ( gz ) {
+    if ( gzclose(gz) != Z_OK ) failed = true;
+    gz = NULL;
+    return ! failed;
+    }
+#endif
+  file.close();
+  if ( file.error() != QFileDevice::NoError ) failed = true;
+  // The index of a truncated trace would look valid, since it records the size of the file
+  if ( indexed && failed ) checkpoints.discard();
+  else if ( indexed ) checkpoints.finish();
+  indexed = false;
+  return ! failed;
+}
+
+VcdWriter::~VcdWriter()
+{
+  close();
+}
@@ -0,0 +1,91 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QFile>
+#include "vcdCheckpoints.h"
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+
+// VCD trace writer, used by the native simulator.
+// Signals are first declared (scope, name, kind), then value changes are written, with
+// non-decreasing times.
+// The trace is streamed through a fixed-size buffer, so that memory usage does not depend on the
+// length of the simulation. For each date, only the signals whose value actually changed are
+// written (with their last value at this date). Integer values are written on [intSize] bits,
+// without leading zeros. When built with [USE_ZLIB], the trace can be written gzip-compressed.
+// Uncompressed traces get a sidecar time index (see [VcdCheckpoints]).
+
+class VcdWriter
+{
+public:
+  enum Kind { Event, Int, Bool, String };
+
+  VcdWriter(int intSize = 8, bool compressed = false);
+  ~VcdWriter();
+
+  int declare(QString scope, QString name, Kind kind); // Returns the signal index
+  bool open(QString fname); // Writes the header
+  void setTime(qint64 t);
+  void change(int signal, int value); // For Int and Bool signals
+  void change(int signal, QString value); // For String signals
+  void event(int signal);
+  bool close(); // false if the trace could not be completely written
+
+  static QString codeOf(int index);
+  static bool compressionAvailable();
+
+  static const int bufferSize;
+
+private:
+  struct Signal {
+    QString scope;
+    QString name;
+    Kind kind;
+    QByteArray code;
+    bool dirty;         // Changed at the current date
+    bool written;       // A value has already been written
+    int value;          // Last written value
+    int pending;        // Value at the current date
+    QByteArray svalue;  // Idem, for String signals
+    QByteArray spending;
+    quint64 offset;     // Of the last written text, for String signals
+  };
+  QVector<Signal> signals_;
+  QVector<int> dirty;   // Signals changed at the current date
+  int intSize;
+  bool compressed;
+  QFile file;
+#ifdef USE_ZLIB
+  gzFile gz;
+#endif
+  QByteArray buffer;
+  qint64 time;
+  qint64 written;            // Bytes already flushed
+  bool failed;               // A write failed (disk full, ...)
+  VcdCheckpoints checkpoints;
+  bool indexed;
+  qint64 lastCheckpoint;     // Offset
+  QVector<int> order;        // Signals, in the order of declaration in the header
+
+  void mark(Signal& s, int index);
+  void flushChanges();
+  void flushBuffer();
+  void write(const QByteArray& data);
+  void writeBinary(int value);
+  QVector<quint64> currentValues() const;
+};
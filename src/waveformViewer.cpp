@@ -0,0 +1,360 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#include "waveformViewer.h"
+#include <QThread>
+#include <QTimer>
+#include <QPainter>
+#include <QScrollBar>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QFileInfo>
+#include <QFile>
+#include <QtMath>
+#include <cmath>
+#include <functional>
+#include <QDebug>
+#include "qt_compat.h"
+
+const int WaveformViewer::rowHeight = 24;
+const int WaveformViewer::nameWidth = 160;
+const int WaveformViewer::rulerHeight = 20;
+const qint64 WaveformViewer::firstWindow = 16 << 20; // Bytes of changes initially shown for a windowed index
+
+// Background indexing (and reading of windows)
+
+class VcdIndexer : public QThread
+{
+public:
+  VcdIndexer(std::function<bool()> body, QObject *parent) : QThread(parent), ok(false), body(body) { }
+  bool ok;
+protected:
+  void run() override { ok = body(); }
+private:
+  std::function<bool()> body;
+};
+
+WaveformViewer::WaveformViewer(QString fname, QWidget *parent) : QAbstractScrollArea(parent)
+{
+  this->fname = fname;
+  ready = false;
+  t0 = 0;
+  scale = 1.0;
+  cursor = -1;
+  hUnit = 1;
+  viewport()->setBackgroundRole(QPalette::Base);
+  viewport()->setAutoFillBackground(true);
+  indexer = NULL;
+  loader = NULL;
+  timer = new QTimer(this);
+  connect(timer, SIGNAL(timeout()), this, SLOT(showProgress()));
+  if ( ! index.open(fname) ) return; // The error is displayed by [paintEvent]
+  indexer = new VcdIndexer([this]() { return index.build(&abort, &progress); }, this);
+  connect(indexer, SIGNAL(finished()), this, SLOT(indexingDone()));
+  indexer->start();
+  timer->start(200);
+}
+
+WaveformViewer::~WaveformViewer()
+{
+  abort.storeRelease(1);
+  if ( indexer ) indexer->wait();
+  if ( loader ) loader->wait();
+}
+
+void WaveformViewer::showProgress()
+{
+  viewport()->update();
+}
+
+void WaveformViewer::indexingDone()
+{
+  timer->stop();
+  if ( ! static_cast<VcdIndexer*>(indexer)->ok ) return;
+  QFileInfo f(fname);
+  rows = gtkwSignals(f.path() + "/" + f.completeBaseName() + ".gtkw");
+  if ( rows.isEmpty() )
+    for ( int i=0; i<index.getSignals().size(); i++ ) rows.append(i);
+  ready = true;
+  if ( ! index.isWindowed() ) {
+    fitToWindow();
+    return;
+    }
+  // Reading the whole trace would defeat the purpose of the sidecar index: start with its beginning
+  scale = qMax(0.01, double(index.dateAfter(firstWindow)) / waveWidth());
+  t0 = 0;
+  updateScrollBars();
+}
+
+qint64 WaveformViewer::span() const
+{
+  return qint64(waveWidth() * scale);
+}
+
+void WaveformViewer::loadVisible()
+{
+  if ( ! ready || loader || index.covers(t0, t0 + span()) ) return;
+  qint64 t1 = qMax<qint64>(0, t0 - span() / 2), t2 = t0 + span() + span() / 2;
+  loader = new VcdIndexer([this, t1, t2]() { return index.loadWindow(t1, t2, &abort); }, this);
+  connect(loader, SIGNAL(finished()), this, SLOT(windowLoaded()));
+  loader->start();
+}
+
+void WaveformViewer::windowLoaded()
+{
+  if ( static_cast<VcdIndexer*>(loader)->ok ) index.commitWindow();
+  loader->deleteLater();
+  loader = NULL;
+  loadVisible(); // The view may have moved in the meantime
+  viewport()->update();
+}
+
+QList<int> WaveformViewer::gtkwSignals(QString gtkwFile)
+{
+  // Signal lines of gtkwave save files are full paths, possibly followed by a bit range.
+  // Other lines are options ([...]), flags (@...) or comments
+  QList<int> r;
+  QFile file(gtkwFile);
+  if ( ! file.open(QIODevice::ReadOnly | QIODevice::Text) ) return r;
+  while ( ! file.atEnd() ) {
+    QString line = QString::fromUtf8(file.readLine()).trimmed();
+    if ( line.isEmpty() || QString("[@*-#").contains(line.at(0)) ) continue;
+    int b = line.indexOf('[');
+    if ( b > 0 ) line = line.left(b);
+    int i = index.find(line);
+    if ( i >= 0 && ! r.contains(i) ) r.append(i);
+    }
+  return r;
+}
+
+// Geometry
+
+int WaveformViewer::waveWidth() const
+{
+  return qMax(1, viewport()->width() - nameWidth);
+}
+
+double WaveformViewer::xOf(qint64 t) const
+{
+  return nameWidth + (t - t0) / scale;
+}
+
+qint64 WaveformViewer::timeOf(double x) const
+{
+  return t0 + qint64(qFloor((x - nameWidth) * scale));
+}
+
+void WaveformViewer::setStart(qint64 t)
+{
+  t0 = qMax<qint64>(0, qMin(t, index.getEndTime() - span()));
+}
+
+void WaveformViewer::updateScrollBars()
+{
+  qint64 end = index.getEndTime();
+  hUnit = qMax<qint64>(1, end / 1000000000);
+  QScrollBar *h = horizontalScrollBar();
+  h->blockSignals(true); // [t0] is already set
+  h->setRange(0, int(qMax<qint64>(0, end - span()) / hUnit));
+  h->setPageStep(int(qMax<qint64>(1, span() / hUnit)));
+  h->setSingleStep(qMax(1, h->pageStep() / 10));
+  h->setValue(int(t0 / hUnit));
+  h->blockSignals(false);
+  loadVisible();
+  int visible = qMax(1, (viewport()->height() - rulerHeight) / rowHeight);
+  verticalScrollBar()->setRange(0, qMax(0, rows.length() - visible));
+  verticalScrollBar()->setPageStep(visible);
+  viewport()->update();
+}
+
+void WaveformViewer::scrollContentsBy(int dx, int dy)
+{
+  Q_UNUSED(dy);
+  if ( dx != 0 ) t0 = qint64(horizontalScrollBar()->value()) * hUnit;
+  loadVisible();
+  viewport()->update();
+}
+
+void WaveformViewer::resizeEvent(QResizeEvent *event)
+{
+  QAbstractScrollArea::resizeEvent(event);
+  if ( ! ready ) return;
+  setStart(t0);
+  updateScrollBars();
+}
+
+// Zooming
+
+void WaveformViewer::zoom(double factor, int x)
+{
+  if ( ! ready ) return;
+  if ( x < nameWidth ) x = nameWidth + waveWidth() / 2;
+  qint64 t = timeOf(x);
+  double maxScale = qMax(1.0, 2.0 * index.getEndTime() / waveWidth());
+  scale = qBound(0.01, scale / factor, maxScale);
+  setStart(t - qint64((x - nameWidth) * scale));
+  updateScrollBars();
+}
+
+void WaveformViewer::fitToWindow()
+{
+  if ( ! ready ) return;
+  scale = qMax(0.01, double(index.getEndTime()) / waveWidth());
+  t0 = 0;
+  updateScrollBars();
+}
+
+void WaveformViewer::wheelEvent(QWheelEvent *event)
+{
+  if ( event->modifiers() & Qt::ControlModifier ) {
+    zoom(event->angleDelta().y() > 0 ? 1.25 : 0.8, int(WHEEL_EVENT_X(event)));
+    event->accept();
+    }
+  else
+    QAbstractScrollArea::wheelEvent(event);
+}
+
+void WaveformViewer::mousePressEvent(QMouseEvent *event)
+{
+  if ( ! ready ) return;
+  if ( event->button() == Qt::RightButton ) cursor = -1;
+  else if ( event->pos().x() >= nameWidth ) cursor = qMax<qint64>(0, timeOf(event->pos().x()));
+  viewport()->update();
+}
+
+// Drawing
+
+void WaveformViewer::paintEvent(QPaintEvent *event)
+{
+  Q_UNUSED(event);
+  QPainter p(viewport());
+  if ( ! ready ) {
+    QString msg = ! index.getError().isEmpty() ? index.getError()
+                : "Indexing " + QFileInfo(fname).fileName() + " (" + QString::number(progress.loadAcquire() / 10) + "%)";
+    p.drawText(viewport()->rect(), Qt::AlignCenter, msg);
+    return;
+    }
+  drawRuler(p);
+  if ( ! index.covers(t0, t0 + span()) ) {
+    p.drawText(viewport()->rect(), Qt::AlignCenter, "Reading " + QFileInfo(fname).fileName());
+    return;
+    }
+  const QVector<VcdIndex::Signal>& sigs = index.getSignals();
+  int y = rulerHeight;
+  for ( int r=verticalScrollBar()->value(); r<rows.length() && y<viewport()->height(); r++, y+=rowHeight ) {
+    const VcdIndex::Signal& s = sigs.at(rows.at(r));
+    QString label = s.name;
+    if ( cursor >= 0 && s.kind != VcdIndex::Event && index.covers(cursor, cursor) ) label += " = " + index.valueText(s, index.changeAt(s, cursor));
+    p.setPen(palette().color(QPalette::Text));
+    p.drawText(QRect(4, y, nameWidth-8, rowHeight), Qt::AlignVCenter | Qt::AlignLeft, label);
+    p.setClipRect(nameWidth, y, waveWidth(), rowHeight);
+    drawSignal(p, s, y);
+    p.setClipping(false);
+    p.setPen(QColor(230, 230, 230));
+    p.drawLine(0, y + rowHeight - 1, viewport()->width(), y + rowHeight - 1);
+    }
+  p.setPen(Qt::gray);
+  p.drawLine(nameWidth - 1, 0, nameWidth - 1, viewport()->height());
+  if ( cursor >= 0 && xOf(cursor) >= nameWidth ) {
+    p.setPen(Qt::blue);
+    p.drawLine(QPointF(xOf(cursor), rulerHeight), QPointF(xOf(cursor), viewport()->height()));
+    }
+}
+
+void WaveformViewer::drawRuler(QPainter& p)
+{
+  // Ticks every 1, 2 or 5 x 10^n time units, about 100 pixels apart
+  double raw = 100 * scale;
+  double step = qPow(10, qFloor(std::log10(raw)));
+  if ( step * 2 >= raw ) step *= 2;
+  else if ( step * 5 >= raw ) step *= 5;
+  else step *= 10;
+  qint64 st = qMax<qint64>(1, qint64(step));
+  qint64 tR = timeOf(viewport()->width());
+  p.setPen(palette().color(QPalette::Text));
+  for ( qint64 t = (t0 + st - 1) / st * st; t <= tR; t += st ) {
+    double x = xOf(t);
+    p.drawLine(QPointF(x, rulerHeight - 5), QPointF(x, rulerHeight));
+    p.drawText(QPointF(x + 2, rulerHeight - 6), QString::number(t));
+    }
+  QString info = index.getTimescale();
+  if ( cursor >= 0 ) info = "t=" + QString::number(cursor) + " " + info;
+  p.drawText(QRect(4, 0, nameWidth-8, rulerHeight), Qt::AlignVCenter | Qt::AlignLeft, info);
+  p.drawLine(0, rulerHeight, viewport()->width(), rulerHeight);
+}
+
+void WaveformViewer::drawSignal(QPainter& p, const VcdIndex::Signal& s, int y)
+{
+  static const QColor waveColor(0, 128, 0), unknownColor(200, 0, 0), busyColor(0, 160, 0), eventColor(0, 0, 160);
+  const int n = s.times.size();
+  const double top = y + 4, bottom = y + rowHeight - 4, mid = (top + bottom) / 2;
+  const double right = nameWidth + waveWidth();
+  const qint64 tR = timeOf(right);
+  int i = index.changeAt(s, t0);
+  double x = nameWidth;
+  while ( true ) {
+    int j = i + 1;
+    bool last = j >= n || s.times.at(j) > tR;
+    double xe = last ? right : xOf(s.times.at(j));
+    // Segment [x,xe] with value #i
+    if ( i >= 0 ) {
+      quint64 v = s.values.at(i);
+      switch ( s.kind ) {
+      case VcdIndex::Scalar:
+        p.setPen(v == VcdIndex::unknown ? unknownColor : waveColor);
+        p.drawLine(QPointF(x, v == VcdIndex::unknown ? mid : v ? top : bottom), QPointF(xe, v == VcdIndex::unknown ? mid : v ? top : bottom));
+        break;
+      case VcdIndex::Event:
+        p.setPen(eventColor);
+        p.drawLine(QPointF(x, bottom), QPointF(xe, bottom));
+        break;
+      default: {
+        p.setPen(v == VcdIndex::unknown ? unknownColor : waveColor);
+        if ( xe - x < 5 ) {
+          p.fillRect(QRectF(x, top, qMax(1.0, xe - x), bottom - top), busyColor);
+          break;
+          }
+        QPolygonF shape;
+        shape << QPointF(x, mid) << QPointF(x + 2, top) << QPointF(xe - 2, top)
+              << QPointF(xe, mid) << QPointF(xe - 2, bottom) << QPointF(x + 2, bottom);
+        p.drawPolygon(shape);
+        QString txt = index.valueText(s, i);
+        double xt = qMax(x, double(nameWidth)) + 4;
+        if ( p.fontMetrics().boundingRect(txt).width() < xe - xt - 4 ) {
+          p.setPen(palette().color(QPalette::Text));
+          p.drawText(QRectF(xt, top, xe - xt - 4, bottom - top), Qt::AlignVCenter | Qt::AlignLeft, txt);
+          }
+        break;
+        }
+      }
+      }
+    if ( last ) break;
+    // Changes falling in the same pixel column are collapsed
+    double column = qFloor(xe);
+    qint64 tEnd = t0 + qint64(qCeil((column + 1 - nameWidth) * scale));
+    int k = qMax(j, index.changeAt(s, tEnd - 1));
+    if ( k > j )
+      p.fillRect(QRectF(column, top, 1, bottom - top), busyColor);
+    else if ( s.kind == VcdIndex::Scalar ) {
+      p.setPen(waveColor);
+      p.drawLine(QPointF(xe, top), QPointF(xe, bottom));
+      }
+    if ( s.kind == VcdIndex::Event ) {
+      p.setPen(eventColor);
+      p.drawLine(QPointF(xe, top), QPointF(xe, bottom));
+      p.drawLine(QPointF(xe - 3, top + 3), QPointF(xe, top));
+      p.drawLine(QPointF(xe + 3, top + 3), QPointF(xe, top));
+      }
+    i = k;
+    x = k > j ? column + 1 : xe;
+    }
+}
@@ -0,0 +1,88 @@
+/***********************************************************************/
+/*                                                                     */
+/*       This file is part of the Grasp software package               */
+/*                                                                     */
+/*  Copyright (c) 2019-present, Jocelyn SEROT (jocelyn.serot@uca.fr)   */
+/*                       All rights reserved.                          */
+/*                                                                     */
+/*    This source code is licensed under the license found in the      */
+/*      LICENSE file in the root directory of this source tree.        */
+/*                                                                     */
+/***********************************************************************/
+
+#pragma once
+
+#include <QAbstractScrollArea>
+#include <QAtomicInt>
+#include <QList>
+#include "vcdIndex.h"
+
+class QThread;
+class QTimer;
+class QPainter;
+
+// Waveform viewer for VCD files, displayed in the results panel.
+//
+// The file is indexed in a background thread (see [VcdIndex]). When the index is windowed (large
+// traces with a sidecar index), only the visible part of the trace, with a margin of half a screen on
+// each side, is read, also in a background thread, when the view moves out of it. Signals listed in the
+// associated .gtkw file, if any, are displayed in this order; otherwise all signals are.
+// Drawing cost depends on the width of the view, not on the number of changes : changes falling
+// in the same pixel column are collapsed (and shown as a filled bar).
+// Ctrl+wheel zooms around the mouse position; clicking sets a cursor, whose date and the
+// corresponding values are displayed in the names column.
+
+class WaveformViewer : public QAbstractScrollArea
+{
+  Q_OBJECT
+
+public:
+  WaveformViewer(QString fname, QWidget *parent = 0);
+  ~WaveformViewer();
+
+  void zoom(double factor, int x = -1); // Around viewport position [x] (default: center)
+  void fitToWindow();
+
+protected:
+  void paintEvent(QPaintEvent *event) override;
+  void resizeEvent(QResizeEvent *event) override;
+  void wheelEvent(QWheelEvent *event) override;
+  void mousePressEvent(QMouseEvent *event) override;
+  void scrollContentsBy(int dx, int dy) override;
+
+private slots:
+  void indexingDone();
+  void windowLoaded();
+  void showProgress();
+
+private:
+  QString fname;
+  VcdIndex index;
+  QThread *indexer;
+  QThread *loader;  // Of the current window, NULL if none is being read
+  QTimer *timer;
+  QAtomicInt abort;
+  QAtomicInt progress;
+  bool ready;
+  QList<int> rows;  // Displayed signals
+  qint64 t0;        // Date at the left of the wave area
+  double scale;     // Time units per pixel
+  qint64 cursor;    // -1 if not set
+  qint64 hUnit;     // Time units per horizontal scroll bar step
+
+  static const int rowHeight;
+  static const int nameWidth;
+  static const int rulerHeight;
+  static const qint64 firstWindow;
+
+  int waveWidth() const;
+  double xOf(qint64 t) const;
+  qint64 timeOf(double x) const;
+  void setStart(qint64 t);
+  void updateScrollBars();
+  qint64 span() const; // Visible time span
+  void loadVisible();
+  void drawRuler(QPainter& p);
+  void drawSignal(QPainter& p, const VcdIndex::Signal& s, int y);
+  QList<int> gtkwSignals(QString gtkwFile);
+};